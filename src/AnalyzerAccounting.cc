@@ -0,0 +1,60 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek/AnalyzerAccounting.h"
+
+#include <map>
+
+#include "zeek/NetVar.h"
+#include "zeek/telemetry/Manager.h"
+
+namespace zeek::detail
+	{
+
+void AnalyzerAccounting::InitPostScript()
+	{
+	enabled = BifConst::AnalyzerAccounting::enable;
+	sample_rate = BifConst::AnalyzerAccounting::cycles_sample_rate;
+
+	if ( sample_rate == 0 )
+		sample_rate = 1;
+	}
+
+AnalyzerCounters* AnalyzerAccounting::Lookup(const char* kind, const std::string& analyzer)
+	{
+	static std::map<std::string, AnalyzerCounters> counters;
+
+	std::string key = std::string(kind) + '/' + analyzer;
+
+	if ( auto i = counters.find(key); i != counters.end() )
+		return &i->second;
+
+	static auto invocations_family = telemetry_mgr->CounterFamily(
+		"zeek", "analyzer-invocations", {"kind", "analyzer"},
+		"Number of times data was passed to the given analyzer", "1", true);
+	static auto packets_family = telemetry_mgr->CounterFamily(
+		"zeek", "analyzer-packets", {"kind", "analyzer"},
+		"Number of packets passed to the given analyzer", "1", true);
+	static auto bytes_family = telemetry_mgr->CounterFamily(
+		"zeek", "analyzer-bytes", {"kind", "analyzer"},
+		"Number of bytes passed to the given analyzer", "1", true);
+	static auto cycles_family =
+		counts_cycles
+			? telemetry_mgr->CounterFamily(
+				  "zeek", "analyzer-cycles", {"kind", "analyzer"},
+				  "Estimated number of CPU cycles spent in the given analyzer", "1", true)
+			: telemetry_mgr->CounterFamily(
+				  "zeek", "analyzer-ns", {"kind", "analyzer"},
+				  "Estimated number of nanoseconds spent in the given analyzer", "1", true);
+
+	std::initializer_list<telemetry::LabelView> labels = {{"kind", kind},
+	                                                      {"analyzer", analyzer}};
+
+	AnalyzerCounters c{telemetry_mgr->ShardedCounter(invocations_family.GetOrAdd(labels)),
+	                   telemetry_mgr->ShardedCounter(packets_family.GetOrAdd(labels)),
+	                   telemetry_mgr->ShardedCounter(bytes_family.GetOrAdd(labels)),
+	                   telemetry_mgr->ShardedCounter(cycles_family.GetOrAdd(labels))};
+
+	return &counters.emplace(std::move(key), c).first->second;
+	}
+
+	} // namespace zeek::detail
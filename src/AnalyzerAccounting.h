@@ -0,0 +1,180 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Per-analyzer cost accounting.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "zeek/telemetry/Sharded.h"
+
+namespace zeek::detail
+	{
+
+/**
+ * An analyzer's accounting counters.
+ */
+struct AnalyzerCounters
+	{
+	telemetry::ShardedIntCounter invocations;
+	telemetry::ShardedIntCounter packets;
+	telemetry::ShardedIntCounter bytes;
+	telemetry::ShardedIntCounter cycles;
+	};
+
+/**
+ * Counts, for each analyzer, how often it's invoked and how many packets
+ * and bytes it sees, and estimates how many CPU cycles it spends. The
+ * counts are exported as telemetry metrics labeled with the analyzer's
+ * kind ("packet" or "protocol") and name.
+ *
+ * Cycles are read from the CPU's time stamp counter, which only x86 offers.
+ * Elsewhere, nanoseconds of a monotonic clock are counted instead, and
+ * exported as "analyzer-ns" rather than "analyzer-cycles".
+ *
+ * Cycles are only measured for one in AnalyzerAccounting::cycles_sample_rate
+ * packets and scaled up accordingly. An analyzer is charged exclusively: the
+ * cycles spent in the analyzers it passes data to are deducted from its own.
+ */
+class AnalyzerAccounting
+	{
+public:
+	/**
+	 * Reads the script-level options. Accounting stays off until then.
+	 */
+	static void InitPostScript();
+
+	/**
+	 * Returns true if accounting is on.
+	 */
+	static bool Enabled() { return enabled; }
+
+	/**
+	 * True if the cost of an analyzer is measured in CPU cycles, false if
+	 * it's measured in nanoseconds.
+	 */
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+	static constexpr bool counts_cycles = true;
+#else
+	static constexpr bool counts_cycles = false;
+#endif
+
+	/**
+	 * Returns the counters of an analyzer, creating them on first use.
+	 * Callers are expected to cache the result, which remains valid.
+	 *
+	 * @param kind Either "packet" or "protocol".
+	 *
+	 * @param analyzer The analyzer's name.
+	 */
+	static AnalyzerCounters* Lookup(const char* kind, const std::string& analyzer);
+
+	/**
+	 * Marks the processing of a packet, which decides whether cycles are
+	 * measured for it.
+	 */
+	class PacketScope
+		{
+	public:
+		PacketScope()
+			{
+			if ( enabled )
+				sampling = ++packets_seen % sample_rate == 0;
+			}
+
+		~PacketScope() { sampling = false; }
+
+		PacketScope(const PacketScope&) = delete;
+		PacketScope& operator=(const PacketScope&) = delete;
+		};
+
+	/**
+	 * Accounts for the lifetime of one analyzer invocation.
+	 */
+	class Invocation
+		{
+	public:
+		/**
+		 * Constructor.
+		 *
+		 * @param c The analyzer's counters, or null if accounting is off.
+		 *
+		 * @param len The number of bytes passed to the analyzer.
+		 *
+		 * @param packet True if the analyzer is passed a packet, rather
+		 * than a chunk of a stream.
+		 */
+		Invocation(AnalyzerCounters* c, int64_t len, bool packet) : counters(c)
+			{
+			if ( ! counters )
+				return;
+
+			counters->invocations.Inc();
+			counters->bytes.Inc(len);
+
+			if ( packet )
+				counters->packets.Inc();
+
+			if ( sampling )
+				{
+				parent = current;
+				current = this;
+				start = ReadCycles();
+				}
+			}
+
+		~Invocation()
+			{
+			if ( ! counters || current != this )
+				return;
+
+			uint64_t elapsed = ReadCycles() - start;
+			uint64_t own = elapsed > children ? elapsed - children : 0;
+			counters->cycles.Inc(static_cast<int64_t>(own * sample_rate));
+
+			if ( parent )
+				parent->children += elapsed;
+
+			current = parent;
+			}
+
+		Invocation(const Invocation&) = delete;
+		Invocation& operator=(const Invocation&) = delete;
+
+	private:
+		AnalyzerCounters* counters;
+		Invocation* parent = nullptr;
+		uint64_t start = 0;
+		uint64_t children = 0; // Cycles spent in nested invocations.
+		};
+
+private:
+	// Returns the CPU's time stamp counter where there's one, else
+	// nanoseconds of a monotonic clock. See counts_cycles.
+	static uint64_t ReadCycles()
+		{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#else
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				   std::chrono::steady_clock::now().time_since_epoch())
+			.count();
+#endif
+		}
+
+	static inline bool enabled = false;
+	static inline bool sampling = false;
+	static inline uint64_t sample_rate = 1;
+	static inline uint64_t packets_seen = 0;
+	static inline Invocation* current = nullptr;
+	};
+
+	} // namespace zeek::detail
@@ -0,0 +1,34 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek/EventBatch.h"
+
+#include "zeek/analyzer/Analyzer.h"
+
+namespace zeek
+	{
+
+EventBatch::EventBatch(EventHandlerPtr arg_handler, VectorTypePtr arg_type, size_t arg_max_items)
+	: handler(arg_handler), type(std::move(arg_type)), max_items(arg_max_items)
+	{
+	}
+
+bool EventBatch::Add(RecordValPtr item)
+	{
+	if ( ! items )
+		items = make_intrusive<VectorVal>(type);
+
+	items->Append(std::move(item));
+
+	return max_items > 0 && items->Size() >= max_items;
+	}
+
+void EventBatch::Flush(analyzer::Analyzer* a, Args args)
+	{
+	if ( ! items )
+		return;
+
+	args.emplace_back(std::move(items));
+	a->EnqueueConnEvent(handler, std::move(args));
+	}
+
+	} // namespace zeek
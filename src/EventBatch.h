@@ -0,0 +1,80 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#pragma once
+
+#include "zeek/EventHandler.h"
+#include "zeek/Val.h"
+
+namespace zeek
+	{
+
+namespace analyzer
+	{
+class Analyzer;
+	}
+
+/**
+ * Collects items for an event that an analyzer raises once for many items,
+ * rather than once per item. The event's last parameter is a vector of
+ * records, one per item; any parameters before it are the same for all of
+ * the items, such as the connection. This lets scripts process, say, all
+ * the answers of a DNS reply in a single handler invocation.
+ *
+ * Batching is opt-in: a batch only collects items if its event has a
+ * handler. Analyzers keep raising their per-item events as before, so
+ * handlers of those see no change.
+ */
+class EventBatch
+	{
+public:
+	/**
+	 * Constructor.
+	 *
+	 * @param handler The batch event.
+	 *
+	 * @param type The type of the event's last parameter.
+	 *
+	 * @param max_items The largest number of items an event carries. Zero
+	 * means no limit.
+	 */
+	EventBatch(EventHandlerPtr handler, VectorTypePtr type, size_t max_items);
+
+	/**
+	 * @return True if the batch event has a handler, and hence items
+	 * are worth collecting.
+	 */
+	explicit operator bool() const { return static_cast<bool>(handler); }
+
+	/**
+	 * @return The number of items collected since the last flush.
+	 */
+	size_t Size() const { return items ? items->Size() : 0; }
+
+	/**
+	 * Adds an item.
+	 *
+	 * @param item The item's record.
+	 *
+	 * @return True if the batch holds the maximum number of items now, and
+	 * the caller should Flush() it.
+	 */
+	bool Add(RecordValPtr item);
+
+	/**
+	 * Raises the batch event for the items collected so far, if there are
+	 * any, and starts a new batch.
+	 *
+	 * @param a The analyzer raising the event.
+	 *
+	 * @param args The event's arguments other than the items.
+	 */
+	void Flush(analyzer::Analyzer* a, Args args);
+
+private:
+	EventHandlerPtr handler;
+	VectorTypePtr type;
+	size_t max_items;
+	VectorValPtr items;
+	};
+
+	} // namespace zeek
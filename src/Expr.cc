@@ -21,6 +21,7 @@
 #include "zeek/Traverse.h"
 #include "zeek/Trigger.h"
 #include "zeek/Type.h"
+#include "zeek/VectorKernels.h"
 #include "zeek/broker/Data.h"
 #include "zeek/digest.h"
 #include "zeek/module_util.h"
@@ -696,6 +697,34 @@ void UnaryExpr::ExprDescribe(ODesc* d) const
 		}
 	}
 
+// Returns the vector kernel for an expression tag, if there's one.
+static std::optional<VecKernelOp> vec_kernel_op(ExprTag tag)
+	{
+	switch ( tag )
+		{
+		case EXPR_ADD:
+			return VK_ADD;
+		case EXPR_SUB:
+			return VK_SUB;
+		case EXPR_TIMES:
+			return VK_TIMES;
+		case EXPR_LT:
+			return VK_LT;
+		case EXPR_LE:
+			return VK_LE;
+		case EXPR_EQ:
+			return VK_EQ;
+		case EXPR_NE:
+			return VK_NE;
+		case EXPR_GE:
+			return VK_GE;
+		case EXPR_GT:
+			return VK_GT;
+		default:
+			return std::nullopt;
+		}
+	}
+
 ValPtr BinaryExpr::Eval(Frame* f) const
 	{
 	if ( IsError() )
@@ -725,6 +754,10 @@ ValPtr BinaryExpr::Eval(Frame* f) const
 			return nullptr;
 			}
 
+		if ( auto k = vec_kernel_op(Tag()) )
+			if ( auto v_result = vec_kernel(*k, GetType<VectorType>(), v_op1, v_op2) )
+				return v_result;
+
 		auto v_result = make_intrusive<VectorVal>(GetType<VectorType>());
 
 		for ( unsigned int i = 0; i < v_op1->Size(); ++i )
@@ -743,6 +776,14 @@ ValPtr BinaryExpr::Eval(Frame* f) const
 	if ( IsVector(GetType()->Tag()) && (is_vec1 || is_vec2) )
 		{ // fold vector against scalar
 		VectorVal* vv = (is_vec1 ? v1 : v2)->AsVectorVal();
+
+		if ( auto k = vec_kernel_op(Tag()) )
+			{
+			auto scalar = (is_vec1 ? v2 : v1).get();
+			if ( auto v_result = vec_kernel(*k, GetType<VectorType>(), vv, scalar, is_vec2) )
+				return v_result;
+			}
+
 		auto v_result = make_intrusive<VectorVal>(GetType<VectorType>());
 
 		for ( unsigned int i = 0; i < vv->Size(); ++i )
@@ -3016,11 +3057,26 @@ VectorValPtr index_slice(VectorVal* vect, int _first, int _last)
 
 VectorValPtr vector_bool_select(VectorTypePtr vt, const VectorVal* v1, const VectorVal* v2)
 	{
+	if ( ! v1->RawYieldTypes() && ! ZVal::IsManagedType(v1->RawYieldType()) )
+		{
+		// Elements that don't need memory management can be copied
+		// over directly.
+		const auto& vec1 = *v1->RawVec();
+		const auto& mask = *v2->RawVec();
+
+		auto res = new std::vector<std::optional<ZVal>>;
+		for ( size_t i = 0; i < mask.size(); ++i )
+			if ( mask[i] && mask[i]->AsInt() )
+				res->push_back(i < vec1.size() ? vec1[i] : std::nullopt);
+
+		return make_intrusive<VectorVal>(std::move(vt), res);
+		}
+
 	auto v_result = make_intrusive<VectorVal>(std::move(vt));
 
 	for ( unsigned int i = 0; i < v2->Size(); ++i )
-		if ( v2->BoolAt(i) )
-			v_result->Assign(v_result->Size() + 1, v1->ValAt(i));
+		if ( v2->Has(i) && v2->BoolAt(i) )
+			v_result->Assign(v_result->Size(), v1->ValAt(i));
 
 	return v_result;
 	}
@@ -16,10 +16,68 @@ std::vector<zeek::detail::Frame*> g_frame_stack;
 namespace zeek::detail
 	{
 
+// Frames released for reuse, indexed by size.  Script execution is
+// confined to the main thread, so there's no need for locking.  We bound
+// both the sizes we pool and the number of frames per size, so that the
+// pool doesn't retain more than what a reasonably deep call chain needs.
+static std::vector<std::vector<Frame*>> frame_pool;
+constexpr int MAX_POOLED_FRAME_SIZE = 128;
+constexpr size_t MAX_POOLED_FRAMES_PER_SIZE = 32;
+
 Frame::Frame(int arg_size, const ScriptFunc* func, const zeek::Args* fn_args)
 	{
 	size = arg_size;
 	frame = std::make_unique<Element[]>(size);
+	Init(func, fn_args);
+	}
+
+Frame* Frame::Acquire(int size, const ScriptFunc* func, const zeek::Args* fn_args)
+	{
+	if ( size < static_cast<int>(frame_pool.size()) && ! frame_pool[size].empty() )
+		{
+		auto f = frame_pool[size].back();
+		frame_pool[size].pop_back();
+		f->Init(func, fn_args);
+		return f;
+		}
+
+	return new Frame(size, func, fn_args);
+	}
+
+void Frame::Release(Frame* f)
+	{
+	// If somebody else holds a reference then the frame escaped the
+	// call that created it, so it's subject to regular reference
+	// counting.
+	if ( f->RefCnt() > 1 || f->size > MAX_POOLED_FRAME_SIZE )
+		{
+		Unref(f);
+		return;
+		}
+
+	if ( f->size >= static_cast<int>(frame_pool.size()) )
+		frame_pool.resize(f->size + 1);
+
+	auto& pool = frame_pool[f->size];
+
+	if ( pool.size() >= MAX_POOLED_FRAMES_PER_SIZE )
+		{
+		Unref(f);
+		return;
+		}
+
+	// Don't keep the frame's values (or its trigger) alive while
+	// it sits in the pool.
+	for ( int i = 0; i < f->size; ++i )
+		f->frame[i] = nullptr;
+
+	f->trigger = nullptr;
+
+	pool.push_back(f);
+	}
+
+void Frame::Init(const ScriptFunc* func, const zeek::Args* fn_args)
+	{
 	function = func;
 	func_args = fn_args;
 
@@ -28,6 +86,7 @@ Frame::Frame(int arg_size, const ScriptFunc* func, const zeek::Args* fn_args)
 	break_on_return = false;
 
 	call = nullptr;
+	assoc = nullptr;
 	delayed = false;
 
 	// We could Ref()/Unref() the captures frame, but there's really
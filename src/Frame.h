@@ -53,6 +53,29 @@ public:
 	 */
 	Frame(int size, const ScriptFunc* func, const zeek::Args* fn_args);
 
+	/**
+	 * Returns a frame as the constructor would, but reusing one
+	 * previously handed to Release(), if one of the right size is
+	 * available. This avoids allocating a frame (and its values
+	 * array) for every script function call.
+	 *
+	 * @param the size of the frame
+	 * @param func the function that is creating this frame
+	 * @param fn_args the arguments being passed to that function.
+	 * @return the frame, with a reference count of 1.
+	 */
+	static Frame* Acquire(int size, const ScriptFunc* func, const zeek::Args* fn_args);
+
+	/**
+	 * Gives up the reference to a frame obtained from Acquire(). If no
+	 * other references to the frame remain, its values are cleared and
+	 * it's kept for reuse by a later Acquire(); otherwise, this is the
+	 * same as Unref().
+	 *
+	 * @param f the frame to release.
+	 */
+	static void Release(Frame* f);
+
 	/**
 	 * @param n the index to get.
 	 * @return the value at index *n* of the underlying array.
@@ -215,6 +238,9 @@ private:
 
 	const ValPtr& GetElementByID(const ID* id) const;
 
+	// Initializes everything but the values, for a new or reused frame.
+	void Init(const ScriptFunc* func, const zeek::Args* fn_args);
+
 	/** The number of vals that can be stored in this frame. */
 	int size;
 
@@ -255,6 +281,14 @@ private:
 	const void* assoc = nullptr;
 	};
 
+// Holds a frame obtained from Frame::Acquire(), releasing it when done.
+struct FrameReleaser
+	{
+	void operator()(Frame* f) const { Frame::Release(f); }
+	};
+
+using PooledFramePtr = std::unique_ptr<Frame, FrameReleaser>;
+
 	} // namespace detail
 	} // namespace zeek
 
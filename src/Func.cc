@@ -349,7 +349,7 @@ ValPtr ScriptFunc::Invoke(zeek::Args* args, Frame* parent) const
 		return Flavor() == FUNC_FLAVOR_HOOK ? val_mgr->True() : nullptr;
 		}
 
-	auto f = make_intrusive<Frame>(frame_size, this, args);
+	PooledFramePtr f{Frame::Acquire(frame_size, this, args)};
 
 	// Hand down any trigger.
 	if ( parent )
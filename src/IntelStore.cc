@@ -0,0 +1,541 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek/IntelStore.h"
+
+#include <cinttypes>
+#include <cstring>
+#include <utility>
+
+#include "zeek/Desc.h"
+#include "zeek/Hash.h"
+#include "zeek/Reporter.h"
+#include "zeek/Val.h"
+
+namespace zeek::detail
+	{
+
+IntelStore::IntelStore(bool arg_keep_metadata) : keep_metadata(arg_keep_metadata)
+	{
+	subnets.SetDeleteFunction([](void* p) { delete static_cast<SubnetEntry*>(p); });
+	}
+
+IntelStore::~IntelStore() = default;
+
+std::string IntelStore::EncodeKey(const Indicator& ind)
+	{
+	std::string key;
+
+	if ( ind.kind == Indicator::ADDR )
+		{
+		uint32_t bytes[4];
+		ind.net.Prefix().CopyIPv6(bytes);
+		key.reserve(1 + sizeof(bytes));
+		key.push_back('A');
+		key.append(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+		}
+	else
+		{
+		key.reserve(1 + sizeof(ind.type) + ind.str.size());
+		key.push_back('S');
+		key.append(reinterpret_cast<const char*>(&ind.type), sizeof(ind.type));
+		key.append(ind.str);
+		}
+
+	return key;
+	}
+
+IntelStore::Indicator IntelStore::DecodeKey(std::string_view key)
+	{
+	Indicator ind;
+
+	if ( key[0] == 'A' )
+		{
+		in6_addr in6;
+		memcpy(&in6, key.data() + 1, sizeof(in6));
+		ind.kind = Indicator::ADDR;
+		ind.net = IPPrefix(IPAddr(in6), 128, true);
+		}
+	else
+		{
+		ind.kind = Indicator::STRING;
+		memcpy(&ind.type, key.data() + 1, sizeof(ind.type));
+		ind.str = key.substr(1 + sizeof(ind.type));
+		}
+
+	return ind;
+	}
+
+std::string_view IntelStore::KeyAt(uint32_t offset) const
+	{
+	uint32_t len;
+	memcpy(&len, keys.data() + offset, sizeof(len));
+	return {keys.data() + offset + sizeof(len), len};
+	}
+
+const IntelStore::Slot* IntelStore::FindSlot(std::string_view key, uint64_t hash) const
+	{
+	if ( slots.empty() )
+		return nullptr;
+
+	size_t mask = slots.size() - 1;
+
+	for ( size_t i = hash & mask;; i = (i + 1) & mask )
+		{
+		const Slot& s = slots[i];
+
+		if ( s.key == SLOT_EMPTY )
+			return nullptr;
+
+		if ( s.key != SLOT_DELETED && s.hash == hash && KeyAt(s.key) == key )
+			return &s;
+		}
+	}
+
+IntelStore::Slot* IntelStore::FindSlot(std::string_view key, uint64_t hash)
+	{
+	return const_cast<Slot*>(static_cast<const IntelStore*>(this)->FindSlot(key, hash));
+	}
+
+IntelStore::Slot* IntelStore::AddSlot(std::string_view key, uint64_t hash, bool* added)
+	{
+	*added = false;
+
+	if ( auto s = FindSlot(key, hash) )
+		return s;
+
+	// Key offsets must stay below the slot markers. Once the buffer
+	// reaches them, dropping the keys of deleted slots may make room.
+	if ( keys.size() >= SLOT_DELETED && num_used > num_entries )
+		Rehash(slots.size());
+
+	if ( keys.size() >= SLOT_DELETED )
+		{
+		reporter->Error("Intel store exceeds %" PRIu32 " bytes of indicators, not adding more",
+		                SLOT_DELETED);
+		return nullptr;
+		}
+
+	// Keep the load, deleted slots included, below 3/4. If deletions
+	// caused most of it, rehashing at the same size is enough.
+	if ( (num_used + 1) * 4 > slots.size() * 3 )
+		{
+		size_t capacity = slots.empty() ? 16 : slots.size();
+
+		while ( (num_entries + 1) * 2 > capacity )
+			capacity *= 2;
+
+		Rehash(capacity);
+		}
+
+	size_t mask = slots.size() - 1;
+	size_t i = hash & mask;
+
+	while ( slots[i].key != SLOT_EMPTY && slots[i].key != SLOT_DELETED )
+		i = (i + 1) & mask;
+
+	Slot& s = slots[i];
+
+	if ( s.key == SLOT_EMPTY )
+		++num_used;
+
+	uint32_t len = key.size();
+	s.hash = hash;
+	s.key = keys.size();
+	s.metas = NO_META;
+	keys.append(reinterpret_cast<const char*>(&len), sizeof(len));
+	keys.append(key);
+
+	++num_entries;
+	*added = true;
+	return &s;
+	}
+
+void IntelStore::RemoveSlot(Slot* s)
+	{
+	// The key's bytes stay in the buffer until the next rehash.
+	s->key = SLOT_DELETED;
+	s->metas = NO_META;
+	--num_entries;
+	}
+
+void IntelStore::Rehash(size_t capacity)
+	{
+	// Only live keys move to the new buffer.
+	auto old_slots = std::exchange(slots, std::vector<Slot>(capacity, {0, SLOT_EMPTY, NO_META}));
+	auto old_keys = std::exchange(keys, std::string());
+
+	size_t mask = capacity - 1;
+
+	for ( const auto& o : old_slots )
+		{
+		if ( o.key == SLOT_EMPTY || o.key == SLOT_DELETED )
+			continue;
+
+		size_t i = o.hash & mask;
+
+		while ( slots[i].key != SLOT_EMPTY )
+			i = (i + 1) & mask;
+
+		uint32_t len;
+		memcpy(&len, old_keys.data() + o.key, sizeof(len));
+
+		slots[i] = {o.hash, static_cast<uint32_t>(keys.size()), o.metas};
+		keys.append(old_keys, o.key, sizeof(len) + len);
+		}
+
+	num_used = num_entries;
+	}
+
+IntelStore::SubnetEntry* IntelStore::FindSubnet(const IPPrefix& prefix) const
+	{
+	return static_cast<SubnetEntry*>(
+		subnets.Lookup(prefix.Prefix(), prefix.LengthIPv6(), true));
+	}
+
+uint32_t IntelStore::Intern(const RecordValPtr& meta)
+	{
+	ODesc d;
+	meta->Describe(&d);
+	auto hash = KeyedHash::Hash64(d.Bytes(), d.Len());
+
+	// Identical records share their entry. Compare the descriptions to
+	// rule out hash collisions.
+	auto range = meta_index.equal_range(hash);
+
+	for ( auto i = range.first; i != range.second; ++i )
+		{
+		auto& m = metas[i->second];
+		ODesc md;
+		m.rec->Describe(&md);
+
+		if ( md.Len() == d.Len() && memcmp(md.Bytes(), d.Bytes(), d.Len()) == 0 )
+			{
+			++m.refs;
+			return i->second;
+			}
+		}
+
+	std::string source;
+
+	if ( auto s = meta->GetField("source") )
+		source = s->AsStringVal()->ToStdString();
+
+	auto src = source_ids.emplace(std::move(source), source_ids.size()).first->second;
+
+	uint32_t id;
+
+	if ( free_metas.empty() )
+		{
+		id = metas.size();
+		metas.emplace_back();
+		}
+	else
+		{
+		id = free_metas.back();
+		free_metas.pop_back();
+		}
+
+	// Keep a copy so that scripts changing their record later don't
+	// affect the store.
+	metas[id] = {cast_intrusive<RecordVal>(meta->Clone()), hash, src, 1};
+	meta_index.emplace(hash, id);
+	return id;
+	}
+
+void IntelStore::Unref(uint32_t id)
+	{
+	auto& m = metas[id];
+
+	if ( --m.refs > 0 )
+		return;
+
+	auto range = meta_index.equal_range(m.hash);
+
+	for ( auto i = range.first; i != range.second; ++i )
+		{
+		if ( i->second == id )
+			{
+			meta_index.erase(i);
+			break;
+			}
+		}
+
+	m.rec = nullptr;
+	free_metas.push_back(id);
+	}
+
+IntelStore::MetaRef IntelStore::AddMeta(MetaRef ref, uint32_t id)
+	{
+	if ( ref == NO_META )
+		return id;
+
+	auto source = metas[id].source;
+
+	if ( ! (ref & LIST_BIT) )
+		{
+		if ( metas[ref].source == source )
+			{
+			Unref(ref);
+			return id;
+			}
+
+		uint32_t idx;
+
+		if ( free_meta_lists.empty() )
+			{
+			idx = meta_lists.size();
+			meta_lists.emplace_back();
+			}
+		else
+			{
+			idx = free_meta_lists.back();
+			free_meta_lists.pop_back();
+			}
+
+		meta_lists[idx] = {ref, id};
+		return LIST_BIT | idx;
+		}
+
+	auto& l = meta_lists[ref & ~LIST_BIT];
+
+	for ( auto& m : l )
+		{
+		if ( metas[m].source == source )
+			{
+			Unref(m);
+			m = id;
+			return ref;
+			}
+		}
+
+	l.push_back(id);
+	return ref;
+	}
+
+IntelStore::MetaRef IntelStore::RemoveMeta(MetaRef ref, const std::string& source)
+	{
+	auto src = source_ids.find(source);
+
+	if ( ref == NO_META || src == source_ids.end() )
+		return ref;
+
+	if ( ! (ref & LIST_BIT) )
+		{
+		if ( metas[ref].source != src->second )
+			return ref;
+
+		Unref(ref);
+		return NO_META;
+		}
+
+	auto idx = ref & ~LIST_BIT;
+	auto& l = meta_lists[idx];
+
+	for ( auto i = l.begin(); i != l.end(); ++i )
+		{
+		if ( metas[*i].source == src->second )
+			{
+			Unref(*i);
+			l.erase(i);
+			break;
+			}
+		}
+
+	if ( l.size() > 1 )
+		return ref;
+
+	// Back to a single record, or none.
+	MetaRef rval = l.empty() ? NO_META : l[0];
+	l = {};
+	free_meta_lists.push_back(idx);
+	return rval;
+	}
+
+void IntelStore::ReleaseMetas(MetaRef ref)
+	{
+	if ( ref == NO_META )
+		return;
+
+	if ( ! (ref & LIST_BIT) )
+		{
+		Unref(ref);
+		return;
+		}
+
+	auto idx = ref & ~LIST_BIT;
+
+	for ( auto m : meta_lists[idx] )
+		Unref(m);
+
+	meta_lists[idx] = {};
+	free_meta_lists.push_back(idx);
+	}
+
+std::vector<RecordValPtr> IntelStore::CopyMetas(MetaRef ref) const
+	{
+	std::vector<RecordValPtr> rval;
+
+	if ( ref == NO_META )
+		return rval;
+
+	if ( ! (ref & LIST_BIT) )
+		{
+		rval.emplace_back(cast_intrusive<RecordVal>(metas[ref].rec->Clone()));
+		return rval;
+		}
+
+	for ( auto m : meta_lists[ref & ~LIST_BIT] )
+		rval.emplace_back(cast_intrusive<RecordVal>(metas[m].rec->Clone()));
+
+	return rval;
+	}
+
+bool IntelStore::Insert(const Indicator& ind, const RecordValPtr& meta)
+	{
+	auto id = (keep_metadata && meta) ? Intern(meta) : NO_META;
+
+	if ( ind.kind == Indicator::SUBNET )
+		{
+		auto e = FindSubnet(ind.net);
+		bool added = ! e;
+
+		if ( added )
+			{
+			e = new SubnetEntry{ind.net, NO_META};
+			subnets.Insert(ind.net.Prefix(), ind.net.LengthIPv6(), e);
+			++num_subnets;
+			}
+
+		if ( id != NO_META )
+			e->metas = AddMeta(e->metas, id);
+
+		return added;
+		}
+
+	auto key = EncodeKey(ind);
+	bool added;
+	auto s = AddSlot(key, KeyedHash::Hash64(key.data(), key.size()), &added);
+
+	if ( ! s )
+		{
+		if ( id != NO_META )
+			Unref(id);
+
+		return false;
+		}
+
+	if ( id != NO_META )
+		s->metas = AddMeta(s->metas, id);
+
+	return added;
+	}
+
+bool IntelStore::Remove(const Indicator& ind, const std::string& source, bool purge)
+	{
+	if ( ind.kind == Indicator::SUBNET )
+		{
+		auto e = FindSubnet(ind.net);
+
+		if ( ! e )
+			return false;
+
+		if ( purge || ! keep_metadata )
+			ReleaseMetas(e->metas);
+		else
+			e->metas = RemoveMeta(e->metas, source);
+
+		if ( keep_metadata && ! purge && e->metas != NO_META )
+			return false;
+
+		subnets.Remove(ind.net.Prefix(), ind.net.LengthIPv6());
+		delete e;
+		--num_subnets;
+		return true;
+		}
+
+	auto key = EncodeKey(ind);
+	auto s = FindSlot(key, KeyedHash::Hash64(key.data(), key.size()));
+
+	if ( ! s )
+		return false;
+
+	if ( purge || ! keep_metadata )
+		ReleaseMetas(s->metas);
+	else
+		s->metas = RemoveMeta(s->metas, source);
+
+	if ( keep_metadata && ! purge && s->metas != NO_META )
+		return false;
+
+	RemoveSlot(s);
+	return true;
+	}
+
+bool IntelStore::Contains(const Indicator& ind) const
+	{
+	if ( ind.kind == Indicator::SUBNET )
+		return FindSubnet(ind.net) != nullptr;
+
+	auto key = EncodeKey(ind);
+	return FindSlot(key, KeyedHash::Hash64(key.data(), key.size())) != nullptr;
+	}
+
+bool IntelStore::Matches(const IPAddr& addr) const
+	{
+	Indicator ind;
+	ind.kind = Indicator::ADDR;
+	ind.net = IPPrefix(addr, 128, true);
+
+	return Contains(ind) || (num_subnets > 0 && subnets.Lookup(addr, 128, false));
+	}
+
+std::vector<RecordValPtr> IntelStore::Metadata(const Indicator& ind) const
+	{
+	if ( ind.kind == Indicator::SUBNET )
+		{
+		auto e = FindSubnet(ind.net);
+		return e ? CopyMetas(e->metas) : std::vector<RecordValPtr>{};
+		}
+
+	auto key = EncodeKey(ind);
+	auto s = FindSlot(key, KeyedHash::Hash64(key.data(), key.size()));
+	return s ? CopyMetas(s->metas) : std::vector<RecordValPtr>{};
+	}
+
+std::vector<IPPrefix> IntelStore::CoveringSubnets(const IPAddr& addr) const
+	{
+	std::vector<IPPrefix> rval;
+
+	if ( num_subnets == 0 )
+		return rval;
+
+	for ( const auto& [prefix, data] : subnets.FindAll(addr, 128) )
+		rval.emplace_back(static_cast<SubnetEntry*>(data)->prefix);
+
+	return rval;
+	}
+
+void IntelStore::ForEach(
+	const std::function<void(const Indicator&, std::vector<RecordValPtr>)>& f)
+	{
+	for ( const auto& s : slots )
+		{
+		if ( s.key == SLOT_EMPTY || s.key == SLOT_DELETED )
+			continue;
+
+		f(DecodeKey(KeyAt(s.key)), CopyMetas(s.metas));
+		}
+
+	auto i = subnets.InitIterator();
+
+	while ( auto data = subnets.GetNext(&i) )
+		{
+		auto e = static_cast<SubnetEntry*>(data);
+		Indicator ind;
+		ind.kind = Indicator::SUBNET;
+		ind.net = e->prefix;
+		f(ind, CopyMetas(e->metas));
+		}
+	}
+
+	} // namespace zeek::detail
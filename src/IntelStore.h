@@ -0,0 +1,208 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Indicator storage for the Intel framework.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "zeek/IPAddr.h"
+#include "zeek/IntrusivePtr.h"
+#include "zeek/PrefixTable.h"
+#include "zeek/util.h"
+
+namespace zeek
+	{
+
+class RecordVal;
+using RecordValPtr = IntrusivePtr<RecordVal>;
+
+namespace detail
+	{
+
+/**
+ * A store of Intel framework indicators that needs much less memory than
+ * the script-level tables, and matches without leaving C++. Addresses and
+ * strings share one open-addressing hash set whose keys are packed into a
+ * single buffer, subnets live in a prefix trie, and each distinct metadata
+ * record is kept only once, however many indicators refer to it. Like the
+ * script-level store, an indicator has at most one metadata record per
+ * source.
+ */
+class IntelStore
+	{
+public:
+	/**
+	 * An indicator to store or to look up.
+	 */
+	struct Indicator
+		{
+		enum Kind : uint8_t
+			{
+			ADDR,
+			SUBNET,
+			STRING,
+			};
+
+		Kind kind = STRING;
+		IPPrefix net; // ADDR and SUBNET; a /128 (or /32) for ADDR.
+		zeek_int_t type = 0; // STRING; the Intel::Type value.
+		std::string str; // STRING; in lower case.
+		};
+
+	/**
+	 * Constructor.
+	 *
+	 * @param keep_metadata If false, the store tracks only the indicators
+	 * and ignores their metadata, as the workers' store does.
+	 */
+	explicit IntelStore(bool keep_metadata);
+	~IntelStore();
+
+	IntelStore(const IntelStore&) = delete;
+	IntelStore& operator=(const IntelStore&) = delete;
+
+	/**
+	 * Returns true if the store keeps metadata.
+	 */
+	bool KeepsMetadata() const { return keep_metadata; }
+
+	/**
+	 * Adds an indicator, or metadata to an indicator that's already
+	 * stored.
+	 *
+	 * @param ind The indicator.
+	 *
+	 * @param meta An Intel::MetaData record, or null. It replaces any
+	 * record of the same source the indicator has.
+	 *
+	 * @return True if the indicator is new. False if it was stored
+	 * already, or if the store has no room left for its key, which it
+	 * reports as an error.
+	 */
+	bool Insert(const Indicator& ind, const RecordValPtr& meta);
+
+	/**
+	 * Removes an indicator's metadata of a source, and the indicator
+	 * itself once no metadata remains.
+	 *
+	 * @param ind The indicator.
+	 *
+	 * @param source The source whose metadata to remove.
+	 *
+	 * @param purge If true, removes the indicator with all its metadata.
+	 *
+	 * @return True if the indicator is gone now, false if it's still
+	 * stored or wasn't in the first place.
+	 */
+	bool Remove(const Indicator& ind, const std::string& source, bool purge);
+
+	/**
+	 * Returns true if the exact indicator is stored.
+	 */
+	bool Contains(const Indicator& ind) const;
+
+	/**
+	 * Returns true if an address is stored itself or falls into a stored
+	 * subnet.
+	 */
+	bool Matches(const IPAddr& addr) const;
+
+	/**
+	 * Returns copies of the metadata records of an indicator.
+	 */
+	std::vector<RecordValPtr> Metadata(const Indicator& ind) const;
+
+	/**
+	 * Returns the stored subnets that contain an address.
+	 */
+	std::vector<IPPrefix> CoveringSubnets(const IPAddr& addr) const;
+
+	/**
+	 * Returns the number of indicators.
+	 */
+	size_t Size() const { return num_entries + num_subnets; }
+
+	/**
+	 * Calls a function for every indicator with copies of its metadata.
+	 * This isn't const because iterating the subnet trie isn't.
+	 */
+	void ForEach(const std::function<void(const Indicator&, std::vector<RecordValPtr>)>& f);
+
+private:
+	// Where an indicator's metadata is: NO_META, the index of a single
+	// record in metas, or LIST_BIT plus an index into meta_lists.
+	using MetaRef = uint32_t;
+	static constexpr MetaRef NO_META = 0xffffffff;
+	static constexpr MetaRef LIST_BIT = 0x80000000;
+
+	// A hash set slot. The key is an offset into the keys buffer, which
+	// therefore can't grow beyond SLOT_DELETED bytes.
+	struct Slot
+		{
+		uint64_t hash;
+		uint32_t key;
+		MetaRef metas;
+		};
+
+	static constexpr uint32_t SLOT_EMPTY = 0xffffffff;
+	static constexpr uint32_t SLOT_DELETED = 0xfffffffe;
+
+	struct SubnetEntry
+		{
+		IPPrefix prefix;
+		MetaRef metas;
+		};
+
+	struct Meta
+		{
+		RecordValPtr rec;
+		uint64_t hash; // Of the record's description.
+		uint32_t source;
+		uint32_t refs;
+		};
+
+	static std::string EncodeKey(const Indicator& ind);
+	static Indicator DecodeKey(std::string_view key);
+	std::string_view KeyAt(uint32_t offset) const;
+
+	const Slot* FindSlot(std::string_view key, uint64_t hash) const;
+	Slot* FindSlot(std::string_view key, uint64_t hash);
+	Slot* AddSlot(std::string_view key, uint64_t hash, bool* added); // Null if full.
+	void RemoveSlot(Slot* s);
+	void Rehash(size_t capacity);
+
+	SubnetEntry* FindSubnet(const IPPrefix& prefix) const;
+
+	uint32_t Intern(const RecordValPtr& meta);
+	void Unref(uint32_t id);
+	MetaRef AddMeta(MetaRef ref, uint32_t id);
+	MetaRef RemoveMeta(MetaRef ref, const std::string& source);
+	void ReleaseMetas(MetaRef ref);
+	std::vector<RecordValPtr> CopyMetas(MetaRef ref) const;
+
+	bool keep_metadata;
+
+	std::vector<Slot> slots; // Power-of-two size.
+	size_t num_used = 0; // Slots not empty, including deleted ones.
+	size_t num_entries = 0;
+	std::string keys; // Each key is a 32-bit length plus its bytes.
+
+	PrefixTable subnets;
+	size_t num_subnets = 0;
+
+	std::vector<Meta> metas;
+	std::vector<uint32_t> free_metas;
+	std::unordered_multimap<uint64_t, uint32_t> meta_index; // Hashes to metas.
+	std::unordered_map<std::string, uint32_t> source_ids;
+	std::vector<std::vector<uint32_t>> meta_lists;
+	std::vector<uint32_t> free_meta_lists;
+	};
+
+	} // namespace detail
+	} // namespace zeek
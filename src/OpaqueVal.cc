@@ -16,10 +16,13 @@
 
 #include "zeek/CompHash.h"
 #include "zeek/Desc.h"
+#include "zeek/Func.h"
+#include "zeek/IntelStore.h"
 #include "zeek/NetVar.h"
 #include "zeek/Reporter.h"
 #include "zeek/Scope.h"
 #include "zeek/Var.h"
+#include "zeek/broker/Data.h"
 #include "zeek/probabilistic/BloomFilter.h"
 #include "zeek/probabilistic/CardinalityCounter.h"
 
@@ -1092,6 +1095,346 @@ ValPtr ParaglobVal::DoClone(CloneState* state)
 		}
 	}
 
+namespace
+	{
+
+template <class T> IntrusivePtr<T> lookup_intel_type(const char* name)
+	{
+	const auto& id = detail::lookup_ID(name, "Intel");
+	return id && id->IsType() ? cast_intrusive<T>(id->GetType()) : nullptr;
+	}
+
+// The Intel::Type enum, with the values that need special treatment.
+struct IntelTypeEnum
+	{
+	EnumTypePtr type;
+	zeek_int_t addr = -1;
+	zeek_int_t subnet = -1;
+	};
+
+const IntelTypeEnum& intel_type_enum()
+	{
+	static IntelTypeEnum e;
+
+	if ( ! e.type )
+		{
+		e.type = lookup_intel_type<EnumType>("Type");
+
+		if ( e.type )
+			{
+			e.addr = e.type->Lookup("Intel", "ADDR");
+			e.subnet = e.type->Lookup("Intel", "SUBNET");
+			}
+		}
+
+	return e;
+	}
+
+// Builds an indicator from its string and Intel::Type value. Returns false
+// if an address or subnet doesn't parse.
+bool make_intel_indicator(const std::string& indicator, zeek_int_t type,
+                          detail::IntelStore::Indicator* ind)
+	{
+	const auto& e = intel_type_enum();
+
+	if ( type == e.addr )
+		{
+		in6_addr in6;
+
+		if ( ! IPAddr::ConvertString(indicator.c_str(), &in6) )
+			return false;
+
+		ind->kind = detail::IntelStore::Indicator::ADDR;
+		ind->net = IPPrefix(IPAddr(in6), 128, true);
+		return true;
+		}
+
+	if ( type == e.subnet )
+		{
+		ind->kind = detail::IntelStore::Indicator::SUBNET;
+		return IPPrefix::ConvertString(indicator.c_str(), &ind->net);
+		}
+
+	// All intelligence is case insensitive, like in the script-level store.
+	ind->kind = detail::IntelStore::Indicator::STRING;
+	ind->type = type;
+	ind->str = util::strtolower(indicator);
+	return true;
+	}
+
+// As above, for script-level values, reporting errors.
+bool make_intel_indicator(const StringVal* indicator, const Val* type,
+                          detail::IntelStore::Indicator* ind)
+	{
+	const auto& e = intel_type_enum();
+
+	if ( ! e.type || ! same_type(type->GetType(), e.type) )
+		{
+		emit_builtin_error("indicator type must be an Intel::Type");
+		return false;
+		}
+
+	if ( ! make_intel_indicator(indicator->ToStdString(), type->AsEnum(), ind) )
+		{
+		emit_builtin_error(util::fmt("invalid %s indicator: %s", e.type->Lookup(type->AsEnum()),
+		                             indicator->CheckString()));
+		return false;
+		}
+
+	return true;
+	}
+
+	} // namespace
+
+IntelStoreVal::IntelStoreVal()
+	: OpaqueVal(intel_store_type), store(std::make_unique<detail::IntelStore>(true))
+	{
+	}
+
+IntelStoreVal::IntelStoreVal(bool keep_metadata)
+	: OpaqueVal(intel_store_type), store(std::make_unique<detail::IntelStore>(keep_metadata))
+	{
+	}
+
+IntelStoreVal::~IntelStoreVal() = default;
+
+const RecordTypePtr& IntelStoreVal::ItemType()
+	{
+	static RecordTypePtr t;
+
+	if ( ! t )
+		t = lookup_intel_type<RecordType>("Item");
+
+	return t;
+	}
+
+const RecordTypePtr& IntelStoreVal::SeenType()
+	{
+	static RecordTypePtr t;
+
+	if ( ! t )
+		t = lookup_intel_type<RecordType>("Seen");
+
+	return t;
+	}
+
+bool IntelStoreVal::Insert(const StringVal* indicator, const Val* type, RecordValPtr meta)
+	{
+	detail::IntelStore::Indicator ind;
+
+	if ( ! make_intel_indicator(indicator, type, &ind) )
+		return false;
+
+	return store->Insert(ind, meta);
+	}
+
+bool IntelStoreVal::Remove(const StringVal* indicator, const Val* type, const StringVal* source,
+                           bool purge)
+	{
+	detail::IntelStore::Indicator ind;
+
+	if ( ! make_intel_indicator(indicator, type, &ind) )
+		return false;
+
+	return store->Remove(ind, source->ToStdString(), purge);
+	}
+
+bool IntelStoreVal::Contains(const StringVal* indicator, const Val* type) const
+	{
+	detail::IntelStore::Indicator ind;
+	return make_intel_indicator(indicator, type, &ind) && store->Contains(ind);
+	}
+
+bool IntelStoreVal::Find(const RecordVal* seen) const
+	{
+	if ( const auto& host = seen->GetField("host") )
+		return store->Matches(host->AsAddr());
+
+	const auto& indicator = seen->GetField("indicator");
+	const auto& type = seen->GetField("indicator_type");
+
+	if ( ! (indicator && type) )
+		return false;
+
+	detail::IntelStore::Indicator ind;
+	return make_intel_indicator(indicator->AsStringVal(), type.get(), &ind) &&
+	       store->Contains(ind);
+	}
+
+VectorValPtr IntelStoreVal::Items(const RecordVal* seen) const
+	{
+	const auto& item_type = ItemType();
+	const auto& e = intel_type_enum();
+	auto rval = make_intrusive<VectorVal>(make_intrusive<VectorType>(item_type));
+
+	auto indicator_field = item_type->FieldOffset("indicator");
+	auto type_field = item_type->FieldOffset("indicator_type");
+	auto meta_field = item_type->FieldOffset("meta");
+
+	auto add_items =
+		[&](ValPtr indicator, EnumValPtr type, const detail::IntelStore::Indicator& ind)
+		{
+		for ( auto& meta : store->Metadata(ind) )
+			{
+			auto item = make_intrusive<RecordVal>(item_type);
+			item->Assign(indicator_field, indicator);
+			item->Assign(type_field, type);
+			item->Assign(meta_field, std::move(meta));
+			rval->Append(std::move(item));
+			}
+		};
+
+	detail::IntelStore::Indicator ind;
+
+	if ( const auto& host = seen->GetField("host") )
+		{
+		const auto& addr = host->AsAddr();
+		ind.kind = detail::IntelStore::Indicator::ADDR;
+		ind.net = IPPrefix(addr, 128, true);
+		add_items(make_intrusive<StringVal>(addr.AsString()), e.type->GetEnumVal(e.addr), ind);
+
+		ind.kind = detail::IntelStore::Indicator::SUBNET;
+
+		for ( const auto& net : store->CoveringSubnets(addr) )
+			{
+			ind.net = net;
+			add_items(make_intrusive<StringVal>(net.AsString()), e.type->GetEnumVal(e.subnet),
+			          ind);
+			}
+
+		return rval;
+		}
+
+	const auto& indicator = seen->GetField("indicator");
+	const auto& type = seen->GetField("indicator_type");
+
+	if ( indicator && type && make_intel_indicator(indicator->AsStringVal(), type.get(), &ind) )
+		add_items(indicator, cast_intrusive<EnumVal>(type), ind);
+
+	return rval;
+	}
+
+size_t IntelStoreVal::Size() const
+	{
+	return store->Size();
+	}
+
+IMPLEMENT_OPAQUE_VALUE(IntelStoreVal)
+
+broker::expected<broker::data> IntelStoreVal::DoSerialize() const
+	{
+	const auto& e = intel_type_enum();
+
+	if ( ! e.type )
+		return broker::ec::invalid_data;
+
+	// Each indicator becomes its type's name, its string, and its
+	// metadata, which deserializing interns anew.
+	broker::vector entries;
+	bool ok = true;
+
+	store->ForEach(
+		[&](const detail::IntelStore::Indicator& ind, std::vector<RecordValPtr> metas)
+		{
+		std::string indicator;
+		zeek_int_t type = ind.type;
+
+		switch ( ind.kind )
+			{
+			case detail::IntelStore::Indicator::ADDR:
+				indicator = ind.net.Prefix().AsString();
+				type = e.addr;
+				break;
+
+			case detail::IntelStore::Indicator::SUBNET:
+				indicator = ind.net.AsString();
+				type = e.subnet;
+				break;
+
+			case detail::IntelStore::Indicator::STRING:
+				indicator = ind.str;
+				break;
+			}
+
+		broker::vector m;
+
+		for ( const auto& meta : metas )
+			{
+			auto d = Broker::detail::val_to_data(meta.get());
+
+			if ( ! d )
+				{
+				ok = false;
+				return;
+				}
+
+			m.emplace_back(std::move(*d));
+			}
+
+		entries.emplace_back(
+			broker::vector{std::string(e.type->Lookup(type)), std::move(indicator), std::move(m)});
+		});
+
+	if ( ! ok )
+		return broker::ec::invalid_data;
+
+	return {broker::vector{store->KeepsMetadata(), std::move(entries)}};
+	}
+
+bool IntelStoreVal::DoUnserialize(const broker::data& data)
+	{
+	auto v = broker::get_if<broker::vector>(&data);
+
+	if ( ! (v && v->size() == 2) )
+		return false;
+
+	auto keep_metadata = broker::get_if<bool>(&(*v)[0]);
+	auto entries = broker::get_if<broker::vector>(&(*v)[1]);
+	const auto& e = intel_type_enum();
+	auto meta_type = lookup_intel_type<RecordType>("MetaData");
+
+	if ( ! (keep_metadata && entries && e.type && meta_type) )
+		return false;
+
+	store = std::make_unique<detail::IntelStore>(*keep_metadata);
+
+	for ( const auto& entry : *entries )
+		{
+		auto ev = broker::get_if<broker::vector>(&entry);
+
+		if ( ! (ev && ev->size() == 3) )
+			return false;
+
+		auto type_name = broker::get_if<std::string>(&(*ev)[0]);
+		auto indicator = broker::get_if<std::string>(&(*ev)[1]);
+		auto metas = broker::get_if<broker::vector>(&(*ev)[2]);
+
+		if ( ! (type_name && indicator && metas) )
+			return false;
+
+		auto type = e.type->Lookup(*type_name);
+		detail::IntelStore::Indicator ind;
+
+		if ( type < 0 || ! make_intel_indicator(*indicator, type, &ind) )
+			return false;
+
+		if ( metas->empty() )
+			store->Insert(ind, nullptr);
+
+		for ( const auto& m : *metas )
+			{
+			auto meta = Broker::detail::data_to_val(m, meta_type.get());
+
+			if ( ! meta )
+				return false;
+
+			store->Insert(ind, cast_intrusive<RecordVal>(std::move(meta)));
+			}
+		}
+
+	return true;
+	}
+
 broker::expected<broker::data> TelemetryVal::DoSerialize() const
 	{
 	return broker::make_error(broker::ec::invalid_data, "cannot serialize metric handles");
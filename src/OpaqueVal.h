@@ -37,6 +37,10 @@ namespace probabilistic::detail
 	{
 class CardinalityCounter;
 	}
+namespace detail
+	{
+class IntelStore;
+	}
 
 class OpaqueVal;
 using OpaqueValPtr = IntrusivePtr<OpaqueVal>;
@@ -413,6 +417,69 @@ private:
 	std::unique_ptr<paraglob::Paraglob> internal_paraglob;
 	};
 
+/**
+ * Opaque wrapper for the Intel framework's native indicator store. The
+ * script-level values are Intel::Type enums and Intel::MetaData,
+ * Intel::Item, and Intel::Seen records.
+ */
+class IntelStoreVal : public OpaqueVal
+	{
+public:
+	explicit IntelStoreVal(bool keep_metadata);
+	~IntelStoreVal() override;
+
+	/**
+	 * Adds an indicator with its metadata, or null metadata. Returns
+	 * true if the indicator is new.
+	 */
+	bool Insert(const StringVal* indicator, const Val* type, RecordValPtr meta);
+
+	/**
+	 * Removes an indicator's metadata of a source, or the indicator with
+	 * all its metadata if *purge* is set. Returns true if the indicator
+	 * is gone now.
+	 */
+	bool Remove(const StringVal* indicator, const Val* type, const StringVal* source, bool purge);
+
+	/**
+	 * Returns true if the indicator is stored.
+	 */
+	bool Contains(const StringVal* indicator, const Val* type) const;
+
+	/**
+	 * Returns true if a Seen record matches an indicator.
+	 */
+	bool Find(const RecordVal* seen) const;
+
+	/**
+	 * Returns a vector of the Item records matching a Seen record.
+	 */
+	VectorValPtr Items(const RecordVal* seen) const;
+
+	/**
+	 * Returns the number of indicators.
+	 */
+	size_t Size() const;
+
+	/**
+	 * Returns the Intel::Item record type, or null if it isn't defined.
+	 */
+	static const RecordTypePtr& ItemType();
+
+	/**
+	 * Returns the Intel::Seen record type, or null if it isn't defined.
+	 */
+	static const RecordTypePtr& SeenType();
+
+protected:
+	IntelStoreVal();
+
+	DECLARE_OPAQUE_VALUE(IntelStoreVal)
+
+private:
+	std::unique_ptr<detail::IntelStore> store;
+	};
+
 /**
  * Base class for metric handles. Handle types are not serializable.
  */
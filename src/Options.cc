@@ -168,6 +168,12 @@ void usage(const char* prog, int code)
 	        logging::writer::detail::Ascii::LogExt().c_str());
 	fprintf(stderr, "    $ZEEK_PROFILER_FILE             | Output file for script execution "
 	                "statistics (not set)\n");
+	fprintf(stderr, "    $ZEEK_ZAM_CACHE                 | directory for caching compiled ZAM "
+	                "function bodies (%s)\n",
+	        getenv("ZEEK_ZAM_CACHE") ? getenv("ZEEK_ZAM_CACHE") : "not set");
+	fprintf(stderr, "    $ZEEK_ZAM_JOBS                  | number of processes for compiling ZAM "
+	                "function bodies (%s)\n",
+	        getenv("ZEEK_ZAM_JOBS") ? getenv("ZEEK_ZAM_JOBS") : "1");
 	fprintf(stderr,
 	        "    $ZEEK_DISABLE_ZEEKYGEN          | Disable Zeekygen documentation support (%s)\n",
 	        getenv("ZEEK_DISABLE_ZEEKYGEN") ? "set" : "not set");
@@ -210,6 +216,8 @@ static void print_analysis_help()
 		stderr,
 		"    allow-cond	allow standalone compilation of functions influenced by conditionals\n");
 	fprintf(stderr, "    gen-C++	generate C++ script bodies\n");
+	fprintf(stderr,
+	        "    gen-incremental-C++	generate C++ script bodies into per-body files for a plugin\n");
 	fprintf(stderr, "    gen-standalone-C++	generate \"standalone\" C++ script bodies\n");
 	fprintf(stderr, "    help	print this list\n");
 	fprintf(stderr, "    report-C++	report available C++ script bodies and exit\n");
@@ -244,6 +252,8 @@ static void set_analysis_option(const char* opt, Options& opts)
 		a_o.allow_cond = true;
 	else if ( util::streq(opt, "gen-C++") )
 		a_o.gen_CPP = true;
+	else if ( util::streq(opt, "gen-incremental-C++") )
+		a_o.gen_incremental_CPP = true;
 	else if ( util::streq(opt, "gen-standalone-C++") )
 		a_o.gen_standalone_CPP = true;
 	else if ( util::streq(opt, "gen-ZAM-code") )
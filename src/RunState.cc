@@ -39,6 +39,7 @@ extern "C"
 #include "zeek/packet_analysis/Manager.h"
 #include "zeek/plugin/Manager.h"
 #include "zeek/session/Manager.h"
+#include "zeek/telemetry/Manager.h"
 
 static double last_watchdog_proc_time = 0.0; // value of above during last watchdog
 extern int signal_val;
@@ -375,6 +376,9 @@ void run_loop()
 
 		event_mgr.Drain();
 
+		// Keep exported metrics reasonably current.
+		telemetry_mgr->FlushShardedMetrics(false);
+
 		processing_start_time = 0.0; // = "we're not processing now"
 		current_dispatched = 0;
 		current_iosrc = nullptr;
@@ -4,6 +4,7 @@
 
 #include "zeek/zeek-config.h"
 
+#include <algorithm>
 #include <list>
 #include <map>
 #include <string>
@@ -13,6 +14,7 @@
 #include "zeek/Desc.h"
 #include "zeek/Expr.h"
 #include "zeek/Reporter.h"
+#include "zeek/RunState.h"
 #include "zeek/Scope.h"
 #include "zeek/Val.h"
 #include "zeek/Var.h"
@@ -1342,10 +1344,16 @@ void RecordType::AddFieldsDirectly(const type_decl_list& others, bool add_log_at
 	num_fields = types->length();
 	}
 
-void RecordType::Create(std::vector<std::optional<ZVal>>& r) const
+void RecordType::Create(std::vector<std::optional<ZVal>>& r, uint64_t* deferred) const
 	{
 	int n = NumFields();
 
+	// We don't defer while parsing, as record types can still be
+	// redefined at that point.
+	uint64_t deferrable = 0;
+	if ( deferred && ! run_state::is_parsing )
+		deferrable = DeferrableFields();
+
 	for ( int i = 0; i < n; ++i )
 		{
 		auto* init = field_inits[i];
@@ -1388,15 +1396,16 @@ void RecordType::Create(std::vector<std::optional<ZVal>>& r) const
 				break;
 
 			case FieldInit::R_INIT_RECORD:
-				r_i = ZVal(new RecordVal(init->r_type));
-				break;
-
 			case FieldInit::R_INIT_TABLE:
-				r_i = ZVal(new TableVal(init->t_type, init->attrs));
-				break;
-
 			case FieldInit::R_INIT_VECTOR:
-				r_i = ZVal(new VectorVal(init->v_type));
+				if ( i < MAX_DEFERRED_FIELDS && (deferrable & (uint64_t(1) << i)) )
+					{
+					*deferred |= uint64_t(1) << i;
+					r.push_back(std::nullopt);
+					continue;
+					}
+
+				r_i = CreateDeferredField(i);
 				break;
 			}
 
@@ -1404,6 +1413,65 @@ void RecordType::Create(std::vector<std::optional<ZVal>>& r) const
 		}
 	}
 
+ZVal RecordType::CreateDeferredField(int field) const
+	{
+	auto* init = field_inits[field];
+
+	switch ( init->init_type )
+		{
+		case FieldInit::R_INIT_RECORD:
+			return ZVal(new RecordVal(init->r_type));
+
+		case FieldInit::R_INIT_TABLE:
+			return ZVal(new TableVal(init->t_type, init->attrs));
+
+		case FieldInit::R_INIT_VECTOR:
+			return ZVal(new VectorVal(init->v_type));
+
+		default:
+			reporter->InternalError("bad deferred record field initialization");
+		}
+	}
+
+uint64_t RecordType::DeferrableFields() const
+	{
+	if ( deferrable_fields )
+		return *deferrable_fields;
+
+	uint64_t mask = 0;
+	int n = std::min(NumFields(), MAX_DEFERRED_FIELDS);
+
+	for ( int i = 0; i < n; ++i )
+		{
+		auto* init = field_inits[i];
+
+		if ( init->init_type == FieldInit::R_INIT_TABLE ||
+		     init->init_type == FieldInit::R_INIT_VECTOR ||
+		     (init->init_type == FieldInit::R_INIT_RECORD &&
+		      ! init->r_type->CreationEvaluatesDefaults()) )
+			mask |= uint64_t(1) << i;
+		}
+
+	deferrable_fields = mask;
+
+	return mask;
+	}
+
+bool RecordType::CreationEvaluatesDefaults() const
+	{
+	for ( auto* init : field_inits )
+		{
+		if ( init->init_type == FieldInit::R_INIT_DEF )
+			return true;
+
+		if ( init->init_type == FieldInit::R_INIT_RECORD &&
+		     init->r_type->CreationEvaluatesDefaults() )
+			return true;
+		}
+
+	return false;
+	}
+
 void RecordType::DescribeFields(ODesc* d) const
 	{
 	if ( d->IsReadable() )
@@ -686,8 +686,24 @@ public:
 	 *
 	 * Populates a new instance of the record with its initial values.
 	 * @param r  The record's underlying value vector.
+	 * @param deferred  If non-nil, fields that would be initialized to a
+	 * new empty record, table or vector are instead left unset, and a
+	 * bit for each (by field offset) is set in *deferred*.  The caller
+	 * is then responsible for creating them on first access, using
+	 * CreateDeferredField().
 	 */
-	void Create(std::vector<std::optional<ZVal>>& r) const;
+	void Create(std::vector<std::optional<ZVal>>& r, uint64_t* deferred = nullptr) const;
+
+	/**
+	 * Returns the initial value of a field whose creation Create()
+	 * deferred.
+	 * @param field  The field's offset.
+	 */
+	ZVal CreateDeferredField(int field) const;
+
+	// The maximum number of fields (counting from the first) whose
+	// initialization Create() can defer.
+	static constexpr int MAX_DEFERRED_FIELDS = 64;
 
 	void DescribeReST(ODesc* d, bool roles_only = false) const override;
 	void DescribeFields(ODesc* d) const;
@@ -714,6 +730,16 @@ protected:
 
 	void AddField(unsigned int field, const TypeDecl* td);
 
+	// Returns a bitmask of the fields whose initialization can be
+	// deferred.  That's only the case if creating them doesn't
+	// evaluate &default expressions, since deferring that could
+	// change its results.
+	uint64_t DeferrableFields() const;
+
+	// Whether creating a record of this type, including any records
+	// nested in it, evaluates &default expressions.
+	bool CreationEvaluatesDefaults() const;
+
 	void DoDescribe(ODesc* d) const override;
 
 	// Maps each field to how to initialize it.  Uses pointers due to
@@ -724,6 +750,10 @@ protected:
 	// use std::bitset here instead.
 	std::vector<bool> managed_fields;
 
+	// Cache of DeferrableFields(), computed once the record type can
+	// no longer change.
+	mutable std::optional<uint64_t> deferrable_fields;
+
 	// Number of fields in the type.
 	int num_fields = 0;
 
@@ -1091,6 +1121,7 @@ extern zeek::OpaqueTypePtr bloomfilter_type;
 extern zeek::OpaqueTypePtr x509_opaque_type;
 extern zeek::OpaqueTypePtr ocsp_resp_opaque_type;
 extern zeek::OpaqueTypePtr paraglob_type;
+extern zeek::OpaqueTypePtr intel_store_type;
 extern zeek::OpaqueTypePtr int_counter_metric_type;
 extern zeek::OpaqueTypePtr int_counter_metric_family_type;
 extern zeek::OpaqueTypePtr dbl_counter_metric_type;
@@ -14,6 +14,7 @@
 #include <cstdlib>
 #include <set>
 
+#include "zeek/3rdparty/doctest.h"
 #include "zeek/Attr.h"
 #include "zeek/CompHash.h"
 #include "zeek/Conn.h"
@@ -1451,6 +1452,8 @@ void TableVal::RemoveAll()
 	delete table_val;
 	table_val = new PDict<TableEntryVal>;
 	table_val->SetDeleteFunc(table_entry_val_delete_func);
+
+	Modified();
 	}
 
 int TableVal::Size() const
@@ -2750,6 +2753,8 @@ TableVal::ParseTimeTableStates TableVal::parse_time_table_states;
 
 TableVal::TableRecordDependencies TableVal::parse_time_table_record_dependencies;
 
+uint64_t TableVal::last_stamp = 0;
+
 RecordVal::RecordTypeValMap RecordVal::parse_time_records;
 
 RecordVal::RecordVal(RecordTypePtr t, bool init_fields) : Val(t), is_managed(t->ManagedFields())
@@ -2769,7 +2774,7 @@ RecordVal::RecordVal(RecordTypePtr t, bool init_fields) : Val(t), is_managed(t->
 		{
 		try
 			{
-			rt->Create(*record_val);
+			rt->Create(*record_val, &deferred_fields);
 			}
 		catch ( InterpreterException& e )
 			{
@@ -2785,12 +2790,18 @@ RecordVal::~RecordVal()
 	auto n = record_val->size();
 
 	for ( unsigned int i = 0; i < n; ++i )
-		if ( HasField(i) && IsManaged(i) )
+		if ( (*record_val)[i] && IsManaged(i) )
 			ZVal::DeleteManagedType(*(*record_val)[i]);
 
 	delete record_val;
 	}
 
+void RecordVal::CreateDeferredField(unsigned int field) const
+	{
+	deferred_fields &= ~(uint64_t(1) << field);
+	(*record_val)[field] = rt->CreateDeferredField(field);
+	}
+
 ValPtr RecordVal::SizeVal() const
 	{
 	return val_mgr->Count(GetType()->AsRecordType()->NumFields());
@@ -2804,6 +2815,7 @@ void RecordVal::Assign(int field, ValPtr new_val)
 
 		auto t = rt->GetFieldType(field);
 		(*record_val)[field] = ZVal(new_val, t);
+		ClearDeferred(field);
 		Modified();
 		}
 	else
@@ -2814,10 +2826,10 @@ void RecordVal::Remove(int field)
 	{
 	if ( HasField(field) )
 		{
-		if ( IsManaged(field) )
-			ZVal::DeleteManagedType(*(*record_val)[field]);
+		DeleteFieldIfManaged(field);
 
 		(*record_val)[field] = std::nullopt;
+		ClearDeferred(field);
 
 		Modified();
 		}
@@ -3029,6 +3041,15 @@ ValPtr RecordVal::DoClone(CloneState* state)
 	int n = NumFields();
 	for ( auto i = 0; i < n; ++i )
 		{
+		// A field that's still deferred has its initial value,
+		// so the clone can just as well defer it.
+		if ( IsDeferred(i) )
+			{
+			rv->AppendField(nullptr, rt->GetFieldType(i));
+			rv->deferred_fields |= uint64_t(1) << i;
+			continue;
+			}
+
 		auto f_i = GetField(i);
 		auto v = f_i ? f_i->Clone(state) : nullptr;
 		rv->AppendField(std::move(v), rt->GetFieldType(i));
@@ -3044,7 +3065,8 @@ unsigned int RecordVal::ComputeFootprint(std::unordered_set<const Val*>* analyze
 
 	for ( auto i = 0; i < n; ++i )
 		{
-		if ( ! HasField(i) )
+		// Skip deferred fields, too, rather than creating them.
+		if ( ! (*record_val)[i] )
 			continue;
 
 		auto f_i = GetField(i);
@@ -4025,4 +4047,58 @@ const PortValPtr& ValManager::Port(uint32_t port_num)
 		return Port(port_num, TRANSPORT_UNKNOWN);
 	}
 
+StringValPtr ValManager::InternedString(std::string_view s)
+	{
+	if ( s.size() > MAX_INTERNED_STRING_LEN )
+		return make_intrusive<StringVal>(s);
+
+	std::string key(s);
+	auto it = interned_strings.find(key);
+
+	if ( it != interned_strings.end() )
+		return it->second;
+
+	auto v = make_intrusive<StringVal>(s);
+
+	if ( interned_strings.size() < MAX_INTERNED_STRINGS )
+		interned_strings.emplace(std::move(key), v);
+
+	return v;
+	}
+
 	}
+
+TEST_SUITE_BEGIN("ValManager");
+
+TEST_CASE("interned strings")
+	{
+	zeek::ValManager vm;
+
+	auto a = vm.InternedString("GET");
+	auto b = vm.InternedString(std::string("GET"));
+	CHECK_EQ(a.get(), b.get());
+	CHECK_EQ(a->ToStdString(), "GET");
+	CHECK_NE(vm.InternedString("POST").get(), a.get());
+
+	std::string long_str(zeek::ValManager::MAX_INTERNED_STRING_LEN + 1, 'x');
+	auto l1 = vm.InternedString(long_str);
+	auto l2 = vm.InternedString(long_str);
+	CHECK_NE(l1.get(), l2.get());
+	CHECK_EQ(l1->ToStdString(), long_str);
+
+	std::string max_str(zeek::ValManager::MAX_INTERNED_STRING_LEN, 'x');
+	CHECK_EQ(vm.InternedString(max_str).get(), vm.InternedString(max_str).get());
+
+	// Fill up the table. Strings interned before stay shared, later ones don't.
+	for ( size_t i = 0; i < zeek::ValManager::MAX_INTERNED_STRINGS; ++i )
+		vm.InternedString(std::to_string(i));
+
+	CHECK_EQ(vm.InternedString("GET").get(), a.get());
+
+	auto o1 = vm.InternedString("one too many");
+	auto o2 = vm.InternedString("one too many");
+	CHECK_NE(o1.get(), o2.get());
+	CHECK_EQ(o1->ToStdString(), "one too many");
+	}
+
+TEST_SUITE_END();
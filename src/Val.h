@@ -338,6 +338,18 @@ public:
 	// Host-order port number already masked with port space protocol mask.
 	const PortValPtr& Port(uint32_t port_num);
 
+	// Returns a shared value for the given string.  Meant for strings
+	// that analyzers produce over and over, drawn from a small set of
+	// possibilities, such as HTTP methods and versions or DNS option
+	// names.  Strings longer than MAX_INTERNED_STRING_LEN, and ones seen
+	// after MAX_INTERNED_STRINGS different strings have been interned,
+	// get a new value, so cardinality mistakes can't exhaust memory.
+	// The returned value must not be modified (e.g., via ToUpper()).
+	StringValPtr InternedString(std::string_view s);
+
+	static constexpr size_t MAX_INTERNED_STRING_LEN = 64;
+	static constexpr size_t MAX_INTERNED_STRINGS = 4096;
+
 private:
 #ifdef PREALLOCATE_PORT_ARRAY
 	std::array<std::array<PortValPtr, 65536>, NUM_PORT_SPACES> ports;
@@ -348,6 +360,7 @@ private:
 	std::array<ValPtr, PREALLOCATED_COUNTS> counts;
 	std::array<ValPtr, PREALLOCATED_INTS> ints;
 	StringValPtr empty_string;
+	std::unordered_map<std::string, StringValPtr> interned_strings;
 	ValPtr b_true;
 	ValPtr b_false;
 	};
@@ -954,6 +967,15 @@ public:
 	// type that the general Table API does not allow.
 	const detail::PrefixTable* Subnets() const { return subnets; }
 
+	/**
+	 * Returns a value identifying the table's current content. It changes
+	 * with every insertion, removal, expiration or clearing, and is never
+	 * shared by two tables, even ones allocated at the same address over
+	 * time. This allows caching lookup results without needing to
+	 * register for notifications.
+	 */
+	uint64_t ModificationStamp() const { return stamp; }
+
 	void Describe(ODesc* d) const override;
 
 	void InitTimer(double delay);
@@ -1054,6 +1076,15 @@ protected:
 
 	ValPtr DoClone(CloneState* state) override;
 
+	// Notes a change of the table's content, both for notifier receivers
+	// and for ModificationStamp(). Only tables carry a stamp, so this
+	// extends the base class's version rather than overriding it.
+	void Modified()
+		{
+		stamp = ++last_stamp;
+		notifier::detail::Modifiable::Modified();
+		}
+
 	TableTypePtr table_type;
 	detail::CompositeHash* table_hash;
 	detail::AttributesPtr attrs;
@@ -1073,6 +1104,11 @@ protected:
 
 private:
 	PDict<TableEntryVal>* table_val;
+
+	// The table's current modification stamp, and the most recently
+	// handed out one across all tables.
+	uint64_t stamp = ++last_stamp;
+	static uint64_t last_stamp;
 	};
 
 // This would be way easier with is_convertible_v, but sadly that won't
@@ -1206,7 +1242,7 @@ public:
 	 * @param field  The field index to retrieve.
 	 * @return  Whether there's a value for the given field index.
 	 */
-	bool HasField(int field) const { return (*record_val)[field] ? true : false; }
+	bool HasField(int field) const { return (*record_val)[field] || IsDeferred(field); }
 
 	/**
 	 * Returns true if the given field is in the record, false if
@@ -1230,6 +1266,7 @@ public:
 		if ( ! HasField(field) )
 			return nullptr;
 
+		CreateIfDeferred(field);
 		return (*record_val)[field]->ToVal(rt->GetFieldType(field));
 		}
 
@@ -1303,6 +1340,8 @@ public:
 	template <typename T, typename std::enable_if_t<is_zeek_val_v<T>, bool> = true>
 	auto GetFieldAs(int field) const -> std::invoke_result_t<decltype(&T::Get), T>
 		{
+		CreateIfDeferred(field);
+
 		if constexpr ( std::is_same_v<T, BoolVal> || std::is_same_v<T, IntVal> ||
 		               std::is_same_v<T, EnumVal> )
 			return record_val->operator[](field)->int_val;
@@ -1429,7 +1468,11 @@ protected:
 	// Caller assumes responsibility for memory management.  The first
 	// version allows manipulation of whether the field is present at all.
 	// The second version ensures that the optional value is present.
-	std::optional<ZVal>& RawOptField(int field) { return (*record_val)[field]; }
+	std::optional<ZVal>& RawOptField(int field)
+		{
+		CreateIfDeferred(field);
+		return (*record_val)[field];
+		}
 
 	ZVal& RawField(int field)
 		{
@@ -1441,7 +1484,11 @@ protected:
 
 	ValPtr DoClone(CloneState* state) override;
 
-	void AddedField(int field) { Modified(); }
+	void AddedField(int field)
+		{
+		ClearDeferred(field);
+		Modified();
+		}
 
 	Obj* origin;
 
@@ -1451,10 +1498,33 @@ protected:
 private:
 	void DeleteFieldIfManaged(unsigned int field)
 		{
-		if ( HasField(field) && IsManaged(field) )
+		if ( (*record_val)[field] && IsManaged(field) )
 			ZVal::DeleteManagedType(*(*record_val)[field]);
 		}
 
+	// Support for fields whose creation RecordType::Create() deferred.
+	// Such a field counts as present, but only gets its value when
+	// first accessed.
+	bool IsDeferred(unsigned int field) const
+		{
+		return deferred_fields && field < RecordType::MAX_DEFERRED_FIELDS &&
+		       (deferred_fields & (uint64_t(1) << field));
+		}
+
+	void ClearDeferred(unsigned int field)
+		{
+		if ( IsDeferred(field) )
+			deferred_fields &= ~(uint64_t(1) << field);
+		}
+
+	void CreateIfDeferred(unsigned int field) const
+		{
+		if ( IsDeferred(field) )
+			CreateDeferredField(field);
+		}
+
+	void CreateDeferredField(unsigned int field) const;
+
 	bool IsManaged(unsigned int offset) const { return is_managed[offset]; }
 
 	// Just for template inferencing.
@@ -1468,6 +1538,10 @@ private:
 	// Low-level values of each of the fields.
 	std::vector<std::optional<ZVal>>* record_val;
 
+	// Bitmask of the fields whose creation is deferred until first
+	// access.  Mutable as that access can come from const methods.
+	mutable uint64_t deferred_fields = 0;
+
 	// Whether a given field requires explicit memory management.
 	const std::vector<bool>& is_managed;
 	};
@@ -0,0 +1,262 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek/VectorKernels.h"
+
+#include <algorithm>
+
+#include "zeek/Val.h"
+
+namespace zeek::detail
+	{
+
+using ZVec = std::vector<std::optional<ZVal>>;
+
+template <typename T> static T native(const ZVal& z);
+
+template <> zeek_int_t native<zeek_int_t>(const ZVal& z)
+	{
+	return z.AsInt();
+	}
+
+template <> zeek_uint_t native<zeek_uint_t>(const ZVal& z)
+	{
+	return z.AsCount();
+	}
+
+template <> double native<double>(const ZVal& z)
+	{
+	return z.AsDouble();
+	}
+
+template <typename T> static T native(const Val* v);
+
+template <> zeek_int_t native<zeek_int_t>(const Val* v)
+	{
+	return v->InternalInt();
+	}
+
+template <> zeek_uint_t native<zeek_uint_t>(const Val* v)
+	{
+	return v->InternalUnsigned();
+	}
+
+template <> double native<double>(const Val* v)
+	{
+	return v->InternalDouble();
+	}
+
+// Returns the low-level element type of a vector a kernel can work on,
+// or nothing if there's no kernel for it.
+static std::optional<InternalTypeTag> kernel_type(const VectorVal* v)
+	{
+	if ( v->RawYieldTypes() )
+		return std::nullopt;
+
+	auto it = v->RawYieldType()->InternalType();
+	if ( it != TYPE_INTERNAL_INT && it != TYPE_INTERNAL_UNSIGNED && it != TYPE_INTERNAL_DOUBLE )
+		return std::nullopt;
+
+	const auto& vec = *v->RawVec();
+	if ( std::any_of(vec.begin(), vec.end(), [](const auto& e) { return ! e; }) )
+		return std::nullopt;
+
+	return it;
+	}
+
+static bool is_comparison(VecKernelOp op)
+	{
+	return op != VK_ADD && op != VK_SUB && op != VK_TIMES;
+	}
+
+// Checks whether a kernel can produce the given result type for operands
+// of the given low-level type.
+static bool kernel_applies(VecKernelOp op, const VectorTypePtr& t, InternalTypeTag it)
+	{
+	const auto& y = t->Yield();
+
+	if ( is_comparison(op) )
+		return y->Tag() == TYPE_BOOL;
+
+	if ( op == VK_SUB && it == TYPE_INTERNAL_UNSIGNED )
+		return false;
+
+	return y->Tag() != TYPE_BOOL && y->InternalType() == it;
+	}
+
+// The loop that all kernels come down to.  "a" and "b" return the i'th
+// left-hand and right-hand operands, "f" combines them.  All of these
+// are known at compile time, so the loop body inlines into straight-line
+// code.
+template <typename R, typename A, typename B, typename F>
+static VectorValPtr apply(const VectorTypePtr& t, size_t n, A a, B b, F f)
+	{
+	auto res = new ZVec(n);
+	auto& r = *res;
+
+	for ( size_t i = 0; i < n; ++i )
+		r[i] = ZVal(static_cast<R>(f(a(i), b(i))));
+
+	return make_intrusive<VectorVal>(t, res);
+	}
+
+template <typename T, typename A, typename B>
+static VectorValPtr dispatch(VecKernelOp op, const VectorTypePtr& t, size_t n, A a, B b)
+	{
+	// Comparisons yield bools, which live in ZVal's as ints.
+	using Bool = zeek_int_t;
+
+	switch ( op )
+		{
+		case VK_ADD:
+			return apply<T>(t, n, a, b, [](T x, T y) { return x + y; });
+		case VK_SUB:
+			return apply<T>(t, n, a, b, [](T x, T y) { return x - y; });
+		case VK_TIMES:
+			return apply<T>(t, n, a, b, [](T x, T y) { return x * y; });
+		case VK_LT:
+			return apply<Bool>(t, n, a, b, [](T x, T y) { return x < y; });
+		case VK_LE:
+			return apply<Bool>(t, n, a, b, [](T x, T y) { return x <= y; });
+		case VK_EQ:
+			return apply<Bool>(t, n, a, b, [](T x, T y) { return x == y; });
+		case VK_NE:
+			return apply<Bool>(t, n, a, b, [](T x, T y) { return x != y; });
+		case VK_GE:
+			return apply<Bool>(t, n, a, b, [](T x, T y) { return x >= y; });
+		case VK_GT:
+			return apply<Bool>(t, n, a, b, [](T x, T y) { return x > y; });
+		}
+
+	return nullptr;
+	}
+
+template <typename T>
+static VectorValPtr vec_vec(VecKernelOp op, const VectorTypePtr& t, const ZVec& v1, const ZVec& v2)
+	{
+	auto a = [&v1](size_t i) { return native<T>(*v1[i]); };
+	auto b = [&v2](size_t i) { return native<T>(*v2[i]); };
+	return dispatch<T>(op, t, v1.size(), a, b);
+	}
+
+template <typename T>
+static VectorValPtr vec_scalar(VecKernelOp op, const VectorTypePtr& t, const ZVec& v, const Val* s,
+                               bool scalar_first)
+	{
+	auto elem = [&v](size_t i) { return native<T>(*v[i]); };
+	auto sv = native<T>(s);
+	auto scalar = [sv](size_t) { return sv; };
+
+	if ( scalar_first )
+		return dispatch<T>(op, t, v.size(), scalar, elem);
+	else
+		return dispatch<T>(op, t, v.size(), elem, scalar);
+	}
+
+VectorValPtr vec_kernel(VecKernelOp op, const VectorTypePtr& t, const VectorVal* v1,
+                        const VectorVal* v2)
+	{
+	auto it = kernel_type(v1);
+	if ( ! it || kernel_type(v2) != it || ! kernel_applies(op, t, *it) )
+		return nullptr;
+
+	const auto& vec1 = *v1->RawVec();
+	const auto& vec2 = *v2->RawVec();
+
+	if ( vec1.size() != vec2.size() )
+		return nullptr;
+
+	switch ( *it )
+		{
+		case TYPE_INTERNAL_INT:
+			return vec_vec<zeek_int_t>(op, t, vec1, vec2);
+		case TYPE_INTERNAL_UNSIGNED:
+			return vec_vec<zeek_uint_t>(op, t, vec1, vec2);
+		case TYPE_INTERNAL_DOUBLE:
+			return vec_vec<double>(op, t, vec1, vec2);
+		default:
+			return nullptr;
+		}
+	}
+
+VectorValPtr vec_kernel(VecKernelOp op, const VectorTypePtr& t, const VectorVal* v, const Val* s,
+                        bool scalar_first)
+	{
+	auto it = kernel_type(v);
+	if ( ! it || s->GetType()->InternalType() != *it || ! kernel_applies(op, t, *it) )
+		return nullptr;
+
+	const auto& vec = *v->RawVec();
+
+	switch ( *it )
+		{
+		case TYPE_INTERNAL_INT:
+			return vec_scalar<zeek_int_t>(op, t, vec, s, scalar_first);
+		case TYPE_INTERNAL_UNSIGNED:
+			return vec_scalar<zeek_uint_t>(op, t, vec, s, scalar_first);
+		case TYPE_INTERNAL_DOUBLE:
+			return vec_scalar<double>(op, t, vec, s, scalar_first);
+		default:
+			return nullptr;
+		}
+	}
+
+// Folds the present elements of a vector using "f", starting with the
+// first of them.  Returns nothing if the vector isn't numeric or there
+// aren't any elements.
+template <typename F> static std::optional<double> reduce(const VectorVal* v, F f)
+	{
+	if ( v->RawYieldTypes() )
+		return std::nullopt;
+
+	const auto& vec = *v->RawVec();
+	std::optional<double> res;
+
+	auto fold = [&](auto get)
+	{
+		for ( const auto& e : vec )
+			if ( e )
+				{
+				double x = get(*e);
+				res = res ? f(*res, x) : x;
+				}
+	};
+
+	switch ( v->RawYieldType()->InternalType() )
+		{
+		case TYPE_INTERNAL_INT:
+			fold([](const ZVal& z) { return static_cast<double>(z.AsInt()); });
+			break;
+		case TYPE_INTERNAL_UNSIGNED:
+			fold([](const ZVal& z) { return static_cast<double>(z.AsCount()); });
+			break;
+		case TYPE_INTERNAL_DOUBLE:
+			fold([](const ZVal& z) { return z.AsDouble(); });
+			break;
+		default:
+			return std::nullopt;
+		}
+
+	return res;
+	}
+
+std::optional<double> vec_sum(const VectorVal* v)
+	{
+	auto it = v->RawYieldType()->InternalType();
+	if ( it != TYPE_INTERNAL_INT && it != TYPE_INTERNAL_UNSIGNED && it != TYPE_INTERNAL_DOUBLE )
+		return std::nullopt;
+
+	auto sum = reduce(v, [](double x, double y) { return x + y; });
+	return sum ? sum : 0.0;
+	}
+
+std::optional<double> vec_min(const VectorVal* v)
+	{
+	return reduce(v, [](double x, double y) { return std::min(x, y); });
+	}
+
+std::optional<double> vec_max(const VectorVal* v)
+	{
+	return reduce(v, [](double x, double y) { return std::max(x, y); });
+	}
+
+	} // namespace zeek::detail
@@ -0,0 +1,56 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+// Typed loops ("kernels") for element-wise operations on vectors of numbers,
+// and for reductions over them.  The general code paths for vector
+// operations evaluate each element separately, dispatching on its type and
+// often creating a Val for it.  The kernels instead select a loop once per
+// operation, and that loop then works directly on the vector's ZVals.
+
+#pragma once
+
+#include <optional>
+
+#include "zeek/Type.h"
+#include "zeek/ZVal.h"
+
+namespace zeek::detail
+	{
+
+// The element-wise operations that have kernels.
+enum VecKernelOp
+	{
+	VK_ADD,
+	VK_SUB,
+	VK_TIMES,
+	VK_LT,
+	VK_LE,
+	VK_EQ,
+	VK_NE,
+	VK_GE,
+	VK_GT,
+	};
+
+// Computes "v1 op v2" element-wise for two vectors of the same size.  "t"
+// is the type of the result, which for comparisons must be vector of bool
+// and otherwise must have the same low-level element type as the operands.
+//
+// Returns nil if there's no kernel for the operands, in which case the
+// caller needs to use its general code path.  That's the case for vectors
+// with holes, vectors of any, operands with differing low-level types, and
+// subtraction of counts (which warns about underflows).
+extern VectorValPtr vec_kernel(VecKernelOp op, const VectorTypePtr& t, const VectorVal* v1,
+                               const VectorVal* v2);
+
+// The same, but for a vector and a scalar.  "scalar_first" is true if the
+// scalar is the left-hand operand.
+extern VectorValPtr vec_kernel(VecKernelOp op, const VectorTypePtr& t, const VectorVal* v,
+                               const Val* s, bool scalar_first);
+
+// Reductions over the elements of a vector of numbers, skipping holes.
+// These return nothing if the vector isn't numeric, and vec_min() and
+// vec_max() also if the vector has no elements.
+extern std::optional<double> vec_sum(const VectorVal* v);
+extern std::optional<double> vec_min(const VectorVal* v);
+extern std::optional<double> vec_max(const VectorVal* v);
+
+	} // namespace zeek::detail
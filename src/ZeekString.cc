@@ -62,12 +62,23 @@ String::String()
 	use_free_to_delete = false;
 	}
 
+byte_vec String::Alloc(int size)
+	{
+	if ( size <= static_cast<int>(sizeof(inline_bytes)) )
+		return inline_bytes;
+
+	return new u_char[size];
+	}
+
 void String::Reset()
 	{
-	if ( use_free_to_delete )
-		free(b);
-	else
-		delete[] b;
+	if ( b != inline_bytes )
+		{
+		if ( use_free_to_delete )
+			free(b);
+		else
+			delete[] b;
+		}
 
 	b = nullptr;
 	n = 0;
@@ -82,7 +93,7 @@ const String& String::operator=(const String& bs)
 
 	Reset();
 	n = bs.n;
-	b = new u_char[n + 1];
+	b = Alloc(n + 1);
 
 	memcpy(b, bs.b, n);
 	b[n] = '\0';
@@ -137,7 +148,7 @@ void String::Set(const u_char* str, int len, bool add_NUL)
 	Reset();
 
 	n = len;
-	b = new u_char[add_NUL ? n + 1 : n];
+	b = Alloc(add_NUL ? n + 1 : n);
 	memcpy(b, str, n);
 	final_NUL = add_NUL;
 
@@ -154,7 +165,7 @@ void String::Set(std::string_view str)
 	if ( ! str.empty() )
 		{
 		n = str.size();
-		b = new u_char[n + 1];
+		b = Alloc(n + 1);
 		memcpy(b, str.data(), n);
 		b[n] = 0;
 		final_NUL = true;
@@ -733,4 +744,47 @@ TEST_CASE("misc")
 		delete entry;
 	}
 
+TEST_CASE("inline storage")
+	{
+	auto is_inline = [](const zeek::String& s)
+	{
+		auto p = reinterpret_cast<const u_char*>(&s);
+		return s.Bytes() >= p && s.Bytes() < p + sizeof(s);
+	};
+
+	std::string short_text(zeek::String::MAX_INLINE_LEN, 'a');
+	std::string long_text(zeek::String::MAX_INLINE_LEN + 1, 'b');
+
+	zeek::String s1{short_text};
+	CHECK(is_inline(s1));
+	CHECK_EQ(s1, short_text);
+	CHECK_EQ(s1.Bytes()[s1.Len()], '\0');
+
+	zeek::String s2{long_text};
+	CHECK_FALSE(is_inline(s2));
+	CHECK_EQ(s2, long_text);
+
+	zeek::String s3{s1};
+	CHECK(is_inline(s3));
+	CHECK_NE(s3.Bytes(), s1.Bytes());
+	s3.ToUpper();
+	CHECK_EQ(s1, short_text);
+	CHECK_EQ(s3, std::string(zeek::String::MAX_INLINE_LEN, 'A'));
+
+	s3 = s2;
+	CHECK_FALSE(is_inline(s3));
+	CHECK_EQ(s3, long_text);
+
+	s3.Set("GET");
+	CHECK(is_inline(s3));
+	CHECK_EQ(s3, "GET");
+
+	// Adopted buffers stay where they are.
+	zeek::byte_vec text = new u_char[4];
+	memcpy(text, "abc", 4);
+	s3.Adopt(text, 4);
+	CHECK_EQ(s3.Bytes(), text);
+	CHECK_EQ(s3, "abc");
+	}
+
 TEST_SUITE_END();
@@ -157,13 +157,23 @@ public:
 	static Vec* VecFromPolicy(VectorVal* vec);
 	static char* VecToString(const Vec* vec);
 
+	// Strings up to this length (plus a final NUL) are stored inline,
+	// without a separate heap allocation.
+	static constexpr int MAX_INLINE_LEN = 23;
+
 protected:
 	void Reset();
 
+	// Returns storage for "size" bytes, inline if they fit.
+	byte_vec Alloc(int size);
+
 	byte_vec b;
 	int n;
 	bool final_NUL; // whether we have added a final NUL
 	bool use_free_to_delete; // free() vs. operator delete
+
+	// If "b" points here then we own no heap memory.
+	u_char inline_bytes[MAX_INLINE_LEN + 1];
 	};
 
 // A comparison class that sorts pointers to String's according to
@@ -6,6 +6,7 @@
 #include <algorithm>
 
 #include "zeek/3rdparty/doctest.h"
+#include "zeek/AnalyzerAccounting.h"
 #include "zeek/Event.h"
 #include "zeek/ZeekString.h"
 #include "zeek/analyzer/Manager.h"
@@ -76,6 +77,14 @@ const char* Analyzer::GetAnalyzerName() const
 	return analyzer_mgr->GetComponentName(tag).c_str();
 	}
 
+zeek::detail::AnalyzerCounters* Analyzer::Accounting()
+	{
+	if ( ! accounting && tag && zeek::detail::AnalyzerAccounting::Enabled() )
+		accounting = zeek::detail::AnalyzerAccounting::Lookup("protocol", GetAnalyzerName());
+
+	return accounting;
+	}
+
 void Analyzer::SetAnalyzerTag(const zeek::Tag& arg_tag)
 	{
 	assert(! tag || tag == arg_tag);
@@ -224,6 +233,7 @@ void Analyzer::NextPacket(int len, const u_char* data, bool is_orig, uint64_t se
 		{
 		try
 			{
+			zeek::detail::AnalyzerAccounting::Invocation accounted(Accounting(), len, true);
 			DeliverPacket(len, data, is_orig, seq, ip, caplen);
 			}
 		catch ( binpac::Exception const& e )
@@ -247,6 +257,7 @@ void Analyzer::NextStream(int len, const u_char* data, bool is_orig)
 		{
 		try
 			{
+			zeek::detail::AnalyzerAccounting::Invocation accounted(Accounting(), len, false);
 			DeliverStream(len, data, is_orig);
 			}
 		catch ( binpac::Exception const& e )
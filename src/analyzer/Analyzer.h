@@ -26,6 +26,7 @@ using RecordValPtr = zeek::IntrusivePtr<RecordVal>;
 namespace detail
 	{
 class Rule;
+struct AnalyzerCounters;
 	}
 namespace packet_analysis::IP
 	{
@@ -712,6 +713,10 @@ private:
 	// Helper for the ctors.
 	void CtorInit(const zeek::Tag& tag, Connection* conn);
 
+	// Returns the analyzer's accounting counters, or null if accounting
+	// is off.
+	zeek::detail::AnalyzerCounters* Accounting();
+
 	// Internal helper to raise analyzer_confirmation events
 	void EnqueueAnalyzerConfirmationInfo(const zeek::Tag& arg_tag);
 
@@ -751,6 +756,7 @@ private:
 	bool removing;
 
 	uint64_t analyzer_violations = 0;
+	zeek::detail::AnalyzerCounters* accounting = nullptr;
 
 	static ID id_counter;
 	};
@@ -9,6 +9,8 @@
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <cctype>
+#include <string_view>
+#include <unordered_set>
 
 #include "zeek/Event.h"
 #include "zeek/NetVar.h"
@@ -23,7 +25,13 @@ namespace zeek::analyzer::dns
 namespace detail
 	{
 
+// The maximum number of compression pointers followed within a single name.
+// A name has at most 127 labels, so legitimate messages stay well below.
+constexpr int MAX_COMPRESSION_POINTERS = 128;
+
 DNS_Interpreter::DNS_Interpreter(analyzer::Analyzer* arg_analyzer)
+	: addr_replies(dns_addr_replies, id::find_type<VectorType>("dns_addr_reply_vec"),
+	               BifConst::dns_max_batched_replies)
 	{
 	analyzer = arg_analyzer;
 	first_message = true;
@@ -129,10 +137,30 @@ void DNS_Interpreter::ParseMessage(const u_char* data, int len, int is_query)
 
 void DNS_Interpreter::EndMessage(detail::DNS_MsgInfo* msg)
 	{
+	FlushAddrReplies(msg);
+
 	if ( dns_end )
 		analyzer->EnqueueConnEvent(dns_end, analyzer->ConnVal(), msg->BuildHdrVal());
 	}
 
+void DNS_Interpreter::AddAddrReply(detail::DNS_MsgInfo* msg, AddrValPtr addr)
+	{
+	static auto dns_addr_reply = id::find_type<RecordType>("dns_addr_reply");
+
+	auto r = make_intrusive<RecordVal>(dns_addr_reply);
+	r->Assign(0, msg->BuildAnswerVal());
+	r->Assign(1, std::move(addr));
+
+	if ( addr_replies.Add(std::move(r)) )
+		FlushAddrReplies(msg);
+	}
+
+void DNS_Interpreter::FlushAddrReplies(detail::DNS_MsgInfo* msg)
+	{
+	if ( addr_replies.Size() > 0 )
+		addr_replies.Flush(analyzer, {analyzer->ConnVal(), msg->BuildHdrVal()});
+	}
+
 bool DNS_Interpreter::ParseQuestions(detail::DNS_MsgInfo* msg, const u_char*& data, int& len,
                                      const u_char* msg_start)
 	{
@@ -184,16 +212,17 @@ bool DNS_Interpreter::ParseQuestion(detail::DNS_MsgInfo* msg, const u_char*& dat
 
 	if ( dns_event && ! msg->skip_event )
 		{
-		String* original_name = new String(name, name_end - name, true);
+		auto original_name = make_intrusive<StringVal>(new String(name, name_end - name, true));
 
 		// Downcase the Name to normalize it
 		for ( u_char* np = name; np < name_end; ++np )
 			if ( isupper(*np) )
 				*np = tolower(*np);
 
-		String* question_name = new String(name, name_end - name, true);
+		auto question_name = NameVal(name, name_end);
 
-		SendReplyOrRejectEvent(msg, dns_event, data, len, question_name, original_name);
+		SendReplyOrRejectEvent(msg, dns_event, data, len, std::move(question_name),
+		                       std::move(original_name));
 		}
 	else
 		{
@@ -225,7 +254,7 @@ bool DNS_Interpreter::ParseAnswer(detail::DNS_MsgInfo* msg, const u_char*& data,
 	// Note that the exact meaning of some of these fields will be
 	// re-interpreted by other, more adventurous RR types.
 
-	msg->query_name = make_intrusive<StringVal>(new String(name, name_end - name, true));
+	msg->query_name = NameVal(name, name_end);
 	msg->atype = detail::RR_Type(ExtractShort(data, len));
 	msg->aclass = ExtractShort(data, len);
 	msg->ttl = ExtractLong(data, len);
@@ -377,118 +406,181 @@ bool DNS_Interpreter::ParseAnswer(detail::DNS_MsgInfo* msg, const u_char*& data,
 u_char* DNS_Interpreter::ExtractName(const u_char*& data, int& len, u_char* name, int name_len,
                                      const u_char* msg_start, bool downcase)
 	{
-	u_char* name_start = name;
+	// Labels are copied straight from the message into the name buffer,
+	// following compression pointers iteratively. The result is the same
+	// as resolving each pointer recursively: the part of the name reached
+	// through a pointer forms a segment of its own that is always
+	// downcased and gets its trailing dot stripped separately.
+	u_char* segment_start[MAX_COMPRESSION_POINTERS + 1];
+	int num_segments = 0;
+	segment_start[num_segments++] = name;
 
-	while ( ExtractLabel(data, len, name, name_len, msg_start) )
-		;
+	// The position labels are read from. Only reads that precede the
+	// first compression pointer consume the caller's data.
+	const u_char* p = data;
+	int p_len = len;
+	bool followed_pointer = false;
+	bool lower = downcase;
 
-	int n = name - name_start;
+	while ( p_len > 0 )
+		{
+		const u_char* orig_p = p;
+		int label_len = p[0];
 
-	if ( n >= 255 )
-		analyzer->Weird("DNS_NAME_too_long");
+		++p;
+		--p_len;
 
-	if ( n >= 2 && name[-1] == '.' )
-		{
-		// Remove trailing dot.
-		--name;
-		name[0] = 0;
-		}
+		if ( p_len <= 0 )
+			break;
 
-	// Convert labels to lower case for consistency.
-	if ( downcase )
-		for ( u_char* np = name_start; np < name; ++np )
-			if ( isupper(*np) )
-				*np = tolower(*np);
+		if ( label_len == 0 )
+			// Found terminating label.
+			break;
 
-	return name;
-	}
+		if ( (label_len & 0xc0) == 0xc0 )
+			{
+			unsigned short offset = (label_len & ~0xc0) << 8;
 
-bool DNS_Interpreter::ExtractLabel(const u_char*& data, int& len, u_char*& name, int& name_len,
-                                   const u_char* msg_start)
-	{
-	if ( len <= 0 )
-		return false;
+			offset |= *p;
 
-	const u_char* orig_data = data;
-	int label_len = data[0];
+			++p;
+			--p_len;
 
-	++data;
-	--len;
+			if ( offset >= orig_p - msg_start )
+				{
+				// (You'd think that actually the offset should be
+				//  at least 6 bytes below our current position:
+				//  2 bytes for a non-trivial label, plus 4 bytes for
+				//  its class and type, which presumably are between
+				//  our current location and the instance of the label.
+				//  But actually this turns out not to be the case -
+				//  sometimes compression points to compression.)
+
+				analyzer->Weird("DNS_label_forward_compress_offset");
+				break;
+				}
 
-	if ( len <= 0 )
-		return false;
+			// Pointers only lead backwards, so they cannot loop, but a
+			// crafted message could still chain a large number of them.
+			if ( num_segments > MAX_COMPRESSION_POINTERS )
+				{
+				analyzer->Weird("DNS_label_too_many_compress_pointers");
+				break;
+				}
 
-	if ( label_len == 0 )
-		// Found terminating label.
-		return false;
+			if ( ! followed_pointer )
+				{
+				data = p;
+				len = p_len;
+				followed_pointer = true;
+				}
 
-	if ( (label_len & 0xc0) == 0xc0 )
-		{
-		unsigned short offset = (label_len & ~0xc0) << 8;
+			segment_start[num_segments++] = name;
+			p = msg_start + offset;
+			p_len = orig_p - p;
+			lower = true;
+			continue;
+			}
 
-		offset |= *data;
+		if ( label_len > p_len )
+			{
+			analyzer->Weird("DNS_label_len_gt_pkt");
+			p += p_len; // consume the rest of the packet
+			p_len = 0;
+			break;
+			}
 
-		++data;
-		--len;
+		if ( label_len > 63 &&
+		     // NetBIOS name service look ups can use longer labels.
+		     ntohs(analyzer->Conn()->RespPort()) != 137 )
+			{
+			analyzer->Weird("DNS_label_too_long");
+			break;
+			}
 
-		if ( offset >= orig_data - msg_start )
+		if ( label_len >= name_len )
 			{
-			// (You'd think that actually the offset should be
-			//  at least 6 bytes below our current position:
-			//  2 bytes for a non-trivial label, plus 4 bytes for
-			//  its class and type, which presumably are between
-			//  our current location and the instance of the label.
-			//  But actually this turns out not to be the case -
-			//  sometimes compression points to compression.)
-
-			analyzer->Weird("DNS_label_forward_compress_offset");
-			return false;
+			analyzer->Weird("DNS_label_len_gt_name_len");
+			break;
 			}
 
-		// Recursively resolve name.
-		const u_char* recurse_data = msg_start + offset;
-		int recurse_max_len = orig_data - recurse_data;
+		// Convert labels to lower case for consistency.
+		if ( lower )
+			for ( int i = 0; i < label_len; ++i )
+				name[i] = isupper(p[i]) ? tolower(p[i]) : p[i];
+		else
+			memcpy(name, p, label_len);
 
-		u_char* name_end = ExtractName(recurse_data, recurse_max_len, name, name_len, msg_start);
+		name[label_len] = '.';
 
-		name_len -= name_end - name;
-		name = name_end;
+		name += label_len + 1;
+		name_len -= label_len + 1;
 
-		return false;
+		p += label_len;
+		p_len -= label_len;
 		}
 
-	if ( label_len > len )
+	if ( ! followed_pointer )
 		{
-		analyzer->Weird("DNS_label_len_gt_pkt");
-		data += len; // consume the rest of the packet
-		len = 0;
-		return false;
+		data = p;
+		len = p_len;
 		}
 
-	if ( label_len > 63 &&
-	     // NetBIOS name service look ups can use longer labels.
-	     ntohs(analyzer->Conn()->RespPort()) != 137 )
+	// Finish the segments from the innermost outwards.
+	for ( int i = num_segments - 1; i >= 0; --i )
 		{
-		analyzer->Weird("DNS_label_too_long");
-		return false;
+		int n = name - segment_start[i];
+
+		if ( n >= 255 )
+			analyzer->Weird("DNS_NAME_too_long");
+
+		if ( n >= 2 && name[-1] == '.' )
+			{
+			// Remove trailing dot.
+			--name;
+			name[0] = 0;
+			}
 		}
 
-	if ( label_len >= name_len )
+	return name;
+	}
+
+StringValPtr DNS_Interpreter::NameVal(const u_char* name, const u_char* name_end)
+	{
+	// Shared across all connections. Constructed on first use, at which
+	// point the script-level size is known.
+	static DNS_NameCache name_cache(BifConst::dns_name_cache_size);
+	return name_cache.Get(name, name_end - name);
+	}
+
+StringValPtr DNS_NameCache::Get(const u_char* name, int len)
+	{
+	if ( max_entries == 0 )
+		return make_intrusive<StringVal>(new String(name, len, true));
+
+	std::string_view key(reinterpret_cast<const char*>(name), len);
+
+	if ( auto it = index.find(key); it != index.end() )
 		{
-		analyzer->Weird("DNS_label_len_gt_name_len");
-		return false;
+		lru.splice(lru.begin(), lru, it->second);
+		return *it->second;
 		}
 
-	memcpy(name, data, label_len);
-	name[label_len] = '.';
+	auto val = make_intrusive<StringVal>(new String(name, len, true));
 
-	name += label_len + 1;
-	name_len -= label_len + 1;
+	lru.push_front(val);
+	index.emplace(std::string_view(reinterpret_cast<const char*>(val->Bytes()), val->Len()),
+	              lru.begin());
 
-	data += label_len;
-	len -= label_len;
+	if ( lru.size() > max_entries )
+		{
+		const auto& oldest = lru.back();
+		index.erase(std::string_view(reinterpret_cast<const char*>(oldest->Bytes()),
+		                             oldest->Len()));
+		lru.pop_back();
+		}
 
-	return true;
+	return val;
 	}
 
 uint16_t DNS_Interpreter::ExtractShort(const u_char*& data, int& len)
@@ -569,9 +661,8 @@ bool DNS_Interpreter::ParseRR_Name(detail::DNS_MsgInfo* msg, const u_char*& data
 		}
 
 	if ( reply_event && ! msg->skip_event )
-		analyzer->EnqueueConnEvent(
-			reply_event, analyzer->ConnVal(), msg->BuildHdrVal(), msg->BuildAnswerVal(),
-			make_intrusive<StringVal>(new String(name, name_end - name, true)));
+		analyzer->EnqueueConnEvent(reply_event, analyzer->ConnVal(), msg->BuildHdrVal(),
+		                           msg->BuildAnswerVal(), NameVal(name, name_end));
 
 	return true;
 	}
@@ -611,8 +702,8 @@ bool DNS_Interpreter::ParseRR_SOA(detail::DNS_MsgInfo* msg, const u_char*& data,
 		{
 		static auto dns_soa = id::find_type<RecordType>("dns_soa");
 		auto r = make_intrusive<RecordVal>(dns_soa);
-		r->Assign(0, new String(mname, mname_end - mname, true));
-		r->Assign(1, new String(rname, rname_end - rname, true));
+		r->Assign(0, NameVal(mname, mname_end));
+		r->Assign(1, NameVal(rname, rname_end));
 		r->Assign(2, serial);
 		r->AssignInterval(3, double(refresh));
 		r->AssignInterval(4, double(retry));
@@ -644,10 +735,9 @@ bool DNS_Interpreter::ParseRR_MX(detail::DNS_MsgInfo* msg, const u_char*& data,
 		analyzer->Weird("DNS_RR_length_mismatch");
 
 	if ( dns_MX_reply && ! msg->skip_event )
-		analyzer->EnqueueConnEvent(
-			dns_MX_reply, analyzer->ConnVal(), msg->BuildHdrVal(), msg->BuildAnswerVal(),
-			make_intrusive<StringVal>(new String(name, name_end - name, true)),
-			val_mgr->Count(preference));
+		analyzer->EnqueueConnEvent(dns_MX_reply, analyzer->ConnVal(), msg->BuildHdrVal(),
+		                           msg->BuildAnswerVal(), NameVal(name, name_end),
+		                           val_mgr->Count(preference));
 
 	return true;
 	}
@@ -680,10 +770,10 @@ bool DNS_Interpreter::ParseRR_SRV(detail::DNS_MsgInfo* msg, const u_char*& data,
 		analyzer->Weird("DNS_RR_length_mismatch");
 
 	if ( dns_SRV_reply && ! msg->skip_event )
-		analyzer->EnqueueConnEvent(
-			dns_SRV_reply, analyzer->ConnVal(), msg->BuildHdrVal(), msg->BuildAnswerVal(),
-			make_intrusive<StringVal>(new String(name, name_end - name, true)),
-			val_mgr->Count(priority), val_mgr->Count(weight), val_mgr->Count(port));
+		analyzer->EnqueueConnEvent(dns_SRV_reply, analyzer->ConnVal(), msg->BuildHdrVal(),
+		                           msg->BuildAnswerVal(), NameVal(name, name_end),
+		                           val_mgr->Count(priority), val_mgr->Count(weight),
+		                           val_mgr->Count(port));
 
 	return true;
 	}
@@ -750,7 +840,7 @@ bool DNS_Interpreter::ParseRR_EDNS(detail::DNS_MsgInfo* msg, const u_char*& data
 						break;
 						}
 
-					opt.ecs_family = make_intrusive<StringVal>("v4");
+					opt.ecs_family = val_mgr->InternedString("v4");
 					uint32_t addr = 0;
 					uint16_t shift_factor = 3;
 					int bits_left = opt.ecs_src_pfx_len;
@@ -786,7 +876,7 @@ bool DNS_Interpreter::ParseRR_EDNS(detail::DNS_MsgInfo* msg, const u_char*& data
 						break;
 						}
 
-					opt.ecs_family = make_intrusive<StringVal>("v6");
+					opt.ecs_family = val_mgr->InternedString("v6");
 					uint32_t addr[4] = {0};
 					uint16_t shift_factor = 15;
 					int bits_left = opt.ecs_src_pfx_len;
@@ -1197,10 +1287,9 @@ bool DNS_Interpreter::ParseRR_NSEC(detail::DNS_MsgInfo* msg, const u_char*& data
 		}
 
 	if ( dns_NSEC )
-		analyzer->EnqueueConnEvent(
-			dns_NSEC, analyzer->ConnVal(), msg->BuildHdrVal(), msg->BuildAnswerVal(),
-			make_intrusive<StringVal>(new String(name, name_end - name, true)),
-			std::move(char_strings));
+		analyzer->EnqueueConnEvent(dns_NSEC, analyzer->ConnVal(), msg->BuildHdrVal(),
+		                           msg->BuildAnswerVal(), NameVal(name, name_end),
+		                           std::move(char_strings));
 
 	return true;
 	}
@@ -1514,9 +1603,17 @@ bool DNS_Interpreter::ParseRR_A(detail::DNS_MsgInfo* msg, const u_char*& data, i
 
 	uint32_t addr = ExtractLong(data, len);
 
-	if ( dns_A_reply && ! msg->skip_event )
+	if ( (! dns_A_reply && ! addr_replies) || msg->skip_event )
+		return true;
+
+	auto a = make_intrusive<AddrVal>(htonl(addr));
+
+	if ( addr_replies )
+		AddAddrReply(msg, a);
+
+	if ( dns_A_reply )
 		analyzer->EnqueueConnEvent(dns_A_reply, analyzer->ConnVal(), msg->BuildHdrVal(),
-		                           msg->BuildAnswerVal(), make_intrusive<AddrVal>(htonl(addr)));
+		                           msg->BuildAnswerVal(), std::move(a));
 
 	return true;
 	}
@@ -1546,9 +1643,17 @@ bool DNS_Interpreter::ParseRR_AAAA(detail::DNS_MsgInfo* msg, const u_char*& data
 	else
 		event = dns_A6_reply;
 
-	if ( event && ! msg->skip_event )
+	if ( (! event && ! addr_replies) || msg->skip_event )
+		return true;
+
+	auto a = make_intrusive<AddrVal>(addr);
+
+	if ( addr_replies )
+		AddAddrReply(msg, a);
+
+	if ( event )
 		analyzer->EnqueueConnEvent(event, analyzer->ConnVal(), msg->BuildHdrVal(),
-		                           msg->BuildAnswerVal(), make_intrusive<AddrVal>(addr));
+		                           msg->BuildAnswerVal(), std::move(a));
 
 	return true;
 	}
@@ -1663,6 +1768,12 @@ bool DNS_Interpreter::ParseRR_SPF(detail::DNS_MsgInfo* msg, const u_char*& data,
 	return rdlength == 0;
 	}
 
+// CAA tags come from the peer. Only the registered ones get interned, so that
+// others can't take up the shared table of interned strings.
+static const std::unordered_set<std::string_view> caa_tags = {
+	"issue", "issuewild", "iodef", "issuemail", "contactemail", "contactphone"
+};
+
 bool DNS_Interpreter::ParseRR_CAA(detail::DNS_MsgInfo* msg, const u_char*& data, int& len,
                                   int rdlength, const u_char* msg_start)
 	{
@@ -1693,10 +1804,17 @@ bool DNS_Interpreter::ParseRR_CAA(detail::DNS_MsgInfo* msg, const u_char*& data,
 	rdlength -= value->Len();
 
 	if ( dns_CAA_reply )
+		{
+		std::string_view tag_str{reinterpret_cast<const char*>(tag->Bytes()),
+		                         static_cast<size_t>(tag->Len())};
+		auto tag_val = caa_tags.count(tag_str) ? val_mgr->InternedString(tag_str)
+		                                       : make_intrusive<StringVal>(tag_str);
+		delete tag;
+
 		analyzer->EnqueueConnEvent(dns_CAA_reply, analyzer->ConnVal(), msg->BuildHdrVal(),
 		                           msg->BuildAnswerVal(), val_mgr->Count(flags),
-		                           make_intrusive<StringVal>(tag),
-		                           make_intrusive<StringVal>(value));
+		                           std::move(tag_val), make_intrusive<StringVal>(value));
+		}
 	else
 		{
 		delete tag;
@@ -1765,8 +1883,8 @@ bool DNS_Interpreter::ParseRR_SVCB(detail::DNS_MsgInfo* msg, const u_char*& data
 	}
 
 void DNS_Interpreter::SendReplyOrRejectEvent(detail::DNS_MsgInfo* msg, EventHandlerPtr event,
-                                             const u_char*& data, int& len, String* question_name,
-                                             String* original_name)
+                                             const u_char*& data, int& len,
+                                             StringValPtr question_name, StringValPtr original_name)
 	{
 	detail::RR_Type qtype = detail::RR_Type(ExtractShort(data, len));
 	int qclass = ExtractShort(data, len);
@@ -1774,8 +1892,8 @@ void DNS_Interpreter::SendReplyOrRejectEvent(detail::DNS_MsgInfo* msg, EventHand
 	assert(event);
 
 	analyzer->EnqueueConnEvent(event, analyzer->ConnVal(), msg->BuildHdrVal(),
-	                           make_intrusive<StringVal>(question_name), val_mgr->Count(qtype),
-	                           val_mgr->Count(qclass), make_intrusive<StringVal>(original_name));
+	                           std::move(question_name), val_mgr->Count(qtype),
+	                           val_mgr->Count(qclass), std::move(original_name));
 	}
 
 DNS_MsgInfo::DNS_MsgInfo(DNS_RawMsgHdr* hdr, int arg_is_query)
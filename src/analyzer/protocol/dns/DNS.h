@@ -2,6 +2,11 @@
 
 #pragma once
 
+#include <list>
+#include <string_view>
+#include <unordered_map>
+
+#include "zeek/EventBatch.h"
 #include "zeek/analyzer/protocol/tcp/TCP.h"
 #include "zeek/binpac_zeek.h"
 
@@ -343,6 +348,49 @@ public:
 	///< for forward lookups
 	};
 
+/**
+ * A bounded LRU cache of normalized domain names. Popular names recur in
+ * most DNS messages; interning them lets all events referring to the same
+ * name share one StringVal rather than allocating a copy per message.
+ */
+class DNS_NameCache
+	{
+public:
+	/**
+	 * Constructor.
+	 *
+	 * @param max_entries  The maximum number of names to keep. Zero
+	 * disables interning.
+	 */
+	explicit DNS_NameCache(size_t max_entries) : max_entries(max_entries) { }
+
+	/**
+	 * Returns the StringVal holding a given name, creating and caching it
+	 * if needed.
+	 *
+	 * @param name  The name's bytes.
+	 *
+	 * @param len  The name's length.
+	 *
+	 * @return The (possibly shared) value.
+	 */
+	StringValPtr Get(const u_char* name, int len);
+
+	/**
+	 * @return The number of cached names.
+	 */
+	size_t Size() const { return lru.size(); }
+
+private:
+	using EntryList = std::list<StringValPtr>;
+
+	// Most recently used names are at the front. The index keys refer
+	// to the bytes of the cached values themselves.
+	EntryList lru;
+	std::unordered_map<std::string_view, EntryList::iterator> index;
+	size_t max_entries;
+	};
+
 class DNS_Interpreter
 	{
 public:
@@ -355,6 +403,10 @@ public:
 protected:
 	void EndMessage(detail::DNS_MsgInfo* msg);
 
+	// Adds an address record to the message's dns_addr_replies batch.
+	void AddAddrReply(detail::DNS_MsgInfo* msg, AddrValPtr addr);
+	void FlushAddrReplies(detail::DNS_MsgInfo* msg);
+
 	bool ParseQuestions(detail::DNS_MsgInfo* msg, const u_char*& data, int& len,
 	                    const u_char* start);
 	bool ParseAnswers(detail::DNS_MsgInfo* msg, int n, detail::DNS_AnswerType answer_type,
@@ -366,8 +418,10 @@ protected:
 
 	u_char* ExtractName(const u_char*& data, int& len, u_char* label, int label_len,
 	                    const u_char* msg_start, bool downcase = true);
-	bool ExtractLabel(const u_char*& data, int& len, u_char*& label, int& label_len,
-	                  const u_char* msg_start);
+
+	// Returns the value for a name produced by ExtractName(), shared
+	// through the process-wide name cache.
+	StringValPtr NameVal(const u_char* name, const u_char* name_end);
 
 	uint16_t ExtractShort(const u_char*& data, int& len);
 	uint32_t ExtractLong(const u_char*& data, int& len);
@@ -422,11 +476,12 @@ protected:
 	bool ParseRR_SVCB(detail::DNS_MsgInfo* msg, const u_char*& data, int& len, int rdlength,
 	                  const u_char* msg_start, const RR_Type& svcb_type);
 	void SendReplyOrRejectEvent(detail::DNS_MsgInfo* msg, EventHandlerPtr event,
-	                            const u_char*& data, int& len, String* question_name,
-	                            String* original_name);
+	                            const u_char*& data, int& len, StringValPtr question_name,
+	                            StringValPtr original_name);
 
 	analyzer::Analyzer* analyzer;
 	bool first_message;
+	EventBatch addr_replies;
 	};
 
 enum TCP_DNS_state
@@ -32,9 +32,11 @@ void File_Analyzer::DeliverStream(int len, const u_char* data, bool orig)
 		}
 
 	if ( orig )
-		file_id_orig = file_mgr->DataIn(data, len, GetAnalyzerTag(), Conn(), orig, file_id_orig);
+		file_id_orig = file_mgr->DataIn(data, len, GetAnalyzerTag(), Conn(), orig, file_id_orig,
+		                                "", &file_ref_orig);
 	else
-		file_id_resp = file_mgr->DataIn(data, len, GetAnalyzerTag(), Conn(), orig, file_id_resp);
+		file_id_resp = file_mgr->DataIn(data, len, GetAnalyzerTag(), Conn(), orig, file_id_resp,
+		                                "", &file_ref_resp);
 	}
 
 void File_Analyzer::Undelivered(uint64_t seq, int len, bool orig)
@@ -5,6 +5,7 @@
 #include <string>
 
 #include "zeek/analyzer/protocol/tcp/TCP.h"
+#include "zeek/file_analysis/FileRef.h"
 
 namespace zeek::analyzer::file
 	{
@@ -31,6 +32,8 @@ protected:
 	int buffer_len = 0;
 	std::string file_id_orig;
 	std::string file_id_resp;
+	file_analysis::FileRef file_ref_orig;
+	file_analysis::FileRef file_ref_resp;
 	};
 
 class IRC_Data : public File_Analyzer
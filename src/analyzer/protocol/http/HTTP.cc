@@ -9,6 +9,8 @@
 #include <cmath>
 #include <cstdlib>
 #include <string>
+#include <string_view>
+#include <unordered_set>
 
 #include "zeek/Event.h"
 #include "zeek/NetVar.h"
@@ -324,7 +326,8 @@ void HTTP_Entity::SubmitData(int len, const char* buf)
 		precomputed_file_id = file_mgr->DataIn(reinterpret_cast<const u_char*>(buf), len, offset,
 		                                       http_message->MyHTTP_Analyzer()->GetAnalyzerTag(),
 		                                       http_message->MyHTTP_Analyzer()->Conn(),
-		                                       http_message->IsOrig(), precomputed_file_id);
+		                                       http_message->IsOrig(), precomputed_file_id, "",
+		                                       &file_ref);
 
 		offset += len;
 		}
@@ -339,7 +342,8 @@ void HTTP_Entity::SubmitData(int len, const char* buf)
 		precomputed_file_id = file_mgr->DataIn(reinterpret_cast<const u_char*>(buf), len,
 		                                       http_message->MyHTTP_Analyzer()->GetAnalyzerTag(),
 		                                       http_message->MyHTTP_Analyzer()->Conn(),
-		                                       http_message->IsOrig(), precomputed_file_id);
+		                                       http_message->IsOrig(), precomputed_file_id, "",
+		                                       &file_ref);
 		}
 
 	send_size = false;
@@ -1264,6 +1268,90 @@ static const char* get_HTTP_token(const char* s, const char* e)
 	return s;
 	}
 
+// Methods, versions and reason phrases come from the peer. Only the common
+// ones get interned, so that others can't take up the table of interned
+// strings, which is shared and of limited size.
+static const std::unordered_set<std::string_view> common_methods = {
+	"GET",
+	"HEAD",
+	"POST",
+	"PUT",
+	"DELETE",
+	"CONNECT",
+	"OPTIONS",
+	"TRACE",
+	"PATCH",
+	"PROPFIND",
+	"PROPPATCH",
+	"MKCOL",
+	"COPY",
+	"MOVE",
+	"LOCK",
+	"UNLOCK",
+};
+
+static const std::unordered_set<std::string_view> common_versions = {
+	"0.9",
+	"1.0",
+	"1.1",
+	"2.0",
+};
+
+static const std::unordered_set<std::string_view> common_reason_phrases = {
+	"Continue",
+	"Switching Protocols",
+	"OK",
+	"Created",
+	"Accepted",
+	"Non-Authoritative Information",
+	"No Content",
+	"Reset Content",
+	"Partial Content",
+	"Multiple Choices",
+	"Moved Permanently",
+	"Moved Temporarily",
+	"Found",
+	"See Other",
+	"Not Modified",
+	"Temporary Redirect",
+	"Permanent Redirect",
+	"Bad Request",
+	"Unauthorized",
+	"Forbidden",
+	"Not Found",
+	"Method Not Allowed",
+	"Not Acceptable",
+	"Proxy Authentication Required",
+	"Request Timeout",
+	"Conflict",
+	"Gone",
+	"Length Required",
+	"Precondition Failed",
+	"Request Entity Too Large",
+	"Payload Too Large",
+	"Request-URI Too Long",
+	"URI Too Long",
+	"Unsupported Media Type",
+	"Requested Range Not Satisfiable",
+	"Range Not Satisfiable",
+	"Too Many Requests",
+	"Internal Server Error",
+	"Not Implemented",
+	"Bad Gateway",
+	"Service Unavailable",
+	"Gateway Timeout",
+	"HTTP Version Not Supported",
+};
+
+static StringValPtr common_string_val(std::string_view s,
+                                      const std::unordered_set<std::string_view>& common)
+	{
+	if ( common.count(s) )
+		return val_mgr->InternedString(s);
+
+	return make_intrusive<StringVal>(s);
+	}
+
 int HTTP_Analyzer::HTTP_RequestLine(const char* line, const char* end_of_line)
 	{
 	const char* rest = nullptr;
@@ -1303,7 +1391,8 @@ int HTTP_Analyzer::HTTP_RequestLine(const char* line, const char* end_of_line)
 			goto error;
 		}
 
-	request_method = make_intrusive<StringVal>(end_of_method - line, line);
+	request_method = common_string_val({line, static_cast<size_t>(end_of_method - line)},
+	                                   common_methods);
 
 	Conn()->Match(zeek::detail::Rule::HTTP_REQUEST,
 	              (const u_char*)unescaped_URI->AsString()->Bytes(),
@@ -1452,17 +1541,19 @@ void HTTP_Analyzer::HTTP_Request()
 		// DEBUG_MSG("%.6f http_request\n", run_state::network_time);
 		EnqueueConnEvent(http_request, ConnVal(), request_method, TruncateURI(request_URI),
 		                 TruncateURI(unescaped_URI),
-		                 make_intrusive<StringVal>(util::fmt("%.1f", request_version.ToDouble())));
+		                 common_string_val(util::fmt("%.1f", request_version.ToDouble()),
+		                                   common_versions));
 	}
 
 void HTTP_Analyzer::HTTP_Reply()
 	{
 	if ( http_reply )
 		EnqueueConnEvent(http_reply, ConnVal(),
-		                 make_intrusive<StringVal>(util::fmt("%.1f", reply_version.ToDouble())),
+		                 common_string_val(util::fmt("%.1f", reply_version.ToDouble()),
+		                                   common_versions),
 		                 val_mgr->Count(reply_code),
 		                 reply_reason_phrase ? reply_reason_phrase
-		                                     : make_intrusive<StringVal>("<empty>"));
+		                                     : val_mgr->InternedString("<empty>"));
 	else
 		reply_reason_phrase = nullptr;
 	}
@@ -1596,7 +1687,8 @@ int HTTP_Analyzer::HTTP_ReplyLine(const char* line, const char* end_of_line)
 		}
 
 	rest = util::skip_whitespace(rest, end_of_line);
-	reply_reason_phrase = make_intrusive<StringVal>(end_of_line - rest, (const char*)rest);
+	reply_reason_phrase = common_string_val(
+		{(const char*)rest, static_cast<size_t>(end_of_line - rest)}, common_reason_phrases);
 
 	return 1;
 	}
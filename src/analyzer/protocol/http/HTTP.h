@@ -10,6 +10,7 @@
 #include "zeek/analyzer/protocol/tcp/TCP.h"
 #include "zeek/analyzer/protocol/zip/ZIP.h"
 #include "zeek/binpac_zeek.h"
+#include "zeek/file_analysis/FileRef.h"
 
 namespace zeek::analyzer::http
 	{
@@ -76,6 +77,7 @@ protected:
 	int64_t instance_length; // total length indicated by content-range
 	bool send_size; // whether to send size indication to FAF
 	std::string precomputed_file_id;
+	file_analysis::FileRef file_ref;
 
 	analyzer::mime::MIME_Entity* NewChildEntity() override
 		{
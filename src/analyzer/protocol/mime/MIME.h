@@ -9,6 +9,7 @@
 #include "zeek/Reporter.h"
 #include "zeek/ZeekString.h"
 #include "zeek/analyzer/Analyzer.h"
+#include "zeek/file_analysis/FileRef.h"
 
 namespace zeek
 	{
@@ -275,6 +276,7 @@ protected:
 
 	uint64_t cur_entity_len;
 	std::string cur_entity_id;
+	file_analysis::FileRef cur_entity_ref;
 	};
 
 extern bool is_null_data_chunk(data_chunk_t b);
@@ -318,7 +318,7 @@ struct val_converter
 				list_val->Append(std::move(index_val));
 				}
 
-			auto value_val = data_to_val(move(item.second), tt->Yield().get());
+			auto value_val = move_data_to_val(item.second, tt->Yield().get());
 
 			if ( ! value_val )
 				return nullptr;
@@ -338,7 +338,7 @@ struct val_converter
 
 			for ( auto& item : a )
 				{
-				auto item_val = data_to_val(move(item), vt->Yield().get());
+				auto item_val = move_data_to_val(item, vt->Yield().get());
 
 				if ( ! item_val )
 					return nullptr;
@@ -364,8 +364,8 @@ struct val_converter
 			unsigned int pos = 0;
 			for ( auto& item : a )
 				{
-				auto item_val = data_to_val(move(item),
-				                            pure ? lt->GetPureType().get() : types[pos].get());
+				auto item_val = move_data_to_val(item,
+				                                 pure ? lt->GetPureType().get() : types[pos].get());
 				pos++;
 
 				if ( ! item_val )
@@ -441,7 +441,7 @@ struct val_converter
 					continue;
 					}
 
-				auto item_val = data_to_val(move(a[idx]), rt->GetFieldType(i).get());
+				auto item_val = move_data_to_val(a[idx], rt->GetFieldType(i).get());
 
 				if ( ! item_val )
 					return nullptr;
@@ -812,6 +812,11 @@ static bool data_type_check(const broker::data& d, Type* t)
 	}
 
 ValPtr data_to_val(broker::data d, Type* type)
+	{
+	return move_data_to_val(d, type);
+	}
+
+ValPtr move_data_to_val(broker::data& d, Type* type)
 	{
 	if ( type->Tag() == TYPE_ANY )
 		return make_data_val(move(d));
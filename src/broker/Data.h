@@ -73,6 +73,18 @@ broker::expected<broker::data> val_to_data(const Val* v);
  */
 ValPtr data_to_val(broker::data d, Type* type);
 
+/**
+ * Convert a Broker data value to a Zeek value like data_to_val(), but
+ * without copying the data first. The data's contents may move into the
+ * new value, so it's left in a valid but unspecified state, except that
+ * it and any directly contained elements keep their types.
+ * @param d a Broker data value.
+ * @param type the expected type of the value to return.
+ * @return a pointer to a new Zeek value or a nullptr if the conversion was not
+ * possible.
+ */
+ValPtr move_data_to_val(broker::data& d, Type* type);
+
 /**
  * Convert a zeek::threading::Field to a Broker data value.
  * @param f a zeek::threading::Field.
@@ -684,6 +684,51 @@ bool Manager::PublishEvent(string topic, RecordVal* args)
 	return PublishEvent(std::move(topic), event_name, std::move(xs));
 	}
 
+bool Manager::PublishEvent(string topic, ValPList* args, zeek::detail::Frame* frame)
+	{
+	scoped_reporter_location srl{frame};
+	broker::vector xs;
+	xs.reserve(args->length());
+
+	// Without anyone to send to, only check the arguments.
+	bool sending = ! bstate->endpoint.is_shutdown() && peer_count > 0;
+
+	auto convert = [sending, &xs](int i, Val* v)
+	{
+		if ( ! sending )
+			return true;
+
+		if ( same_type(v->GetType(), detail::DataVal::ScriptDataType()) )
+			{
+			const auto& data_val = v->AsRecordVal()->GetField(0);
+
+			if ( ! data_val )
+				return false;
+
+			xs.emplace_back(static_cast<detail::DataVal*>(data_val.get())->data);
+			return true;
+			}
+
+		auto data = detail::val_to_data(v);
+
+		if ( ! data )
+			return false;
+
+		xs.emplace_back(std::move(*data));
+		return true;
+	};
+
+	auto name = ConvertEventArgs(args, convert);
+
+	if ( ! sending )
+		return true;
+
+	if ( ! name )
+		return false;
+
+	return PublishEvent(std::move(topic), name, std::move(xs));
+	}
+
 bool Manager::PublishIdentifier(std::string topic, std::string id)
 	{
 	if ( bstate->endpoint.is_shutdown() )
@@ -978,76 +1023,87 @@ bool Manager::AutoUnpublishEvent(const string& topic, Val* event)
 	return true;
 	}
 
-RecordVal* Manager::MakeEvent(ValPList* args, zeek::detail::Frame* frame)
+const char* Manager::ConvertEventArgs(ValPList* args,
+                                     const std::function<bool(int, Val*)>& convert)
 	{
-	auto rval = new RecordVal(BifType::Record::Broker::Event);
-	auto arg_vec = make_intrusive<VectorVal>(vector_of_data_type);
-	rval->Assign(1, arg_vec);
-	Func* func = nullptr;
-	scoped_reporter_location srl{frame};
+	if ( args->length() == 0 )
+		return nullptr;
 
-	for ( auto i = 0; i < args->length(); ++i )
-		{
-		auto arg_val = (*args)[i];
+	// Event val must come first.
+	auto arg_val = (*args)[0];
 
-		if ( i == 0 )
-			{
-			// Event val must come first.
-
-			if ( arg_val->GetType()->Tag() != TYPE_FUNC )
-				{
-				Error("attempt to convert non-event into an event type");
-				return rval;
-				}
+	if ( arg_val->GetType()->Tag() != TYPE_FUNC )
+		{
+		Error("attempt to convert non-event into an event type");
+		return nullptr;
+		}
 
-			func = arg_val->AsFunc();
+	Func* func = arg_val->AsFunc();
 
-			if ( func->Flavor() != FUNC_FLAVOR_EVENT )
-				{
-				Error("attempt to convert non-event into an event type");
-				return rval;
-				}
+	if ( func->Flavor() != FUNC_FLAVOR_EVENT )
+		{
+		Error("attempt to convert non-event into an event type");
+		return nullptr;
+		}
 
-			auto num_args = func->GetType()->Params()->NumFields();
+	auto num_args = func->GetType()->Params()->NumFields();
 
-			if ( num_args != args->length() - 1 )
-				{
-				Error("bad # of arguments: got %d, expect %d", args->length(), num_args + 1);
-				return rval;
-				}
+	if ( num_args != args->length() - 1 )
+		{
+		Error("bad # of arguments: got %d, expect %d", args->length(), num_args + 1);
+		return nullptr;
+		}
 
-			rval->Assign(0, func->Name());
-			continue;
-			}
+	const auto& expected_types = func->GetType()->ParamList()->GetTypes();
 
+	for ( auto i = 1; i < args->length(); ++i )
+		{
 		const auto& got_type = (*args)[i]->GetType();
-		const auto& expected_type = func->GetType()->ParamList()->GetTypes()[i - 1];
+		const auto& expected_type = expected_types[i - 1];
 
 		if ( ! same_type(got_type, expected_type) )
 			{
-			rval->Remove(0);
 			Error("event parameter #%d type mismatch, got %s, expect %s", i,
 			      type_name(got_type->Tag()), type_name(expected_type->Tag()));
-			return rval;
+			return nullptr;
 			}
 
+		if ( ! convert(i - 1, (*args)[i]) )
+			{
+			Error("failed to convert param #%d of type %s to broker data", i,
+			      type_name(got_type->Tag()));
+			return nullptr;
+			}
+		}
+
+	return func->Name();
+	}
+
+RecordVal* Manager::MakeEvent(ValPList* args, zeek::detail::Frame* frame)
+	{
+	auto rval = new RecordVal(BifType::Record::Broker::Event);
+	auto arg_vec = make_intrusive<VectorVal>(vector_of_data_type);
+	rval->Assign(1, arg_vec);
+	scoped_reporter_location srl{frame};
+
+	auto convert = [&arg_vec](int i, Val* v)
+	{
 		RecordValPtr data_val;
 
-		if ( same_type(got_type, detail::DataVal::ScriptDataType()) )
-			data_val = {NewRef{}, (*args)[i]->AsRecordVal()};
+		if ( same_type(v->GetType(), detail::DataVal::ScriptDataType()) )
+			data_val = {NewRef{}, v->AsRecordVal()};
 		else
-			data_val = detail::make_data_val((*args)[i]);
+			data_val = detail::make_data_val(v);
 
 		if ( ! data_val->HasField(0) )
-			{
-			rval->Remove(0);
-			Error("failed to convert param #%d of type %s to broker data", i,
-			      type_name(got_type->Tag()));
-			return rval;
-			}
+			return false;
 
-		arg_vec->Assign(i - 1, std::move(data_val));
-		}
+		arg_vec->Assign(i, std::move(data_val));
+		return true;
+	};
+
+	if ( auto name = ConvertEventArgs(args, convert) )
+		rval->Assign(0, name);
 
 	return rval;
 	}
@@ -1440,7 +1496,7 @@ void Manager::ProcessEvent(const broker::topic& topic, broker::zeek::Event ev)
 		{
 		auto got_type = args[i].get_type_name();
 		const auto& expected_type = arg_types[i];
-		auto val = detail::data_to_val(args[i], expected_type.get());
+		auto val = detail::move_data_to_val(args[i], expected_type.get());
 
 		if ( val )
 			vl.emplace_back(std::move(val));
@@ -9,6 +9,7 @@
 #include <broker/error.hh>
 #include <broker/peer_info.hh>
 #include <broker/zeek.hh>
+#include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -198,6 +199,20 @@ public:
 	 */
 	bool PublishEvent(std::string topic, RecordVal* ev);
 
+	/**
+	 * Send an event to any interested peers. Unlike going through
+	 * MakeEvent(), this converts the arguments straight into the message,
+	 * without wrapping each into a Broker::Data record first.
+	 * @param topic a topic string associated with the message.
+	 * Peers advertise interest by registering a subscription to some prefix
+	 * of this topic name.
+	 * @param args the event and its arguments.  The event is always the
+	 * first element in the list.
+	 * @param frame the calling frame, used to report location info upon error
+	 * @return true if the message is sent successfully.
+	 */
+	bool PublishEvent(std::string topic, ValPList* args, zeek::detail::Frame* frame);
+
 	/**
 	 * Send a message to create a log stream to any interested peers.
 	 * The log stream may or may not already exist on the receiving side.
@@ -425,6 +440,10 @@ private:
 	                                   const broker::data& key, const broker::data& data,
 	                                   const broker::data& old_value, bool insert);
 	void ProcessEvent(const broker::topic& topic, broker::zeek::Event ev);
+	// Checks that the list holds an event and matching arguments, and passes
+	// each argument with its index to a function, which returns false if it
+	// can't convert it. Returns the event's name, or null upon errors.
+	const char* ConvertEventArgs(ValPList* args, const std::function<bool(int, Val*)>& convert);
 	bool ProcessLogCreate(broker::zeek::LogCreate lc);
 	bool ProcessLogWrite(broker::zeek::LogWrite lw);
 	bool ProcessIdentifierUpdate(broker::zeek::IdentifierUpdate iu);
@@ -2,6 +2,7 @@
 
 #include "zeek/file_analysis/File.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "zeek/Event.h"
@@ -108,6 +109,40 @@ File::~File()
 
 	for ( auto a : done_analyzers )
 		delete a;
+
+	ReleaseRefs();
+	}
+
+void File::ReleaseRefs()
+	{
+	for ( auto* r : refs )
+		r->file = nullptr;
+
+	refs.clear();
+	}
+
+void FileRef::Set(File* f)
+	{
+	if ( f == file )
+		return;
+
+	Reset();
+
+	if ( f )
+		{
+		file = f;
+		file->refs.push_back(this);
+		}
+	}
+
+void FileRef::Reset()
+	{
+	if ( ! file )
+		return;
+
+	auto& refs = file->refs;
+	refs.erase(std::remove(refs.begin(), refs.end(), this), refs.end());
+	file = nullptr;
 	}
 
 void File::UpdateLastActivityTime()
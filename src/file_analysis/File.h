@@ -5,6 +5,7 @@
 #include <list>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "zeek/Tag.h"
 #include "zeek/WeirdState.h"
@@ -12,6 +13,7 @@
 #include "zeek/ZeekList.h" // for ValPList
 #include "zeek/ZeekString.h"
 #include "zeek/file_analysis/AnalyzerSet.h"
+#include "zeek/file_analysis/FileRef.h"
 
 namespace zeek
 	{
@@ -210,6 +212,7 @@ public:
 protected:
 	friend class Manager;
 	friend class FileReassembler;
+	friend class FileRef;
 
 	/**
 	 * Constructor; only file_analysis::Manager should be creating these.
@@ -239,6 +242,11 @@ protected:
 	 */
 	void RaiseFileOverNewConnection(Connection* conn, bool is_orig);
 
+	/**
+	 * Clears all FileRef objects currently referring to this file.
+	 */
+	void ReleaseRefs();
+
 	/**
 	 * Increment a byte count field of #val record by \a size.
 	 * @param size number of bytes by which to increment.
@@ -334,6 +342,7 @@ protected:
 	detail::AnalyzerSet analyzers; /**< A set of attached file analyzers. */
 	std::list<Analyzer*> done_analyzers; /**< Analyzers we're done with, remembered here until they
 	                                        can be safely deleted. */
+	std::vector<FileRef*> refs; /**< References to clear once the file goes away. */
 
 	struct BOF_Buffer
 		{
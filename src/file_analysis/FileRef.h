@@ -0,0 +1,50 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#pragma once
+
+namespace zeek::file_analysis
+	{
+
+class File;
+
+/**
+ * A weak reference to a File object. Protocol analyzers that deliver a
+ * file's content in many chunks can hold one and pass it to
+ * Manager::DataIn(), which then uses the referenced file directly instead
+ * of looking it up by ID for every chunk.
+ *
+ * The reference is cleared automatically when the file gets ignored or
+ * removed from the manager.
+ */
+class FileRef
+	{
+public:
+	FileRef() = default;
+	~FileRef() { Reset(); }
+
+	FileRef(const FileRef&) = delete;
+	FileRef& operator=(const FileRef&) = delete;
+
+	/**
+	 * @return the referenced file, or a null pointer if there is none.
+	 */
+	File* Get() const { return file; }
+
+	/**
+	 * Makes this refer to a given file.
+	 * @param f the file, or a null pointer to clear the reference.
+	 */
+	void Set(File* f);
+
+	/**
+	 * Clears the reference.
+	 */
+	void Reset();
+
+private:
+	friend class File;
+
+	File* file = nullptr;
+	};
+
+	} // namespace zeek::file_analysis
@@ -3,6 +3,7 @@
 #include "zeek/file_analysis/Manager.h"
 
 #include <openssl/md5.h>
+#include <algorithm>
 
 #include "zeek/Event.h"
 #include "zeek/UID.h"
@@ -55,6 +56,9 @@ void Manager::Terminate()
 	for ( const auto& entry : id_map )
 		keys.push_back(entry.first);
 
+	// Time out files in a deterministic order.
+	std::sort(keys.begin(), keys.end());
+
 	for ( const string& key : keys )
 		Timeout(key, true);
 
@@ -89,10 +93,10 @@ void Manager::SetHandle(const string& handle)
 
 string Manager::DataIn(const u_char* data, uint64_t len, uint64_t offset, const zeek::Tag& tag,
                        Connection* conn, bool is_orig, const string& precomputed_id,
-                       const string& mime_type)
+                       const string& mime_type, FileRef* file_ref)
 	{
 	string id = precomputed_id.empty() ? GetFileID(tag, conn, is_orig) : precomputed_id;
-	File* file = GetFile(id, conn, tag, is_orig);
+	File* file = GetFile(id, conn, tag, is_orig, true, nullptr, file_ref);
 
 	if ( ! file )
 		return "";
@@ -118,12 +122,13 @@ string Manager::DataIn(const u_char* data, uint64_t len, uint64_t offset, const
 	}
 
 string Manager::DataIn(const u_char* data, uint64_t len, const zeek::Tag& tag, Connection* conn,
-                       bool is_orig, const string& precomputed_id, const string& mime_type)
+                       bool is_orig, const string& precomputed_id, const string& mime_type,
+                       FileRef* file_ref)
 	{
 	string id = precomputed_id.empty() ? GetFileID(tag, conn, is_orig) : precomputed_id;
 	// Sequential data input shouldn't be going over multiple conns, so don't
 	// do the check to update connection set.
-	File* file = GetFile(id, conn, tag, is_orig, false);
+	File* file = GetFile(id, conn, tag, is_orig, false, nullptr, file_ref);
 
 	if ( ! file )
 		return "";
@@ -304,11 +309,24 @@ bool Manager::RemoveAnalyzer(const string& file_id, const zeek::Tag& tag, Record
 	}
 
 File* Manager::GetFile(const string& file_id, Connection* conn, const zeek::Tag& tag, bool is_orig,
-                       bool update_conn, const char* source_name)
+                       bool update_conn, const char* source_name, FileRef* file_ref)
 	{
 	if ( file_id.empty() )
 		return nullptr;
 
+	if ( file_ref && file_ref->Get() && file_ref->Get()->GetID() == file_id )
+		{
+		// References are cleared when their file gets ignored or removed,
+		// so this is still the active file for the ID.
+		File* rval = file_ref->Get();
+		rval->UpdateLastActivityTime();
+
+		if ( update_conn && rval->UpdateConnectionFields(conn, is_orig) )
+			rval->RaiseFileOverNewConnection(conn, is_orig);
+
+		return rval;
+		}
+
 	if ( IsIgnored(file_id) )
 		return nullptr;
 
@@ -343,6 +361,9 @@ File* Manager::GetFile(const string& file_id, Connection* conn, const zeek::Tag&
 			rval->RaiseFileOverNewConnection(conn, is_orig);
 		}
 
+	if ( file_ref )
+		file_ref->Set(rval);
+
 	return rval;
 	}
 
@@ -381,12 +402,15 @@ void Manager::Timeout(const string& file_id, bool is_terminating)
 
 bool Manager::IgnoreFile(const string& file_id)
 	{
-	if ( ! LookupFile(file_id) )
+	File* file = LookupFile(file_id);
+
+	if ( ! file )
 		return false;
 
 	DBG_LOG(DBG_FILE_ANALYSIS, "Ignore FileID %s", file_id.c_str());
 
 	ignored.insert(file_id);
+	file->ReleaseRefs();
 	return true;
 	}
 
@@ -2,14 +2,16 @@
 
 #pragma once
 
-#include <map>
 #include <set>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "zeek/RuleMatcher.h"
 #include "zeek/RunState.h"
 #include "zeek/Tag.h"
 #include "zeek/file_analysis/Component.h"
+#include "zeek/file_analysis/FileRef.h"
 #include "zeek/file_analysis/FileTimer.h"
 #include "zeek/plugin/ComponentManager.h"
 
@@ -104,6 +106,9 @@ public:
 	 *        disabled.
 	 *        This parameter only has any effect for the first DataIn call of each
 	 *        file. It is ignored for all subsequent calls.
+	 * @param file_ref may be set to a reference kept by the caller across calls.
+	 *        It is pointed to the file the data belongs to, so that subsequent
+	 *        calls for the same file skip looking it up.
 	 * @return a unique file ID string which, in certain contexts, may be
 	 *         cached and passed back into a subsequent function call in order
 	 *         to avoid costly file handle lookups (which have to go through
@@ -112,7 +117,7 @@ public:
 	 */
 	std::string DataIn(const u_char* data, uint64_t len, uint64_t offset, const zeek::Tag& tag,
 	                   Connection* conn, bool is_orig, const std::string& precomputed_file_id = "",
-	                   const std::string& mime_type = "");
+	                   const std::string& mime_type = "", FileRef* file_ref = nullptr);
 
 	/**
 	 * Pass in sequential file data.
@@ -130,6 +135,9 @@ public:
 	 *        the protocol. If this parameter is give, mime type detection will be
 	 *        disabled.
 	 *        This parameter is only used for the first bit of data for each file.
+	 * @param file_ref may be set to a reference kept by the caller across calls.
+	 *        It is pointed to the file the data belongs to, so that subsequent
+	 *        calls for the same file skip looking it up.
 	 * @return a unique file ID string which, in certain contexts, may be
 	 *         cached and passed back into a subsequent function call in order
 	 *         to avoid costly file handle lookups (which have to go through
@@ -138,7 +146,7 @@ public:
 	 */
 	std::string DataIn(const u_char* data, uint64_t len, const zeek::Tag& tag, Connection* conn,
 	                   bool is_orig, const std::string& precomputed_file_id = "",
-	                   const std::string& mime_type = "");
+	                   const std::string& mime_type = "", FileRef* file_ref = nullptr);
 
 	/**
 	 * Pass in sequential file data from external source (e.g. input framework).
@@ -370,6 +378,9 @@ protected:
 	 * @param update_conn whether we need to update connection-related field
 	 *        in the \c fa_file record value associated with the file.
 	 * @param an optional value of the source field to fill in.
+	 * @param file_ref an optional reference to a previously returned File
+	 *        object. If it refers to the file with ID \a file_id, that file is
+	 *        used without a lookup; otherwise it is set to the result.
 	 * @return the File object mapped to \a file_id or a null pointer if
 	 *         analysis is being ignored for the associated file.  An File
 	 *         object may be created if a mapping doesn't exist, and if it did
@@ -378,7 +389,8 @@ protected:
 	 */
 	File* GetFile(const std::string& file_id, Connection* conn = nullptr,
 	              const zeek::Tag& tag = zeek::Tag::Error, bool is_orig = false,
-	              bool update_conn = true, const char* source_name = nullptr);
+	              bool update_conn = true, const char* source_name = nullptr,
+	              FileRef* file_ref = nullptr);
 
 	/**
 	 * Evaluate timeout policy for a file and remove the File object mapped to
@@ -421,12 +433,12 @@ protected:
 
 private:
 	using TagSet = std::set<Tag>;
-	using MIMEMap = std::map<std::string, TagSet*>;
+	using MIMEMap = std::unordered_map<std::string, TagSet*>;
 
 	TagSet* LookupMIMEType(const std::string& mtype, bool add_if_not_found);
 
-	std::map<std::string, File*> id_map; /**< Map file ID to file_analysis::File records. */
-	std::set<std::string> ignored; /**< Ignored files.  Will be finally removed on EOF. */
+	std::unordered_map<std::string, File*> id_map; /**< Map file ID to File objects. */
+	std::unordered_set<std::string> ignored; /**< Ignored files.  Will be finally removed on EOF. */
 	std::string current_file_id; /**< Hash of what get_file_handle event sets. */
 	zeek::detail::RuleFileMagicState* magic_state; /**< File magic signature match state. */
 	MIMEMap mime_types; /**< Mapping of MIME types to analyzers. */
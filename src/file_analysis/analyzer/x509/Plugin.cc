@@ -5,6 +5,7 @@
 #include "zeek/file_analysis/Component.h"
 #include "zeek/file_analysis/analyzer/x509/OCSP.h"
 #include "zeek/file_analysis/analyzer/x509/X509.h"
+#include "zeek/file_analysis/analyzer/x509/consts.bif.h"
 
 namespace zeek::plugin::detail::Zeek_X509
 	{
@@ -27,6 +28,13 @@ public:
 		return config;
 		}
 
+	void InitPostScript() override
+		{
+		zeek::file_analysis::detail::X509::Cache().SetLimits(
+			zeek::BifConst::X509::native_cache_max_entries,
+			zeek::BifConst::X509::native_cache_max_bytes);
+		}
+
 	void Done() override
 		{
 		zeek::plugin::Plugin::Done();
@@ -45,14 +45,20 @@ bool X509::Undelivered(uint64_t offset, uint64_t len)
 bool X509::EndOfFile()
 	{
 	const unsigned char* cert_char = reinterpret_cast<const unsigned char*>(cert_data.data());
-	if ( certificate_cache )
+	std::string cert_sha256;
+
+	if ( certificate_cache || native_cache.Enabled() )
 		{
-		// first step - let's see if the certificate has been cached.
 		unsigned char buf[SHA256_DIGEST_LENGTH];
 		auto ctx = zeek::detail::hash_init(zeek::detail::Hash_SHA256);
 		zeek::detail::hash_update(ctx, cert_char, cert_data.size());
 		zeek::detail::hash_final(ctx, buf);
-		std::string cert_sha256 = zeek::detail::sha256_digest_print(buf);
+		cert_sha256 = zeek::detail::sha256_digest_print(buf);
+		}
+
+	if ( certificate_cache )
+		{
+		// first step - let's see if the certificate has been cached.
 		auto index = make_intrusive<StringVal>(cert_sha256);
 		const auto& entry = certificate_cache->Find(index);
 
@@ -70,19 +76,48 @@ bool X509::EndOfFile()
 			}
 		}
 
-	// ok, now we can try to parse the certificate with openssl. Should
-	// be rather straightforward...
-	::X509* ssl_cert = d2i_X509(NULL, &cert_char, cert_data.size());
-	if ( ! ssl_cert )
+	// Certificates seen before do not need to be parsed by OpenSSL again;
+	// the native cache hands out the same certificate and a copy of the
+	// record extracted from it.
+	RecordValPtr cert_record;
+	::X509* ssl_cert = nullptr;
+
+	if ( ! cert_sha256.empty() )
+		ssl_cert = native_cache.LookupCertificate(cert_sha256, &cert_record);
+
+	X509Val* cert_val = nullptr;
+
+	if ( ssl_cert )
 		{
-		reporter->Weird(GetFile(), "x509_cert_parse_error");
-		return false;
+		cert_val = new X509Val(ssl_cert); // cert_val takes ownership of the cache's reference
+
+		// The cached record came from another file. Parsing the validity
+		// times again, which is cheap, raises the weirds about them for
+		// this one, as ParseCertificate() would have.
+		GetTimeFromAsn1(X509_get_notBefore(ssl_cert), GetFile(), reporter);
+		GetTimeFromAsn1(X509_get_notAfter(ssl_cert), GetFile(), reporter);
 		}
 
-	X509Val* cert_val = new X509Val(ssl_cert); // cert_val takes ownership of ssl_cert
+	else
+		{
+		// ok, now we can try to parse the certificate with openssl. Should
+		// be rather straightforward...
+		ssl_cert = d2i_X509(NULL, &cert_char, cert_data.size());
+		if ( ! ssl_cert )
+			{
+			reporter->Weird(GetFile(), "x509_cert_parse_error");
+			return false;
+			}
+
+		cert_val = new X509Val(ssl_cert); // cert_val takes ownership of ssl_cert
 
-	// parse basic information into record.
-	auto cert_record = ParseCertificate(cert_val, GetFile());
+		// parse basic information into record.
+		cert_record = ParseCertificate(cert_val, GetFile());
+
+		if ( ! cert_sha256.empty() )
+			native_cache.InsertCertificate(cert_sha256, ssl_cert, cert_record.get(),
+			                               cert_data.size());
+		}
 
 	// and send the record on to scriptland
 	if ( x509_certificate )
@@ -298,6 +333,8 @@ X509_STORE* X509::GetRootStore(TableVal* root_certs)
 
 void X509::FreeRootStore()
 	{
+	native_cache.Clear();
+
 	for ( const auto& e : x509_stores )
 		X509_STORE_free(e.second);
 	}
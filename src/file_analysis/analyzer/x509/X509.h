@@ -7,6 +7,7 @@
 
 #include "zeek/Func.h"
 #include "zeek/OpaqueVal.h"
+#include "zeek/file_analysis/analyzer/x509/X509Cache.h"
 #include "zeek/file_analysis/analyzer/x509/X509Common.h"
 
 #if ( OPENSSL_VERSION_NUMBER < 0x10002000L ) || defined(LIBRESSL_VERSION_NUMBER)
@@ -30,6 +31,8 @@
 
 #define OCSP_SINGLERESP_get0_id(s) (s)->certId
 
+#define X509_up_ref(x) CRYPTO_add(&(x)->references, 1, CRYPTO_LOCK_X509)
+
 static X509* X509_OBJECT_get0_X509(const X509_OBJECT* a)
 	{
 	if ( a == nullptr || a->type != X509_LU_X509 )
@@ -128,6 +131,13 @@ public:
 		cache_hit_callback = std::move(func);
 		}
 
+	/**
+	 * Returns the native cache of parsed certificates and chain
+	 * verification results. Its limits are taken from
+	 * \c X509::native_cache_max_entries and \c X509::native_cache_max_bytes.
+	 */
+	static X509Cache& Cache() { return native_cache; }
+
 protected:
 	X509(RecordValPtr args, file_analysis::File* file);
 
@@ -145,6 +155,7 @@ private:
 	inline static std::map<Val*, X509_STORE*> x509_stores = std::map<Val*, X509_STORE*>();
 	inline static TableValPtr certificate_cache = nullptr;
 	inline static FuncPtr cache_hit_callback = nullptr;
+	inline static X509Cache native_cache;
 	};
 
 /**
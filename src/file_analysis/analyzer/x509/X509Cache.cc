@@ -0,0 +1,282 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek/file_analysis/analyzer/x509/X509Cache.h"
+
+#include <openssl/asn1.h>
+#include <openssl/evp.h>
+#include <algorithm>
+#include <limits>
+
+#include "zeek/Val.h"
+#include "zeek/file_analysis/analyzer/x509/X509.h"
+
+namespace zeek::file_analysis::detail
+	{
+
+// Rough per-entry bookkeeping overhead (entry, list node, index node).
+constexpr size_t ENTRY_OVERHEAD = 256;
+
+// The parsed representation of a certificate plus its record are
+// estimated as a multiple of the DER length.
+constexpr size_t CERT_SIZE_FACTOR = 4;
+
+void X509Cache::SetLimits(size_t arg_max_entries, size_t arg_max_bytes)
+	{
+	max_entries = arg_max_entries;
+	max_bytes = arg_max_bytes;
+
+	if ( Enabled() )
+		Evict();
+	else
+		Clear();
+	}
+
+::X509* X509Cache::LookupCertificate(const std::string& fingerprint, RecordValPtr* record)
+	{
+	if ( ! Enabled() )
+		return nullptr;
+
+	auto it = certs.find(fingerprint);
+	if ( it == certs.end() )
+		{
+		++stats.cert_misses;
+		return nullptr;
+		}
+
+	++stats.cert_hits;
+	lru.splice(lru.begin(), lru, it->second);
+
+	const auto& e = *it->second;
+	*record = cast_intrusive<RecordVal>(e.record->Clone());
+	X509_up_ref(e.cert);
+
+	return e.cert;
+	}
+
+void X509Cache::InsertCertificate(const std::string& fingerprint, ::X509* cert,
+                                  RecordVal* record, size_t der_len)
+	{
+	if ( ! Enabled() || ! cert || ! record )
+		return;
+
+	Entry e;
+	e.key = fingerprint;
+	e.size = ENTRY_OVERHEAD + fingerprint.size() + CERT_SIZE_FACTOR * der_len;
+	e.cert = cert;
+	X509_up_ref(cert);
+	e.record = cast_intrusive<RecordVal>(record->Clone());
+
+	Insert(std::move(e));
+	}
+
+bool X509Cache::VerificationKey(const X509_STORE* store, const std::vector<::X509*>& chain,
+                                std::string* key)
+	{
+	key->clear();
+	key->reserve(sizeof(store) + chain.size() * EVP_MAX_MD_SIZE);
+	key->append(reinterpret_cast<const char*>(&store), sizeof(store));
+
+	for ( auto* c : chain )
+		{
+		unsigned char md[EVP_MAX_MD_SIZE];
+		unsigned int len = 0;
+
+		if ( ! c || ! X509_digest(c, EVP_sha256(), md, &len) )
+			return false;
+
+		key->append(reinterpret_cast<const char*>(md), len);
+		}
+
+	return true;
+	}
+
+const X509Cache::VerifyResult* X509Cache::LookupVerification(const std::string& key,
+                                                             double verify_time)
+	{
+	if ( ! Enabled() )
+		return nullptr;
+
+	auto it = verifications.find(key);
+	if ( it == verifications.end() )
+		{
+		++stats.verify_misses;
+		return nullptr;
+		}
+
+	const auto& e = *it->second;
+	if ( verify_time < e.valid_from || verify_time > e.valid_until )
+		{
+		// The outcome may differ at this point in time; leave the entry
+		// for the caller to replace.
+		++stats.verify_misses;
+		return nullptr;
+		}
+
+	++stats.verify_hits;
+	lru.splice(lru.begin(), lru, it->second);
+
+	return &it->second->verify_result;
+	}
+
+void X509Cache::InsertVerification(const std::string& key, const std::vector<::X509*>& chain,
+                                   const VerifyResult& result)
+	{
+	if ( ! Enabled() )
+		return;
+
+	switch ( result.result )
+		{
+		case X509_V_ERR_CERT_NOT_YET_VALID:
+		case X509_V_ERR_CERT_HAS_EXPIRED:
+		case X509_V_ERR_CRL_NOT_YET_VALID:
+		case X509_V_ERR_CRL_HAS_EXPIRED:
+		case X509_V_ERR_ERROR_IN_CERT_NOT_BEFORE_FIELD:
+		case X509_V_ERR_ERROR_IN_CERT_NOT_AFTER_FIELD:
+			// Depends on the verification time in ways that the
+			// validity window of the given chain does not capture
+			// (e.g., an expired root).
+			return;
+
+		default:
+			break;
+		}
+
+	Entry e;
+	e.key = key;
+	e.is_verification = true;
+
+	if ( ! ValidityWindow(chain, &e.valid_from, &e.valid_until) )
+		return;
+
+	if ( ! result.chain.empty() )
+		{
+		// The resulting chain includes the trust anchor, which is
+		// bounded by its own validity.
+		double from, until;
+		if ( ! ValidityWindow(result.chain, &from, &until) )
+			return;
+
+		e.valid_from = std::max(e.valid_from, from);
+		e.valid_until = std::min(e.valid_until, until);
+		}
+
+	e.verify_result.result = result.result;
+	e.verify_result.result_string = result.result_string;
+	e.verify_result.chain = result.chain;
+
+	for ( auto* c : e.verify_result.chain )
+		X509_up_ref(c);
+
+	e.size = ENTRY_OVERHEAD + key.size() + e.verify_result.result_string.size() +
+	         e.verify_result.chain.size() * sizeof(::X509*);
+
+	Insert(std::move(e));
+	}
+
+void X509Cache::Clear()
+	{
+	for ( auto& e : lru )
+		ReleaseEntry(e);
+
+	lru.clear();
+	certs.clear();
+	verifications.clear();
+	stats.entries = 0;
+	stats.bytes = 0;
+	}
+
+void X509Cache::Insert(Entry&& e)
+	{
+	auto& index = e.is_verification ? verifications : certs;
+
+	if ( auto it = index.find(e.key); it != index.end() )
+		Remove(it->second);
+
+	stats.bytes += e.size;
+	++stats.entries;
+
+	lru.push_front(std::move(e));
+	index.emplace(lru.front().key, lru.begin());
+
+	Evict();
+	}
+
+void X509Cache::Remove(EntryList::iterator it)
+	{
+	auto& index = it->is_verification ? verifications : certs;
+	index.erase(it->key);
+
+	stats.bytes -= it->size;
+	--stats.entries;
+
+	ReleaseEntry(*it);
+	lru.erase(it);
+	}
+
+void X509Cache::Evict()
+	{
+	while ( ! lru.empty() && (stats.entries > max_entries || stats.bytes > max_bytes) )
+		{
+		Remove(std::prev(lru.end()));
+		++stats.evictions;
+		}
+	}
+
+void X509Cache::ReleaseEntry(Entry& e)
+	{
+	if ( e.cert )
+		{
+		X509_free(e.cert);
+		e.cert = nullptr;
+		}
+
+	for ( auto* c : e.verify_result.chain )
+		X509_free(c);
+
+	e.verify_result.chain.clear();
+	e.record = nullptr;
+	}
+
+bool X509Cache::ValidityWindow(const std::vector<::X509*>& chain, double* from, double* until)
+	{
+	ASN1_TIME* epoch = ASN1_TIME_set(nullptr, 0);
+	if ( ! epoch )
+		return false;
+
+	auto to_double = [epoch](const ASN1_TIME* t, double* out)
+	{
+		int days = 0;
+		int secs = 0;
+
+		if ( ! t || ! ASN1_TIME_diff(&days, &secs, epoch, t) )
+			return false;
+
+		*out = days * 86400.0 + secs;
+		return true;
+	};
+
+	bool ok = ! chain.empty();
+	*from = 0.0;
+	*until = std::numeric_limits<double>::max();
+
+	for ( auto* c : chain )
+		{
+		double not_before, not_after;
+
+		if ( ! to_double(X509_get_notBefore(c), &not_before) ||
+		     ! to_double(X509_get_notAfter(c), &not_after) )
+			{
+			ok = false;
+			break;
+			}
+
+		*from = std::max(*from, not_before);
+		*until = std::min(*until, not_after);
+		}
+
+	ASN1_TIME_free(epoch);
+
+	return ok && *from <= *until;
+	}
+
+	} // namespace zeek::file_analysis::detail
@@ -0,0 +1,208 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#pragma once
+
+#include <openssl/x509.h>
+#include <openssl/x509_vfy.h>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "zeek/IntrusivePtr.h"
+
+namespace zeek
+	{
+
+class RecordVal;
+using RecordValPtr = IntrusivePtr<RecordVal>;
+
+namespace file_analysis::detail
+	{
+
+/**
+ * A memory-bounded LRU cache holding parsed X509 certificates and the
+ * outcome of certificate chain verifications.
+ *
+ * Certificates are keyed by the SHA256 fingerprint of their DER encoding
+ * and keep both the OpenSSL representation and the \c X509::Certificate
+ * record extracted from it. Verification results are keyed by the root
+ * store and the fingerprints of the chain that was verified; they are only
+ * reused while the verification time falls into the window during which all
+ * involved certificates are valid.
+ *
+ * The cache is disabled until SetLimits() is called with non-zero limits.
+ */
+class X509Cache
+	{
+public:
+	/**
+	 * Counters describing the effectiveness and size of the cache.
+	 */
+	struct Stats
+		{
+		uint64_t cert_hits = 0;
+		uint64_t cert_misses = 0;
+		uint64_t verify_hits = 0;
+		uint64_t verify_misses = 0;
+		uint64_t evictions = 0;
+		size_t entries = 0;
+		size_t bytes = 0;
+		};
+
+	/**
+	 * The cached outcome of a chain verification.
+	 */
+	struct VerifyResult
+		{
+		int result = 0;
+		std::string result_string;
+		// The verified chain, empty if verification failed. The
+		// certificates are owned by the cache entry.
+		std::vector<::X509*> chain;
+		};
+
+	X509Cache() = default;
+	~X509Cache() { Clear(); }
+
+	X509Cache(const X509Cache&) = delete;
+	X509Cache& operator=(const X509Cache&) = delete;
+
+	/**
+	 * Sets the bounds of the cache and evicts entries until they hold.
+	 * Setting either bound to zero disables the cache.
+	 *
+	 * @param max_entries  The maximum number of cached entries.
+	 *
+	 * @param max_bytes  The maximum estimated memory held by the cache.
+	 */
+	void SetLimits(size_t max_entries, size_t max_bytes);
+
+	/**
+	 * @return True if the cache accepts entries.
+	 */
+	bool Enabled() const { return max_entries > 0 && max_bytes > 0; }
+
+	/**
+	 * Looks up a parsed certificate.
+	 *
+	 * @param fingerprint  The SHA256 fingerprint of the certificate's DER
+	 * encoding.
+	 *
+	 * @param record  Set to a copy of the cached \c X509::Certificate record
+	 * on a hit.
+	 *
+	 * @return The cached certificate with a new reference that the caller
+	 * owns, or null if it is not cached.
+	 */
+	::X509* LookupCertificate(const std::string& fingerprint, RecordValPtr* record);
+
+	/**
+	 * Adds a parsed certificate to the cache.
+	 *
+	 * @param fingerprint  The SHA256 fingerprint of the certificate's DER
+	 * encoding.
+	 *
+	 * @param cert  The certificate. The cache takes its own reference.
+	 *
+	 * @param record  The record extracted from the certificate. The cache
+	 * keeps a copy, so later modifications by scripts are not visible.
+	 *
+	 * @param der_len  The length of the certificate's DER encoding, used to
+	 * estimate the entry's memory footprint.
+	 */
+	void InsertCertificate(const std::string& fingerprint, ::X509* cert, RecordVal* record,
+	                       size_t der_len);
+
+	/**
+	 * Computes the key identifying the verification of a certificate chain
+	 * against a root store.
+	 *
+	 * @param store  The root store used for verification.
+	 *
+	 * @param certs  The chain to verify, host certificate first.
+	 *
+	 * @param key  Set to the resulting key.
+	 *
+	 * @return False if a certificate fingerprint could not be computed.
+	 */
+	static bool VerificationKey(const X509_STORE* store, const std::vector<::X509*>& certs,
+	                            std::string* key);
+
+	/**
+	 * Looks up the result of a previous chain verification.
+	 *
+	 * @param key  The key returned by VerificationKey().
+	 *
+	 * @param verify_time  The time for which the chain is being verified.
+	 *
+	 * @return The cached result, or null if there is none that is valid at
+	 * \a verify_time. The pointer is valid until the cache is modified.
+	 */
+	const VerifyResult* LookupVerification(const std::string& key, double verify_time);
+
+	/**
+	 * Adds the result of a chain verification to the cache. Results that
+	 * depend on the verification time beyond the validity windows of the
+	 * involved certificates are not cached.
+	 *
+	 * @param key  The key returned by VerificationKey().
+	 *
+	 * @param certs  The chain that was verified.
+	 *
+	 * @param result  The outcome. The cache takes its own references to the
+	 * certificates in the resulting chain.
+	 */
+	void InsertVerification(const std::string& key, const std::vector<::X509*>& certs,
+	                        const VerifyResult& result);
+
+	/**
+	 * Removes all entries and releases the certificates they hold.
+	 */
+	void Clear();
+
+	/**
+	 * @return The cache's counters.
+	 */
+	const Stats& GetStats() const { return stats; }
+
+private:
+	struct Entry
+		{
+		std::string key;
+		bool is_verification = false;
+		size_t size = 0;
+
+		// Set for certificate entries.
+		::X509* cert = nullptr;
+		RecordValPtr record;
+
+		// Set for verification entries.
+		VerifyResult verify_result;
+		double valid_from = 0.0;
+		double valid_until = 0.0;
+		};
+
+	using EntryList = std::list<Entry>;
+	using Index = std::unordered_map<std::string, EntryList::iterator>;
+
+	void Insert(Entry&& e);
+	void Remove(EntryList::iterator it);
+	void Evict();
+
+	static void ReleaseEntry(Entry& e);
+	static bool ValidityWindow(const std::vector<::X509*>& certs, double* from, double* until);
+
+	// Most recently used entries are at the front.
+	EntryList lru;
+	Index certs;
+	Index verifications;
+
+	size_t max_entries = 0;
+	size_t max_bytes = 0;
+	Stats stats;
+	};
+
+	} // namespace file_analysis::detail
+	} // namespace zeek
@@ -2,7 +2,10 @@
 
 #include "zeek/input/Manager.h"
 
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 #include "zeek/CompHash.h"
@@ -38,6 +41,8 @@ struct InputHash
 	{
 	zeek::detail::hash_t valhash;
 	zeek::detail::HashKey* idxkey;
+	uint64_t chunk = 0; // The chunk of the source the entry came from, if tracked.
+	unsigned int chunk_refs = 0; // The number of tracked chunks listing the entry.
 	~InputHash();
 	};
 
@@ -103,12 +108,30 @@ public:
 	PDict<InputHash>* currDict;
 	PDict<InputHash>* lastDict;
 
+	// For readers that track their source in chunks, entries stay in
+	// lastDict across reads, and currDict remains unused. Instead, we keep
+	// the keys of the entries each chunk provided, and note which chunks
+	// were sent or kept since the last EndCurrentSend, and which keys came
+	// to be listed by more than one chunk meanwhile. Once a key turns out
+	// to be in two chunks, we ask the reader to stop sending chunks, and
+	// ignore what it sends until it starts its full read: reads it did
+	// in the meantime only cover the chunks that changed.
+	bool chunked;
+	bool chunks_stopped;
+	bool awaiting_full_read;
+	std::unordered_map<uint64_t, std::vector<std::unique_ptr<zeek::detail::HashKey>>> chunks;
+	std::unordered_set<uint64_t> sent_chunks;
+	std::vector<const zeek::detail::HashKey*> shared_keys;
+
 	Func* pred;
 
 	EventHandlerPtr event;
 
 	TableStream();
 	~TableStream() override;
+
+	// Notes that an entry came from a chunk, taking ownership of its key.
+	void AddToChunk(uint64_t chunk, zeek::detail::HashKey* key, InputHash* ih);
 	};
 
 class Manager::EventStream final : public Manager::Stream
@@ -135,10 +158,29 @@ public:
 
 Manager::TableStream::TableStream()
 	: Manager::Stream::Stream(TABLE_STREAM), num_idx_fields(), num_val_fields(), want_record(),
-	  tab(), rtype(), itype(), currDict(), lastDict(), pred(), event()
+	  tab(), rtype(), itype(), currDict(), lastDict(), chunked(), chunks_stopped(),
+	  awaiting_full_read(), pred(), event()
 	{
 	}
 
+void Manager::TableStream::AddToChunk(uint64_t chunk, zeek::detail::HashKey* key,
+                                      InputHash* ih)
+	{
+	// A chunk lists each key only once, however often it occurs there.
+	if ( ! chunk || ih->chunk == chunk )
+		{
+		delete key;
+		return;
+		}
+
+	ih->chunk = chunk;
+	auto& keys = chunks[chunk];
+	keys.emplace_back(key);
+
+	if ( ++ih->chunk_refs > 1 )
+		shared_keys.push_back(keys.back().get());
+	}
+
 Manager::EventStream::EventStream()
 	: Manager::Stream::Stream(EVENT_STREAM), event(), fields(), num_fields(), want_record()
 	{
@@ -1167,7 +1209,7 @@ void Manager::SendEntry(ReaderFrontend* reader, Value** vals)
 	Value::delete_value_ptr_array(vals, readFields);
 	}
 
-int Manager::SendEntryTable(Stream* i, const Value* const* vals)
+int Manager::SendEntryTable(Stream* i, const Value* const* vals, uint64_t chunk)
 	{
 	bool updated = false;
 
@@ -1206,6 +1248,13 @@ int Manager::SendEntryTable(Stream* i, const Value* const* vals)
 		// seen before
 		if ( stream->num_val_fields == 0 || h->valhash == valhash )
 			{
+			if ( chunk )
+				{
+				// exact duplicate, which now belongs to this chunk.
+				stream->AddToChunk(chunk, idxhash, h);
+				return stream->num_val_fields + stream->num_idx_fields;
+				}
+
 			// ok, exact duplicate, move entry to new dictionary and do nothing else.
 			stream->lastDict->Remove(idxhash);
 			stream->currDict->Insert(idxhash, h);
@@ -1278,8 +1327,12 @@ int Manager::SendEntryTable(Stream* i, const Value* const* vals)
 				else
 					{
 					// keep old one
-					stream->currDict->Insert(idxhash, h);
-					delete idxhash;
+					if ( chunk )
+						stream->lastDict->Insert(idxhash, h);
+					else
+						stream->currDict->Insert(idxhash, h);
+
+					stream->AddToChunk(chunk, idxhash, h);
 					return stream->num_val_fields + stream->num_idx_fields;
 					}
 				}
@@ -1287,6 +1340,9 @@ int Manager::SendEntryTable(Stream* i, const Value* const* vals)
 		}
 
 	// now we don't need h anymore - if we are here, the entry is updated and a new h is created.
+	// The new one takes over the chunks listing the entry.
+	uint64_t prev_chunk = h ? h->chunk : 0;
+	unsigned int prev_chunk_refs = h ? h->chunk_refs : 0;
 	delete h;
 	h = nullptr;
 
@@ -1328,15 +1384,17 @@ int Manager::SendEntryTable(Stream* i, const Value* const* vals)
 	InputHash* ih = new InputHash();
 	ih->idxkey = new zeek::detail::HashKey(k->Key(), k->Size(), k->Hash());
 	ih->valhash = valhash;
+	ih->chunk = prev_chunk;
+	ih->chunk_refs = prev_chunk_refs;
 
 	stream->tab->Assign({AdoptRef{}, idxval}, std::move(k), {AdoptRef{}, valval});
 
 	if ( predidx != nullptr )
 		Unref(predidx);
 
-	auto prev = stream->currDict->Insert(idxhash, ih);
+	auto prev = (chunk ? stream->lastDict : stream->currDict)->Insert(idxhash, ih);
 	delete prev;
-	delete idxhash;
+	stream->AddToChunk(chunk, idxhash, ih);
 
 	if ( stream->event )
 		{
@@ -1371,6 +1429,98 @@ int Manager::SendEntryTable(Stream* i, const Value* const* vals)
 	return stream->num_val_fields + stream->num_idx_fields;
 	}
 
+void Manager::SendChunk(ReaderFrontend* reader, uint64_t chunk, std::vector<Value**> rows)
+	{
+	Stream* i = FindStream(reader);
+
+	if ( i == nullptr )
+		{
+		reporter->InternalWarning("Unknown reader %s in SendChunk", reader->Name());
+
+		for ( auto vals : rows )
+			Value::delete_value_ptr_array(vals, reader->NumFields());
+
+		return;
+		}
+
+	if ( i->stream_type != TABLE_STREAM )
+		{
+		// Event streams just see the entries of the chunks that changed.
+		for ( auto vals : rows )
+			SendEntry(reader, vals);
+
+		return;
+		}
+
+	auto* stream = static_cast<TableStream*>(i);
+
+	if ( stream->awaiting_full_read )
+		{
+		for ( auto vals : rows )
+			Value::delete_value_ptr_array(vals, reader->NumFields());
+
+		return;
+		}
+
+	// Once a reader started its full read, it shouldn't send chunks
+	// anymore. If it does, we take them as plain entries.
+	if ( stream->chunks_stopped )
+		chunk = 0;
+	else
+		{
+		stream->chunked = true;
+		stream->sent_chunks.insert(chunk);
+		}
+
+	for ( auto vals : rows )
+		{
+		int readFields = SendEntryTable(i, vals, chunk);
+		Value::delete_value_ptr_array(vals, readFields);
+		}
+	}
+
+void Manager::KeepChunk(ReaderFrontend* reader, uint64_t chunk)
+	{
+	Stream* i = FindStream(reader);
+
+	if ( i == nullptr )
+		{
+		reporter->InternalWarning("Unknown reader %s in KeepChunk", reader->Name());
+		return;
+		}
+
+	if ( i->stream_type != TABLE_STREAM )
+		return;
+
+	auto* stream = static_cast<TableStream*>(i);
+
+	if ( stream->chunks_stopped )
+		return;
+
+	stream->chunked = true;
+	stream->sent_chunks.insert(chunk);
+	}
+
+void Manager::StartFullRead(ReaderFrontend* reader)
+	{
+	Stream* i = FindStream(reader);
+
+	if ( i == nullptr )
+		{
+		reporter->InternalWarning("Unknown reader %s in StartFullRead", reader->Name());
+		return;
+		}
+
+	if ( i->stream_type != TABLE_STREAM )
+		return;
+
+#ifdef DEBUG
+	DBG_LOG(DBG_INPUT, "Stream %s starts its full read", i->name.c_str());
+#endif
+
+	static_cast<TableStream*>(i)->awaiting_full_read = false;
+	}
+
 void Manager::EndCurrentSend(ReaderFrontend* reader)
 	{
 	Stream* i = FindStream(reader);
@@ -1398,53 +1548,35 @@ void Manager::EndCurrentSend(ReaderFrontend* reader)
 	assert(i->stream_type == TABLE_STREAM);
 	auto* stream = static_cast<TableStream*>(i);
 
+	// The end of a read that still only sent the chunks that changed.
+	if ( stream->awaiting_full_read )
+		return;
+
+	if ( stream->chunked )
+		{
+		// If the reader has to send everything again, the end of data
+		// comes with the EndCurrentSend that follows.
+		if ( EndCurrentSendChunked(stream) )
+			SendEndOfData(i);
+
+		return;
+		}
+
 	// lastdict contains all deleted entries and should be empty apart from that
 	for ( auto it = stream->lastDict->begin_robust(); it != stream->lastDict->end_robust(); ++it )
 		{
 		auto lastDictIdxKey = it->GetHashKey();
 		InputHash* ih = it->value;
 
-		ValPtr val;
-		ValPtr predidx;
-		EnumValPtr ev;
-		int startpos = 0;
-
-		if ( stream->pred || stream->event )
-			{
-			auto idx = stream->tab->RecreateIndex(*ih->idxkey);
-			assert(idx != nullptr);
-			val = stream->tab->FindOrDefault(idx);
-			assert(val != nullptr);
-			predidx = {AdoptRef{}, ListValToRecordVal(idx.get(), stream->itype, &startpos)};
-			ev = BifType::Enum::Input::Event->GetEnumVal(BifEnum::Input::EVENT_REMOVED);
-			}
-
-		if ( stream->pred )
-			{
-			// ask predicate, if we want to expire this element...
-
-			bool result = CallPred(stream->pred, 3, ev->Ref(), predidx->Ref(), val->Ref());
-
-			if ( result == false )
-				{
-				// Keep it. Hence - we quit and simply go to the next entry of lastDict
-				// ah well - and we have to add the entry to currDict...
-				stream->currDict->Insert(lastDictIdxKey.get(),
-				                         stream->lastDict->RemoveEntry(lastDictIdxKey.get()));
-				continue;
-				}
-			}
-
-		if ( stream->event )
+		if ( ! RemoveTableEntry(stream, ih) )
 			{
-			if ( stream->num_val_fields == 0 )
-				SendEvent(stream->event, 3, stream->description->Ref(), ev->Ref(), predidx->Ref());
-			else
-				SendEvent(stream->event, 4, stream->description->Ref(), ev->Ref(), predidx->Ref(),
-				          val->Ref());
+			// Keep it. Hence - we quit and simply go to the next entry of lastDict
+			// ah well - and we have to add the entry to currDict...
+			stream->currDict->Insert(lastDictIdxKey.get(),
+			                         stream->lastDict->RemoveEntry(lastDictIdxKey.get()));
+			continue;
 			}
 
-		stream->tab->Remove(*ih->idxkey);
 		stream->lastDict->Remove(lastDictIdxKey.get()); // delete in next line
 		delete ih;
 		}
@@ -1463,6 +1595,131 @@ void Manager::EndCurrentSend(ReaderFrontend* reader)
 	SendEndOfData(i);
 	}
 
+bool Manager::RemoveTableEntry(TableStream* stream, const InputHash* ih)
+	{
+	ValPtr val;
+	ValPtr predidx;
+	EnumValPtr ev;
+	int startpos = 0;
+
+	if ( stream->pred || stream->event )
+		{
+		auto idx = stream->tab->RecreateIndex(*ih->idxkey);
+		assert(idx != nullptr);
+		val = stream->tab->FindOrDefault(idx);
+		assert(val != nullptr);
+		predidx = {AdoptRef{}, ListValToRecordVal(idx.get(), stream->itype, &startpos)};
+		ev = BifType::Enum::Input::Event->GetEnumVal(BifEnum::Input::EVENT_REMOVED);
+		}
+
+	if ( stream->pred )
+		{
+		// ask predicate, if we want to expire this element...
+
+		bool result = CallPred(stream->pred, 3, ev->Ref(), predidx->Ref(), val->Ref());
+
+		if ( result == false )
+			return false;
+		}
+
+	if ( stream->event )
+		{
+		if ( stream->num_val_fields == 0 )
+			SendEvent(stream->event, 3, stream->description->Ref(), ev->Ref(), predidx->Ref());
+		else
+			SendEvent(stream->event, 4, stream->description->Ref(), ev->Ref(), predidx->Ref(),
+			          val->Ref());
+		}
+
+	stream->tab->Remove(*ih->idxkey);
+	return true;
+	}
+
+bool Manager::EndCurrentSendChunked(TableStream* stream)
+	{
+	// Chunks that are gone from the source no longer list their keys.
+	for ( const auto& [chunk, keys] : stream->chunks )
+		{
+		if ( ! chunk || stream->sent_chunks.count(chunk) )
+			continue;
+
+		for ( const auto& key : keys )
+			if ( InputHash* ih = stream->lastDict->Lookup(key.get()) )
+				--ih->chunk_refs;
+		}
+
+	// An entry has the value from the last chunk that sent it. With a key in
+	// more than one chunk, a full read may give it that of another one, the
+	// last in the source, and the key has to stay when its chunk goes away.
+	// We can't tell without seeing all of them, so we stop tracking chunks
+	// and have the reader send everything, to compare it in full as for
+	// other readers.
+	for ( const auto* key : stream->shared_keys )
+		{
+		InputHash* ih = stream->lastDict->Lookup(key);
+
+		if ( ! ih || ih->chunk_refs <= 1 )
+			continue;
+
+#ifdef DEBUG
+		DBG_LOG(DBG_INPUT, "Stream %s has keys in more than one chunk, rereading in full",
+		        stream->name.c_str());
+#endif
+
+		stream->chunked = false;
+		stream->chunks_stopped = true;
+		stream->awaiting_full_read = true;
+		stream->chunks.clear();
+		stream->sent_chunks.clear();
+		stream->shared_keys.clear();
+		stream->reader->StopChunks();
+		return false;
+		}
+
+	stream->shared_keys.clear();
+
+	// Only the entries of chunks that are gone from the source are candidates
+	// for removal, and only if they haven't shown up in another chunk since.
+	// Everything else stays as it is, without us having to look at it.
+	std::vector<std::unique_ptr<zeek::detail::HashKey>> vetoed;
+
+	for ( auto it = stream->chunks.begin(); it != stream->chunks.end(); )
+		{
+		if ( stream->sent_chunks.count(it->first) )
+			{
+			++it;
+			continue;
+			}
+
+		for ( auto& key : it->second )
+			{
+			InputHash* ih = stream->lastDict->Lookup(key.get());
+
+			if ( ! ih || ih->chunk != it->first )
+				continue;
+
+			if ( ! RemoveTableEntry(stream, ih) )
+				{
+				// Keep it, but without a chunk, so that the predicate gets
+				// asked again after the next read.
+				ih->chunk = 0;
+				vetoed.push_back(std::move(key));
+				continue;
+				}
+
+			delete stream->lastDict->Remove(key.get());
+			}
+
+		it = stream->chunks.erase(it);
+		}
+
+	if ( ! vetoed.empty() )
+		stream->chunks[0] = std::move(vetoed);
+
+	stream->sent_chunks.clear();
+	return true;
+	}
+
 void Manager::SendEndOfData(ReaderFrontend* reader)
 	{
 	Stream* i = FindStream(reader);
@@ -4,7 +4,9 @@
 
 #pragma once
 
+#include <cstdint>
 #include <map>
+#include <vector>
 
 #include "zeek/EventHandler.h"
 #include "zeek/Tag.h"
@@ -22,6 +24,7 @@ namespace input
 
 class ReaderFrontend;
 class ReaderBackend;
+struct InputHash;
 
 /**
  * Singleton class for managing input streams.
@@ -124,6 +127,10 @@ protected:
 	friend class DeleteMessage;
 	friend class ClearMessage;
 	friend class SendEntryMessage;
+	friend class SendEntriesMessage;
+	friend class SendChunkMessage;
+	friend class KeepChunkMessage;
+	friend class StartFullReadMessage;
 	friend class EndCurrentSendMessage;
 	friend class ReaderClosedMessage;
 	friend class DisableMessage;
@@ -146,6 +153,15 @@ protected:
 	void SendEntry(ReaderFrontend* reader, threading::Value** vals);
 	void EndCurrentSend(ReaderFrontend* reader);
 
+	// For readers that track their source in chunks, so that a reread
+	// only sends the chunks that changed. See ReaderBackend::SendChunk()
+	// and ReaderBackend::KeepChunk().
+	void SendChunk(ReaderFrontend* reader, uint64_t chunk, std::vector<threading::Value**> rows);
+	void KeepChunk(ReaderFrontend* reader, uint64_t chunk);
+	// Marks where a reader asked to stop sending chunks starts sending
+	// the whole source.
+	void StartFullRead(ReaderFrontend* reader);
+
 	// Instantiates a new ReaderBackend of the given type (note that
 	// doing so creates a new thread!).
 	ReaderBackend* CreateBackend(ReaderFrontend* frontend, EnumVal* tag);
@@ -193,8 +209,18 @@ private:
 	bool CheckErrorEventTypes(const std::string& stream_name, const Func* error_event,
 	                          bool table) const;
 
-	// SendEntry implementation for Table stream.
-	int SendEntryTable(Stream* i, const threading::Value* const* vals);
+	// SendEntry implementation for Table stream. A non-zero chunk is the
+	// chunk of the source that the entry comes from.
+	int SendEntryTable(Stream* i, const threading::Value* const* vals, uint64_t chunk = 0);
+
+	// Removes an entry that's no longer in the source from a table stream,
+	// unless the predicate vetoes it. Returns false in that case.
+	bool RemoveTableEntry(TableStream* stream, const InputHash* ih);
+
+	// EndCurrentSend implementation for table streams tracking chunks.
+	// Returns false if it asked the reader to send everything again
+	// instead, since a key appears in more than one chunk.
+	bool EndCurrentSendChunked(TableStream* stream);
 
 	// Put implementation for Table stream.
 	int PutTable(Stream* i, const threading::Value* const* vals);
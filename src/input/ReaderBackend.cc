@@ -104,6 +104,79 @@ private:
 	Value** val;
 	};
 
+class SendEntriesMessage final : public threading::OutputMessage<ReaderFrontend>
+	{
+public:
+	SendEntriesMessage(ReaderFrontend* reader, std::vector<Value**> rows)
+		: threading::OutputMessage<ReaderFrontend>("SendEntries", reader), rows(std::move(rows))
+		{
+		}
+
+	bool Process() override
+		{
+		for ( auto vals : rows )
+			input_mgr->SendEntry(Object(), vals);
+
+		return true;
+		}
+
+private:
+	std::vector<Value**> rows;
+	};
+
+class SendChunkMessage final : public threading::OutputMessage<ReaderFrontend>
+	{
+public:
+	SendChunkMessage(ReaderFrontend* reader, uint64_t chunk, std::vector<Value**> rows)
+		: threading::OutputMessage<ReaderFrontend>("SendChunk", reader), chunk(chunk),
+		  rows(std::move(rows))
+		{
+		}
+
+	bool Process() override
+		{
+		input_mgr->SendChunk(Object(), chunk, std::move(rows));
+		return true;
+		}
+
+private:
+	uint64_t chunk;
+	std::vector<Value**> rows;
+	};
+
+class KeepChunkMessage final : public threading::OutputMessage<ReaderFrontend>
+	{
+public:
+	KeepChunkMessage(ReaderFrontend* reader, uint64_t chunk)
+		: threading::OutputMessage<ReaderFrontend>("KeepChunk", reader), chunk(chunk)
+		{
+		}
+
+	bool Process() override
+		{
+		input_mgr->KeepChunk(Object(), chunk);
+		return true;
+		}
+
+private:
+	uint64_t chunk;
+	};
+
+class StartFullReadMessage final : public threading::OutputMessage<ReaderFrontend>
+	{
+public:
+	StartFullReadMessage(ReaderFrontend* reader)
+		: threading::OutputMessage<ReaderFrontend>("StartFullRead", reader)
+		{
+		}
+
+	bool Process() override
+		{
+		input_mgr->StartFullRead(Object());
+		return true;
+		}
+	};
+
 class EndCurrentSendMessage final : public threading::OutputMessage<ReaderFrontend>
 	{
 public:
@@ -245,6 +318,21 @@ void ReaderBackend::SendEntry(Value** vals)
 	SendOut(new SendEntryMessage(frontend, vals));
 	}
 
+void ReaderBackend::SendEntries(std::vector<Value**> rows)
+	{
+	SendOut(new SendEntriesMessage(frontend, std::move(rows)));
+	}
+
+void ReaderBackend::SendChunk(uint64_t chunk, std::vector<Value**> rows)
+	{
+	SendOut(new SendChunkMessage(frontend, chunk, std::move(rows)));
+	}
+
+void ReaderBackend::KeepChunk(uint64_t chunk)
+	{
+	SendOut(new KeepChunkMessage(frontend, chunk));
+	}
+
 bool ReaderBackend::Init(const int arg_num_fields, const threading::Field* const* arg_fields)
 	{
 	if ( Failed() )
@@ -304,6 +392,25 @@ bool ReaderBackend::Update()
 	return ! disabled; // always return failure if we have been disabled in the meantime
 	}
 
+bool ReaderBackend::StopChunks()
+	{
+	if ( disabled )
+		return false;
+
+	// Reads that were done before this one still sent chunks. Tell the
+	// manager where they end, and the full read begins.
+	SendOut(new StartFullReadMessage(frontend));
+
+	if ( Failed() )
+		return true;
+
+	bool success = DoStopChunks();
+	if ( ! success )
+		DisableFrontend();
+
+	return ! disabled;
+	}
+
 void ReaderBackend::DisableFrontend()
 	{
 	// We might already have been disabled - e.g., due to a call to
@@ -2,6 +2,9 @@
 
 #pragma once
 
+#include <cstdint>
+#include <vector>
+
 #include "zeek/ZeekString.h"
 #include "zeek/input/Component.h"
 #include "zeek/threading/MsgThread.h"
@@ -177,6 +180,14 @@ public:
 	 */
 	bool Update();
 
+	/**
+	 * Makes a reader that sends its source in chunks stop doing so, and
+	 * send the whole source again. See DoStopChunks().
+	 *
+	 * @return False if an error occurred.
+	 */
+	bool StopChunks();
+
 	/**
 	 * Disables the frontend that has instantiated this backend. Once
 	 * disabled, the frontend will not send any further message over.
@@ -290,6 +301,26 @@ protected:
 	 */
 	virtual bool DoUpdate() = 0;
 
+	/**
+	 * Reader-specific method telling a reader to stop using SendChunk()
+	 * and KeepChunk(). This happens when a key turns out to appear in
+	 * more than one chunk: the manager then can't tell which of their
+	 * values a full read would give the key, unless it sees them all.
+	 *
+	 * A reader that sends chunks must override this method. It has to
+	 * send the whole source right away, with SendEntry() or
+	 * SendEntries() and EndCurrentSend(), and keep doing so on later
+	 * reads. Others can rely on the default, which does nothing.
+	 *
+	 * Before calling this, StopChunks() tells the manager that a full
+	 * read starts. Until then, the manager ignores what reads that were
+	 * already done send for table streams.
+	 *
+	 * If it returns false, it will be assumed that a fatal error has
+	 * occurred, as with DoUpdate().
+	 */
+	virtual bool DoStopChunks() { return true; }
+
 	/**
 	 * Triggered by regular heartbeat messages from the main thread.
 	 */
@@ -354,6 +385,46 @@ protected:
 	 */
 	void SendEntry(threading::Value** vals);
 
+	/**
+	 * Method sending several lists of values to the manager in tracking
+	 * mode at once. Equivalent to calling SendEntry() for each of them in
+	 * turn, but passes them on in a single message, which is cheaper for
+	 * readers that load a large source in one go.
+	 *
+	 * @param rows Arrays of threading::Values expected by the stream,
+	 * in the order they should be sent.
+	 */
+	void SendEntries(std::vector<threading::Value**> rows);
+
+	/**
+	 * Method sending the entries of a chunk of the data source to the
+	 * manager in tracking mode. Readers that split their source into
+	 * chunks, and that can tell which chunks are unchanged since the last
+	 * read, use this together with KeepChunk() instead of SendEntry(), so
+	 * that the manager only has to look at entries of chunks that changed.
+	 * A reader must not mix the two within a stream.
+	 *
+	 * For table streams, EndCurrentSend() then deletes the entries of all
+	 * chunks from the last read that were neither sent nor kept. If a key
+	 * appears in more than one chunk, the manager calls DoStopChunks()
+	 * instead. Event streams see only the entries of the chunks sent.
+	 *
+	 * @param chunk An identifier of the chunk's content, such as a hash.
+	 * Must not be 0.
+	 *
+	 * @param rows Arrays of threading::Values expected by the stream.
+	 */
+	void SendChunk(uint64_t chunk, std::vector<threading::Value**> rows);
+
+	/**
+	 * Method telling the manager in tracking mode that a chunk sent
+	 * during the last read with SendChunk() is still part of the data
+	 * source, unchanged.
+	 *
+	 * @param chunk The chunk's identifier.
+	 */
+	void KeepChunk(uint64_t chunk);
+
 	/**
 	 * Method telling the manager, that the current list of entries sent
 	 * by SendEntry is finished.
@@ -35,6 +35,17 @@ public:
 	bool Process() override { return Object()->Update(); }
 	};
 
+class StopChunksMessage final : public threading::InputMessage<ReaderBackend>
+	{
+public:
+	StopChunksMessage(ReaderBackend* backend)
+		: threading::InputMessage<ReaderBackend>("StopChunks", backend)
+		{
+		}
+
+	bool Process() override { return Object()->StopChunks(); }
+	};
+
 ReaderFrontend::ReaderFrontend(const ReaderBackend::ReaderInfo& arg_info, EnumVal* type)
 	{
 	disabled = initialized = false;
@@ -92,6 +103,14 @@ void ReaderFrontend::Update()
 	backend->SendIn(new UpdateMessage(backend));
 	}
 
+void ReaderFrontend::StopChunks()
+	{
+	if ( disabled || ! initialized )
+		return;
+
+	backend->SendIn(new StopChunksMessage(backend));
+	}
+
 const char* ReaderFrontend::Name() const
 	{
 	return name;
@@ -71,6 +71,17 @@ public:
 	 */
 	void Update();
 
+	/**
+	 * Asks a reader that sends its source in chunks to stop doing so and
+	 * to send the whole source again right away, as plain entries.
+	 *
+	 * This method generates a message to the backend reader and triggers
+	 * the corresponding message there.
+	 *
+	 * This method must only be called from the main thread.
+	 */
+	void StopChunks();
+
 	/**
 	 * Finalizes reading from this stream.
 	 *
@@ -2,12 +2,19 @@
 
 #include "zeek/input/readers/ascii/Ascii.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <algorithm>
+#include <atomic>
 #include <cerrno>
+#include <cstring>
 #include <sstream>
+#include <thread>
 
+#include "zeek/Hash.h"
 #include "zeek/input/readers/ascii/ascii.bif.h"
 #include "zeek/threading/SerialTypes.h"
 
@@ -18,6 +25,18 @@ using zeek::threading::Value;
 namespace zeek::input::reader::detail
 	{
 
+// Bulk loads don't split files into chunks smaller than this.
+constexpr size_t BULK_MIN_CHUNK_SIZE = 256 * 1024;
+
+// The number of lines that bulk loads pass on to the manager per message.
+constexpr size_t BULK_BATCH_SIZE = 1000;
+
+// Incremental rereads split files into chunks of these sizes. Past the
+// minimum, a line ends a chunk if the low bits of its hash are all zero.
+constexpr size_t INCREMENTAL_MIN_CHUNK_SIZE = 16 * 1024;
+constexpr size_t INCREMENTAL_MAX_CHUNK_SIZE = 1024 * 1024;
+constexpr uint64_t INCREMENTAL_BOUNDARY_MASK = 0x3f;
+
 FieldMapping::FieldMapping(const string& arg_name, const TypeTag& arg_type, int arg_position)
 	: name(arg_name), type(arg_type), subtype(TYPE_ERROR)
 	{
@@ -68,6 +87,9 @@ Ascii::Ascii(ReaderFrontend* frontend) : ReaderBackend(frontend)
 	ino = 0;
 	fail_on_file_problem = false;
 	fail_on_invalid_lines = false;
+	bulk_load = false;
+	bulk_load_threads = 1;
+	incremental = false;
 	}
 
 void Ascii::DoClose()
@@ -97,6 +119,10 @@ bool Ascii::DoInit(const ReaderInfo& info, int num_fields, const Field* const* f
 	path_prefix.assign((const char*)BifConst::InputAscii::path_prefix->Bytes(),
 	                   BifConst::InputAscii::path_prefix->Len());
 
+	bulk_load = BifConst::InputAscii::bulk_load;
+	bulk_load_threads = std::max(1, static_cast<int>(BifConst::InputAscii::bulk_load_threads));
+	incremental = BifConst::InputAscii::incremental;
+
 	// Set per-filter configuration options.
 	for ( const auto& [k, v] : info.config )
 		{
@@ -117,6 +143,12 @@ bool Ascii::DoInit(const ReaderInfo& info, int num_fields, const Field* const* f
 
 		else if ( strcmp(k, "fail_on_file_problem") == 0 )
 			fail_on_file_problem = (strncmp(v, "T", 1) == 0);
+
+		else if ( strcmp(k, "bulk_load") == 0 )
+			bulk_load = (strncmp(v, "T", 1) == 0);
+
+		else if ( strcmp(k, "incremental") == 0 )
+			incremental = (strncmp(v, "T", 1) == 0);
 		}
 
 	if ( separator.size() != 1 )
@@ -363,6 +395,9 @@ bool Ascii::DoUpdate()
 			assert(false);
 		}
 
+	if ( (bulk_load || incremental) && Info().mode != MODE_STREAM && file.is_open() )
+		return BulkLoad();
+
 	string line;
 
 	file.sync();
@@ -472,6 +507,425 @@ bool Ascii::DoUpdate()
 	return true;
 	}
 
+bool Ascii::DoStopChunks()
+	{
+	incremental = false;
+	known_chunks.clear();
+
+	// Read the file again, even though it hasn't changed.
+	mtime = 0;
+	return DoUpdate();
+	}
+
+// Parses the rest of the file, following the header, in parallel. The file is
+// mapped into memory and split into chunks at line boundaries; each chunk is
+// parsed by its own thread with its own formatter, whose warnings are
+// collected rather than sent off. Once all are done, we report the warnings
+// and pass on the lines in file order, exactly as DoUpdate() would have.
+//
+// For incremental rereads, chunks are cut by content, and those we already
+// sent during the last read aren't parsed at all; we just tell the manager
+// to keep their entries.
+bool Ascii::BulkLoad()
+	{
+	auto body = file.tellg();
+	int line = read_location ? read_location->first_line : 0;
+
+	int fd = open(fname.c_str(), O_RDONLY);
+	struct stat sb;
+
+	if ( fd < 0 || fstat(fd, &sb) < 0 )
+		{
+		FailWarn(fail_on_file_problem,
+		         Fmt("Could not open %s for bulk loading: %s", fname.c_str(), strerror(errno)),
+		         true);
+
+		if ( fd >= 0 )
+			close(fd);
+
+		file.close();
+		return ! fail_on_file_problem;
+		}
+
+	size_t size = sb.st_size;
+
+	if ( body < 0 || size <= static_cast<size_t>(body) )
+		{
+		// Nothing but the header.
+		close(fd);
+		known_chunks.clear();
+		EndCurrentSend();
+		return true;
+		}
+
+	void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if ( data == MAP_FAILED )
+		{
+		FailWarn(fail_on_file_problem,
+		         Fmt("Could not map %s for bulk loading: %s", fname.c_str(), strerror(errno)),
+		         true);
+
+		file.close();
+		return ! fail_on_file_problem;
+		}
+
+	madvise(data, size, MADV_SEQUENTIAL);
+
+	const char* begin = static_cast<const char*>(data) + body;
+	const char* end = static_cast<const char*>(data) + size;
+	std::vector<BulkChunk> chunks;
+	size_t num_changed = 0;
+
+	if ( incremental )
+		{
+		SplitByContent(begin, end, &chunks);
+
+		// A different header may map the same lines to different fields.
+		if ( headerline != known_header )
+			{
+			known_chunks.clear();
+			known_header = headerline;
+			}
+
+		for ( auto& chunk : chunks )
+			{
+			chunk.unchanged = (known_chunks.count(chunk.id) > 0);
+
+			if ( ! chunk.unchanged )
+				num_changed++;
+			}
+		}
+	else
+		{
+		size_t len = end - begin;
+		size_t num_chunks = std::min(static_cast<size_t>(bulk_load_threads),
+		                             len / BULK_MIN_CHUNK_SIZE + 1);
+
+		chunks.resize(num_chunks);
+		num_changed = num_chunks;
+		const char* p = begin;
+
+		for ( size_t i = 0; i < num_chunks; i++ )
+			{
+			const char* e = end;
+
+			if ( i + 1 < num_chunks && static_cast<size_t>(end - p) > len / num_chunks )
+				{
+				auto nl = static_cast<const char*>(memchr(p + len / num_chunks, '\n',
+				                                          end - p - len / num_chunks));
+				if ( nl )
+					e = nl + 1;
+				}
+
+			chunks[i].begin = p;
+			chunks[i].end = e;
+			p = e;
+			}
+		}
+
+	// Each thread parses the next chunk that needs it until none are left.
+	std::atomic<size_t> next_chunk{0};
+
+	auto parse = [this, &chunks, &next_chunk]()
+	{
+		for ( size_t i = next_chunk++; i < chunks.size(); i = next_chunk++ )
+			if ( ! chunks[i].unchanged )
+				ParseChunk(&chunks[i]);
+	};
+
+	// The threads inherit our signal mask.
+	std::vector<std::thread> threads;
+	size_t num_threads = std::min(static_cast<size_t>(bulk_load ? bulk_load_threads : 1),
+	                              num_changed);
+
+	for ( size_t i = 1; i < num_threads; i++ )
+		threads.emplace_back(parse);
+
+	parse();
+
+	for ( auto& t : threads )
+		t.join();
+
+	munmap(data, size);
+
+	std::vector<Value**> batch;
+	std::unordered_map<uint64_t, int> sent_chunks;
+	bool failed = false;
+
+	auto flush = [this, &batch](const BulkChunk& chunk)
+	{
+		if ( batch.empty() )
+			return;
+
+		if ( incremental )
+			SendChunk(chunk.id, std::move(batch));
+		else
+			SendEntries(std::move(batch));
+
+		batch.clear();
+	};
+
+	for ( auto& chunk : chunks )
+		{
+		if ( failed )
+			{
+			for ( auto vals : chunk.rows )
+				Value::delete_value_ptr_array(vals, NumFields());
+
+			continue;
+			}
+
+		if ( chunk.unchanged )
+			{
+			chunk.num_lines = known_chunks[chunk.id];
+			KeepChunk(chunk.id);
+			sent_chunks[chunk.id] = chunk.num_lines;
+			line += chunk.num_lines;
+			continue;
+			}
+
+		// Warnings pick up the location from read_location.
+		for ( size_t i = 0; i < chunk.warnings.size(); i++ )
+			{
+			if ( read_location )
+				{
+				read_location->first_line = line + chunk.warning_lines[i];
+				read_location->last_line = read_location->first_line;
+				}
+
+			Warning(chunk.warnings[i].c_str());
+			}
+
+		for ( auto vals : chunk.rows )
+			{
+			if ( read_location )
+				for ( int i = 0; i < NumFields(); i++ )
+					vals[i]->SetFileLineNumber(vals[i]->GetFileLineNumber() + line);
+
+			batch.push_back(vals);
+
+			if ( batch.size() >= BULK_BATCH_SIZE )
+				flush(chunk);
+			}
+
+		// Batches of a chunked load mustn't span chunks.
+		if ( incremental || ! chunk.error.empty() )
+			flush(chunk);
+
+		line += chunk.num_lines;
+		sent_chunks[chunk.id] = chunk.num_lines;
+
+		if ( ! chunk.error.empty() )
+			{
+			if ( read_location )
+				{
+				read_location->first_line = line;
+				read_location->last_line = line;
+				}
+
+			FailWarn(true, chunk.error.c_str());
+			failed = true;
+			}
+		}
+
+	if ( read_location )
+		{
+		read_location->first_line = line;
+		read_location->last_line = line;
+		}
+
+	if ( failed )
+		{
+		known_chunks.clear();
+		return false;
+		}
+
+	flush(chunks.back());
+
+	if ( incremental )
+		known_chunks = std::move(sent_chunks);
+
+	EndCurrentSend();
+	return true;
+	}
+
+// Splits data into chunks at line boundaries that depend only on the content of
+// the line just before, so that a change to a few lines only affects the chunks
+// they're in, and the boundaries of all others stay the same. Each chunk is
+// identified by a hash of its content.
+void Ascii::SplitByContent(const char* begin, const char* end, std::vector<BulkChunk>* chunks)
+	{
+	const char* chunk_begin = begin;
+	const char* p = begin;
+
+	while ( p < end )
+		{
+		auto eol = static_cast<const char*>(memchr(p, '\n', end - p));
+		const char* line_end = eol ? eol + 1 : end;
+
+		// FNV-1a, which is good enough for picking boundaries.
+		uint64_t h = 0xcbf29ce484222325;
+		for ( ; p < line_end; p++ )
+			h = (h ^ static_cast<uint8_t>(*p)) * 0x100000001b3;
+
+		size_t chunk_size = p - chunk_begin;
+
+		if ( p == end || chunk_size >= INCREMENTAL_MAX_CHUNK_SIZE ||
+		     (chunk_size >= INCREMENTAL_MIN_CHUNK_SIZE && (h & INCREMENTAL_BOUNDARY_MASK) == 0) )
+			{
+			BulkChunk chunk;
+			chunk.begin = chunk_begin;
+			chunk.end = p;
+
+			// 0 isn't a valid chunk identifier.
+			chunk.id = zeek::detail::KeyedHash::Hash64(chunk_begin, chunk_size);
+			if ( chunk.id == 0 )
+				chunk.id = 1;
+
+			chunks->push_back(std::move(chunk));
+			chunk_begin = p;
+			}
+		}
+	}
+
+// Runs on a bulk loading thread, so it must not touch any state shared with
+// the others, nor send messages or use Fmt().
+void Ascii::ParseChunk(BulkChunk* chunk)
+	{
+	threading::formatter::Ascii::SeparatorInfo sep_info(separator, set_separator, unset_field,
+	                                                    empty_field);
+	threading::formatter::Ascii chunk_formatter(this, sep_info);
+	chunk_formatter.CollectWarnings(&chunk->warnings);
+
+	// Reused across lines, so that splitting a line rarely allocates.
+	std::vector<string> stringfields;
+	string line;
+	const char sep = separator[0];
+	const char* p = chunk->begin;
+
+	while ( p < chunk->end )
+		{
+		auto eol = static_cast<const char*>(memchr(p, '\n', chunk->end - p));
+		if ( ! eol )
+			eol = chunk->end;
+
+		line.assign(p, eol - p);
+		p = (eol < chunk->end) ? eol + 1 : eol;
+		chunk->num_lines++;
+
+		// Same as GetLine().
+		if ( line.empty() )
+			continue;
+
+		if ( line.back() == '\r' )
+			line.pop_back();
+
+		if ( line[0] == '#' )
+			{
+			if ( (line.length() > 8) && (line.compare(0, 7, "#fields") == 0) && (line[7] == sep) )
+				line.erase(0, 8);
+			else
+				continue;
+			}
+
+		// Split into fields, like util::split() does.
+		size_t num_stringfields = 0;
+		const char* f = line.data();
+		const char* line_end = line.data() + line.size();
+
+		while ( true )
+			{
+			auto fend = static_cast<const char*>(memchr(f, sep, line_end - f));
+			if ( ! fend )
+				fend = line_end;
+
+			if ( num_stringfields == stringfields.size() )
+				stringfields.emplace_back();
+
+			stringfields[num_stringfields++].assign(f, fend - f);
+
+			if ( fend == line_end )
+				break;
+
+			f = fend + 1;
+			}
+
+		// This needs to be a signed value or the comparisons below will fail.
+		int pos = static_cast<int>(num_stringfields - 1);
+
+		Value** fields = new Value*[NumFields()];
+		bool error = false;
+		int fpos = 0;
+
+		for ( const auto& fit : columnMap )
+			{
+			if ( ! fit.present )
+				{
+				fields[fpos] = new Value(fit.type, false);
+				if ( read_location )
+					fields[fpos]->SetFileLineNumber(chunk->num_lines);
+				fpos++;
+				continue;
+				}
+
+			if ( fit.position > pos || fit.secondary_position > pos )
+				{
+				auto msg = "Not enough fields in line '" + line + "' of " + fname + ". Found " +
+				           std::to_string(pos) + " fields, want positions " +
+				           std::to_string(fit.position) + " and " +
+				           std::to_string(fit.secondary_position);
+
+				if ( fail_on_invalid_lines )
+					chunk->error = msg;
+				else
+					chunk->warnings.emplace_back(msg);
+
+				error = true;
+				break;
+				}
+
+			Value* val = chunk_formatter.ParseValue(stringfields[fit.position], fit.name,
+			                                        fit.type, fit.subtype);
+			if ( ! val )
+				{
+				chunk->warnings.emplace_back("Could not convert line '" + line + "' of " + fname +
+				                             " to Val. Ignoring line.");
+				error = true;
+				break;
+				}
+
+			if ( read_location )
+				val->SetFileLineNumber(chunk->num_lines);
+
+			if ( fit.secondary_position != -1 )
+				val->val.port_val.proto = chunk_formatter.ParseProto(
+					stringfields[fit.secondary_position]);
+
+			fields[fpos] = val;
+			fpos++;
+			}
+
+		chunk->warning_lines.resize(chunk->warnings.size(), chunk->num_lines);
+
+		if ( error )
+			{
+			for ( int i = 0; i < fpos; i++ )
+				delete fields[i];
+
+			delete[] fields;
+
+			if ( ! chunk->error.empty() )
+				return;
+
+			continue;
+			}
+
+		chunk->rows.push_back(fields);
+		}
+	}
+
 bool Ascii::DoHeartbeat(double network_time, double current_time)
 	{
 	if ( ! OpenFile() )
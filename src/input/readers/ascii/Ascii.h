@@ -5,7 +5,9 @@
 #include <sys/types.h>
 #include <fstream>
 #include <iostream>
+#include <cstdint>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include "zeek/Obj.h"
@@ -59,14 +61,33 @@ protected:
 	            const threading::Field* const* fields) override;
 	void DoClose() override;
 	bool DoUpdate() override;
+	bool DoStopChunks() override;
 	bool DoHeartbeat(double network_time, double current_time) override;
 
 	const zeek::detail::Location* GetLocationInfo() const override { return read_location.get(); }
 
 private:
+	// A part of a file that's parsed by one thread during a bulk load.
+	struct BulkChunk
+		{
+		const char* begin = nullptr;
+		const char* end = nullptr;
+		uint64_t id = 0; // For incremental rereads, a hash of the content.
+		bool unchanged = false; // Sent during the last read already.
+		int num_lines = 0; // Including empty lines and comments.
+		std::vector<threading::Value**> rows; // Line numbers relative to the chunk.
+		std::vector<std::string> warnings;
+		std::vector<int> warning_lines; // Relative to the chunk.
+		std::string error; // An invalid line, with fail_on_invalid_lines set.
+		};
+
 	bool ReadHeader(bool useCached);
 	bool GetLine(std::string& str);
 	bool OpenFile();
+	bool BulkLoad();
+	void ParseChunk(BulkChunk* chunk);
+	static void SplitByContent(const char* begin, const char* end,
+	                           std::vector<BulkChunk>* chunks);
 
 	std::ifstream file;
 	time_t mtime;
@@ -91,6 +112,14 @@ private:
 	bool fail_on_invalid_lines;
 	bool fail_on_file_problem;
 	std::string path_prefix;
+	bool bulk_load;
+	int bulk_load_threads;
+	bool incremental;
+
+	// For incremental rereads, the chunks sent during the last read with
+	// their number of lines, and the header they were parsed with.
+	std::unordered_map<uint64_t, int> known_chunks;
+	std::string known_header;
 
 	std::unique_ptr<threading::Formatter> formatter;
 
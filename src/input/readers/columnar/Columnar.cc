@@ -0,0 +1,333 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek/input/readers/columnar/Columnar.h"
+
+#include <sys/stat.h>
+
+#include "zeek/input/readers/columnar/columnar.bif.h"
+#include "zeek/threading/SerialTypes.h"
+
+using namespace std;
+using zeek::threading::Field;
+using zeek::threading::Value;
+using zeek::threading::formatter::ColumnarDecoder;
+
+namespace zeek::input::reader::detail
+	{
+
+Columnar::Columnar(ReaderFrontend* frontend)
+	: ReaderBackend(frontend), in(nullptr), mtime(0), ino(0), firstrun(true), have_header(false)
+	{
+	}
+
+Columnar::~Columnar()
+	{
+	DoClose();
+	}
+
+void Columnar::DoClose()
+	{
+	if ( in )
+		CloseInput();
+	}
+
+bool Columnar::OpenInput()
+	{
+	in = new ifstream(fname.c_str(), ios_base::in | ios_base::binary);
+
+	if ( in->fail() )
+		{
+		Error(Fmt("Init: cannot open %s", fname.c_str()));
+		return false;
+		}
+
+	decoder = ColumnarDecoder();
+	have_header = false;
+	buffer.clear();
+	return true;
+	}
+
+void Columnar::CloseInput()
+	{
+	in->close();
+	delete in;
+	in = nullptr;
+	}
+
+bool Columnar::DoInit(const ReaderInfo& info, int num_fields, const Field* const* fields)
+	{
+	in = nullptr;
+	mtime = 0;
+	ino = 0;
+	firstrun = true;
+
+	path_prefix.assign((const char*)BifConst::InputColumnar::path_prefix->Bytes(),
+	                   BifConst::InputColumnar::path_prefix->Len());
+
+	if ( ! info.source || strlen(info.source) == 0 )
+		{
+		Error("No source path provided");
+		return false;
+		}
+
+	fname = info.source;
+
+	// Handle path-prefixing. See similar logic in Ascii::OpenFile().
+	if ( fname.front() != '/' && ! path_prefix.empty() )
+		{
+		string path = path_prefix;
+		std::size_t last = path.find_last_not_of('/');
+
+		if ( last == string::npos ) // Nothing but slashes -- weird but ok...
+			path = "/";
+		else
+			path.erase(last + 1);
+
+		fname = path + "/" + fname;
+		}
+
+	if ( ! OpenInput() )
+		return false;
+
+	if ( UpdateModificationTime() == -1 )
+		return false;
+
+	return DoUpdate();
+	}
+
+int Columnar::UpdateModificationTime()
+	{
+	struct stat sb;
+
+	if ( stat(fname.c_str(), &sb) == -1 )
+		{
+		Error(Fmt("Could not get stat for %s", fname.c_str()));
+		return -1;
+		}
+
+	if ( sb.st_ino == ino && sb.st_mtime == mtime )
+		// no change
+		return 0;
+
+	mtime = sb.st_mtime;
+	ino = sb.st_ino;
+	return 1;
+	}
+
+bool Columnar::ReadInput()
+	{
+	char chunk[65536];
+
+	while ( in->read(chunk, sizeof(chunk)) || in->gcount() > 0 )
+		buffer.append(chunk, in->gcount());
+
+	if ( in->bad() )
+		{
+		Error(Fmt("error reading %s", fname.c_str()));
+		return false;
+		}
+
+	// Clear the EOF state so that we can pick up more data in stream mode.
+	in->clear();
+	return true;
+	}
+
+bool Columnar::ReadHeader()
+	{
+	size_t consumed = 0;
+
+	switch ( decoder.ReadHeader(buffer.data(), buffer.size(), &consumed) )
+		{
+		case ColumnarDecoder::OK:
+			break;
+
+		case ColumnarDecoder::INCOMPLETE:
+			return true;
+
+		case ColumnarDecoder::FAILED:
+			Error(Fmt("%s: %s", fname.c_str(), decoder.Error().c_str()));
+			return false;
+		}
+
+	buffer.erase(0, consumed);
+	have_header = true;
+
+	// Map our fields to the file's columns by name.
+	const auto& file_fields = decoder.Fields();
+	columns.clear();
+
+	for ( int i = 0; i < NumFields(); i++ )
+		{
+		const Field* field = Fields()[i];
+		int column = -1;
+
+		for ( size_t j = 0; j < file_fields.size(); j++ )
+			{
+			if ( file_fields[j].name == field->name )
+				{
+				column = static_cast<int>(j);
+				break;
+				}
+			}
+
+		if ( column < 0 )
+			{
+			if ( field->optional )
+				{
+				// We'll send an unset value instead.
+				columns.push_back(-1);
+				continue;
+				}
+
+			Error(Fmt("Did not find requested field %s in input data file %s.", field->name,
+			          fname.c_str()));
+			return false;
+			}
+
+		const auto& ff = file_fields[column];
+		bool container = field->type == TYPE_TABLE || field->type == TYPE_VECTOR;
+
+		if ( ff.type != field->type || (container && ff.subtype != field->subtype) )
+			{
+			Field file_field(ff.name.c_str(), nullptr, ff.type, ff.subtype, ff.optional);
+			Error(Fmt("Field %s in input data file %s has type %s, but %s was requested.",
+			          field->name, fname.c_str(), file_field.TypeName().c_str(),
+			          field->TypeName().c_str()));
+			return false;
+			}
+
+		columns.push_back(column);
+		}
+
+	return true;
+	}
+
+bool Columnar::ReadBlocks()
+	{
+	size_t pos = 0;
+	std::vector<Value**> rows;
+
+	while ( pos < buffer.size() )
+		{
+		size_t consumed = 0;
+		auto result = decoder.ReadBlock(buffer.data() + pos, buffer.size() - pos, &consumed,
+		                                columns, &rows);
+
+		if ( result == ColumnarDecoder::INCOMPLETE )
+			break;
+
+		if ( result == ColumnarDecoder::FAILED )
+			{
+			Error(Fmt("%s: %s", fname.c_str(), decoder.Error().c_str()));
+			return false;
+			}
+
+		pos += consumed;
+
+		for ( auto row : rows )
+			{
+			for ( int i = 0; i < NumFields(); i++ )
+				{
+				if ( ! row[i] )
+					row[i] = new Value(Fields()[i]->type, Fields()[i]->subtype, false);
+				}
+
+			if ( Info().mode == MODE_STREAM )
+				Put(row);
+			else
+				SendEntry(row);
+			}
+
+		rows.clear();
+		}
+
+	buffer.erase(0, pos);
+	return true;
+	}
+
+bool Columnar::DoUpdate()
+	{
+	if ( firstrun )
+		firstrun = false;
+
+	else
+		{
+		switch ( Info().mode )
+			{
+			case MODE_REREAD:
+				{
+				switch ( UpdateModificationTime() )
+					{
+					case -1:
+						return false; // error
+					case 0:
+						return true; // no change
+					case 1:
+						break; // file changed. reread.
+					default:
+						assert(false);
+					}
+				// fallthrough
+				}
+
+			case MODE_MANUAL:
+			case MODE_STREAM:
+				if ( Info().mode == MODE_STREAM && in )
+					break;
+
+				if ( in )
+					CloseInput();
+
+				if ( ! OpenInput() )
+					return false;
+
+				break;
+
+			default:
+				assert(false);
+			}
+		}
+
+	if ( ! ReadInput() )
+		return false;
+
+	if ( ! have_header && ! ReadHeader() )
+		return false;
+
+	if ( have_header && ! ReadBlocks() )
+		return false;
+
+	if ( Info().mode != MODE_STREAM )
+		{
+		// In stream mode, the rest arrives once the writer flushes it.
+		if ( ! buffer.empty() )
+			Warning(Fmt("Ignoring incomplete data at the end of %s", fname.c_str()));
+
+		EndCurrentSend();
+		}
+
+	return true;
+	}
+
+bool Columnar::DoHeartbeat(double network_time, double current_time)
+	{
+	switch ( Info().mode )
+		{
+		case MODE_MANUAL:
+			// yay, we do nothing :)
+			break;
+
+		case MODE_REREAD:
+		case MODE_STREAM:
+			Update(); // call update and not DoUpdate, because update
+			          // checks disabled.
+			break;
+
+		default:
+			assert(false);
+		}
+
+	return true;
+	}
+
+	} // namespace zeek::input::reader::detail
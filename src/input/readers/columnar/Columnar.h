@@ -0,0 +1,60 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#pragma once
+
+#include <sys/types.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "zeek/input/ReaderBackend.h"
+#include "zeek/threading/formatters/Columnar.h"
+
+namespace zeek::input::reader::detail
+	{
+
+/**
+ * Reader for logs of the columnar writer. Fields are looked up by name
+ * in the file header, so a file can be read into any record type whose
+ * fields it contains. In stream mode, blocks are read as the writer
+ * appends them.
+ */
+class Columnar : public ReaderBackend
+	{
+public:
+	explicit Columnar(ReaderFrontend* frontend);
+	~Columnar() override;
+
+	static ReaderBackend* Instantiate(ReaderFrontend* frontend) { return new Columnar(frontend); }
+
+protected:
+	bool DoInit(const ReaderInfo& info, int arg_num_fields,
+	            const threading::Field* const* fields) override;
+	void DoClose() override;
+	bool DoUpdate() override;
+	bool DoHeartbeat(double network_time, double current_time) override;
+
+private:
+	bool OpenInput();
+	void CloseInput();
+	bool ReadInput();
+	bool ReadHeader();
+	bool ReadBlocks();
+	int UpdateModificationTime();
+
+	std::string fname;
+	std::ifstream* in;
+	time_t mtime;
+	ino_t ino;
+	bool firstrun;
+
+	threading::formatter::ColumnarDecoder decoder;
+	bool have_header;
+	std::string buffer; // Data read but not yet parsed.
+	std::vector<int> columns; // The file's column for each of our fields, or -1.
+
+	// Options set from the script-level.
+	std::string path_prefix;
+	};
+
+	} // namespace zeek::input::reader::detail
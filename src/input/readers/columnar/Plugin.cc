@@ -0,0 +1,25 @@
+// See the file  in the main distribution directory for copyright.
+
+#include "zeek/plugin/Plugin.h"
+
+#include "zeek/input/readers/columnar/Columnar.h"
+
+namespace zeek::plugin::detail::Zeek_ColumnarReader
+	{
+
+class Plugin : public zeek::plugin::Plugin
+	{
+public:
+	zeek::plugin::Configuration Configure() override
+		{
+		AddComponent(new zeek::input::Component(
+			"Columnar", zeek::input::reader::detail::Columnar::Instantiate));
+
+		zeek::plugin::Configuration config;
+		config.name = "Zeek::ColumnarReader";
+		config.description = "Columnar binary log reader";
+		return config;
+		}
+	} plugin;
+
+	} // namespace zeek::plugin::detail::Zeek_ColumnarReader
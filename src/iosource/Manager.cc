@@ -57,9 +57,11 @@ void Manager::WakeupHandler::Ping(std::string_view where)
 
 Manager::Manager()
 	{
-	event_queue = kqueue();
-	if ( event_queue == -1 )
-		reporter->FatalError("Failed to initialize kqueue: %s", strerror(errno));
+	// The kqueue itself gets created in InitPostScript(). A supervisor's
+	// prefork template forks its nodes after loading scripts, and every
+	// node needs an event queue of its own instead of sharing the
+	// template's. File descriptors registered before then are recorded
+	// and get added once the queue exists.
 	}
 
 Manager::~Manager()
@@ -104,6 +106,28 @@ Manager::~Manager()
 
 void Manager::InitPostScript()
 	{
+	event_queue = kqueue();
+	if ( event_queue == -1 )
+		reporter->FatalError("Failed to initialize kqueue: %s", strerror(errno));
+
+	std::vector<struct kevent> pending;
+
+	for ( const auto& [fd, src] : fd_map )
+		{
+		pending.push_back({});
+		EV_SET(&(pending.back()), fd, EVFILT_READ, EV_ADD, 0, 0, NULL);
+		}
+
+	for ( const auto& [fd, src] : write_fd_map )
+		{
+		pending.push_back({});
+		EV_SET(&(pending.back()), fd, EVFILT_WRITE, EV_ADD, 0, 0, NULL);
+		}
+
+	if ( ! pending.empty() &&
+	     kevent(event_queue, pending.data(), pending.size(), NULL, 0, NULL) == -1 )
+		reporter->FatalError("Failed to register pending fds: %s", strerror(errno));
+
 	wakeup = new WakeupHandler();
 	poll_interval = BifConst::io_poll_interval_default;
 	}
@@ -292,7 +316,11 @@ bool Manager::RegisterFd(int fd, IOSource* src, int flags)
 
 	if ( ! new_events.empty() )
 		{
-		int ret = kevent(event_queue, new_events.data(), new_events.size(), NULL, 0, NULL);
+		// Without a queue yet, InitPostScript() adds the fd later.
+		int ret = 0;
+		if ( event_queue != -1 )
+			ret = kevent(event_queue, new_events.data(), new_events.size(), NULL, 0, NULL);
+
 		if ( ret != -1 )
 			{
 			DBG_LOG(DBG_MAINLOOP, "Registered fd %d from %s", fd, src->Tag());
@@ -341,7 +369,10 @@ bool Manager::UnregisterFd(int fd, IOSource* src, int flags)
 
 	if ( ! new_events.empty() )
 		{
-		int ret = kevent(event_queue, new_events.data(), new_events.size(), NULL, 0, NULL);
+		int ret = 0;
+		if ( event_queue != -1 )
+			ret = kevent(event_queue, new_events.data(), new_events.size(), NULL, 0, NULL);
+
 		if ( ret != -1 )
 			{
 			DBG_LOG(DBG_MAINLOOP, "Unregistered fd %d from %s", fd, src->Tag());
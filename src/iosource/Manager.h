@@ -51,6 +51,8 @@ public:
 	/**
 	 * Initializes some extra fields that can't be done during the
 	 * due to dependencies on other objects being initialized first.
+	 * This also creates the kqueue and adds any file descriptors that
+	 * were registered before.
 	 */
 	void InitPostScript();
 
@@ -218,7 +220,7 @@ private:
 	int poll_counter = 0;
 	int poll_interval = 0; // Set in InitPostScript() based on const value.
 
-	int event_queue = -1;
+	int event_queue = -1; // Created in InitPostScript().
 	std::map<int, IOSource*> fd_map;
 	std::map<int, IOSource*> write_fd_map;
 
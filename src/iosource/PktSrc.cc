@@ -97,6 +97,7 @@ void PktSrc::Opened(const Properties& arg_props)
 void PktSrc::Closed()
 	{
 	SetClosed(true);
+	shunts.Clear();
 
 	if ( props.selectable_fd != -1 )
 		iosource_mgr->UnregisterFd(props.selectable_fd, this);
@@ -157,7 +158,8 @@ void PktSrc::Process()
 	if ( ! ExtractNextPacketInternal() )
 		return;
 
-	run_state::detail::dispatch_packet(&current_packet, this);
+	if ( ! shunts.Match(&current_packet) )
+		run_state::detail::dispatch_packet(&current_packet, this);
 
 	have_packet = false;
 	DoneWithPacket();
@@ -219,6 +221,20 @@ bool PktSrc::ExtractNextPacketInternal()
 	return false;
 	}
 
+bool PktSrc::ShuntFlow(const zeek::detail::ConnKey& key)
+	{
+	return shunts.Add(key, AddKernelShunt(key));
+	}
+
+bool PktSrc::UnshuntFlow(const zeek::detail::ConnKey& key)
+	{
+	if ( ! shunts.Remove(key) )
+		return false;
+
+	RemoveKernelShunt(key);
+	return true;
+	}
+
 detail::BPF_Program* PktSrc::CompileFilter(const std::string& filter)
 	{
 	auto code = std::make_unique<detail::BPF_Program>();
@@ -8,6 +8,7 @@
 #include "zeek/iosource/BPF_Program.h"
 #include "zeek/iosource/IOSource.h"
 #include "zeek/iosource/Packet.h"
+#include "zeek/iosource/ShuntTable.h"
 
 struct pcap_pkthdr;
 
@@ -212,6 +213,27 @@ public:
 	 */
 	virtual void Statistics(Stats* stats) = 0;
 
+	/**
+	 * Stops handing the packets of a flow to Zeek ("shunting"). Packets
+	 * are matched on their outermost TCP or UDP header and dropped before
+	 * any parsing. Sources able to drop them before they reach user space
+	 * get the flow passed on through AddKernelShunt().
+	 *
+	 * @param key The connection key of the flow.
+	 *
+	 * @return True if the flow was not shunted yet.
+	 */
+	bool ShuntFlow(const zeek::detail::ConnKey& key);
+
+	/**
+	 * Resumes handing the packets of a shunted flow to Zeek.
+	 *
+	 * @param key The connection key of the flow.
+	 *
+	 * @return True if the flow was shunted.
+	 */
+	bool UnshuntFlow(const zeek::detail::ConnKey& key);
+
 	/**
 	 * Return the next timeout value for this source. This should be
 	 * overridden by source classes where they have a timeout value
@@ -365,6 +387,26 @@ protected:
 	 */
 	virtual detail::BPF_Program* CompileFilter(const std::string& filter);
 
+	/**
+	 * Asks the source to drop a flow's packets before they reach user
+	 * space, e.g. through a map consulted by a kernel-side filter. Can be
+	 * overridden by derived classes; the default does nothing, leaving
+	 * shunting to the software table.
+	 *
+	 * @param key The connection key of the flow.
+	 *
+	 * @return True if the source now drops the flow's packets itself.
+	 */
+	virtual bool AddKernelShunt(const zeek::detail::ConnKey& key) { return false; }
+
+	/**
+	 * Reverts a previous successful AddKernelShunt(). Can be overridden by
+	 * derived classes; the default does nothing.
+	 *
+	 * @param key The connection key of the flow.
+	 */
+	virtual void RemoveKernelShunt(const zeek::detail::ConnKey& key) { }
+
 private:
 	// Internal helper for ExtractNextPacket().
 	bool ExtractNextPacketInternal();
@@ -387,6 +429,9 @@ private:
 	// For BPF filtering support.
 	std::vector<detail::BPF_Program*> filters;
 
+	// Flows whose packets are dropped before dispatching.
+	detail::ShuntTable shunts;
+
 	std::string errbuf;
 	};
 
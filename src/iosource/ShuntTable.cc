@@ -0,0 +1,246 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek/iosource/ShuntTable.h"
+
+#include "zeek/zeek-config.h"
+
+#include <netinet/in.h>
+#include <cstring>
+
+#include "zeek/Hash.h"
+#include "zeek/NetVar.h"
+#include "zeek/RunState.h"
+#include "zeek/iosource/Packet.h"
+#include "zeek/telemetry/Manager.h"
+
+extern "C"
+	{
+#include <pcap.h>
+	}
+
+namespace zeek::iosource::detail
+	{
+
+// How often, in packet time, the table is scanned for inactive flows.
+constexpr double EXPIRE_INTERVAL = 1.0;
+
+size_t ShuntTable::KeyHash::operator()(const zeek::detail::ConnKey& k) const
+	{
+	return zeek::detail::HashKey::HashBytes(&k, sizeof(k));
+	}
+
+bool ShuntTable::Add(const zeek::detail::ConnKey& key, bool in_kernel)
+	{
+	InitMetrics();
+
+	auto [it, inserted] = flows.try_emplace(key);
+	it->second.last_hit = run_state::network_time;
+	it->second.in_kernel = it->second.in_kernel || in_kernel;
+
+	if ( inserted )
+		flows_metric->Inc();
+
+	return inserted;
+	}
+
+bool ShuntTable::Remove(const zeek::detail::ConnKey& key)
+	{
+	if ( flows.erase(key) == 0 )
+		return false;
+
+	flows_metric->Dec();
+	return true;
+	}
+
+void ShuntTable::Clear()
+	{
+	if ( flows_metric )
+		flows_metric->Dec(flows.size());
+
+	flows.clear();
+	}
+
+bool ShuntTable::Match(const Packet* pkt)
+	{
+	if ( flows.empty() )
+		return false;
+
+	if ( pkt->time >= next_expire )
+		{
+		Expire(pkt->time);
+		next_expire = pkt->time + EXPIRE_INTERVAL;
+
+		if ( flows.empty() )
+			return false;
+		}
+
+	auto key = ExtractKey(pkt);
+	if ( ! key )
+		return false;
+
+	auto it = flows.find(*key);
+	if ( it == flows.end() )
+		return false;
+
+	it->second.last_hit = pkt->time;
+	packets_metric->Inc();
+	bytes_metric->Inc(pkt->len);
+
+	return true;
+	}
+
+std::optional<zeek::detail::ConnKey> ShuntTable::ExtractKey(const Packet* pkt)
+	{
+	const u_char* data = pkt->data;
+	uint32_t len = pkt->cap_len;
+
+	switch ( pkt->link_type )
+		{
+		case DLT_EN10MB:
+			{
+			if ( len < 14 )
+				return std::nullopt;
+
+			uint16_t ether_type = (data[12] << 8) | data[13];
+			data += 14;
+			len -= 14;
+
+			// Skip VLAN tags, including stacked ones.
+			while ( ether_type == 0x8100 || ether_type == 0x88a8 || ether_type == 0x9100 )
+				{
+				if ( len < 4 )
+					return std::nullopt;
+
+				ether_type = (data[2] << 8) | data[3];
+				data += 4;
+				len -= 4;
+				}
+
+			if ( ether_type != 0x0800 && ether_type != 0x86dd )
+				return std::nullopt;
+
+			break;
+			}
+
+		case DLT_NULL:
+			if ( len < 4 )
+				return std::nullopt;
+
+			data += 4;
+			len -= 4;
+			break;
+
+		case DLT_RAW:
+			break;
+
+		default:
+			return std::nullopt;
+		}
+
+	if ( len < 1 )
+		return std::nullopt;
+
+	IPAddr src;
+	IPAddr dst;
+	uint8_t proto;
+	uint32_t hdr_len;
+
+	if ( data[0] >> 4 == 4 )
+		{
+		if ( len < 20 )
+			return std::nullopt;
+
+		// Only the first fragment carries ports, and telling fragments
+		// apart requires reassembly. Leave them to the regular path.
+		uint16_t frag = (data[6] << 8) | data[7];
+		if ( frag & 0x3fff )
+			return std::nullopt;
+
+		in_addr a;
+		memcpy(&a, data + 12, sizeof(a));
+		src = IPAddr(a);
+		memcpy(&a, data + 16, sizeof(a));
+		dst = IPAddr(a);
+
+		proto = data[9];
+		hdr_len = (data[0] & 0x0f) * 4;
+		}
+
+	else if ( data[0] >> 4 == 6 )
+		{
+		if ( len < 40 )
+			return std::nullopt;
+
+		// Extension headers are not walked; such packets take the
+		// regular path.
+		in6_addr a;
+		memcpy(&a, data + 8, sizeof(a));
+		src = IPAddr(a);
+		memcpy(&a, data + 24, sizeof(a));
+		dst = IPAddr(a);
+
+		proto = data[6];
+		hdr_len = 40;
+		}
+
+	else
+		return std::nullopt;
+
+	TransportProto transport;
+
+	if ( proto == IPPROTO_TCP )
+		transport = TRANSPORT_TCP;
+	else if ( proto == IPPROTO_UDP )
+		transport = TRANSPORT_UDP;
+	else
+		return std::nullopt;
+
+	if ( len < hdr_len + 4 )
+		return std::nullopt;
+
+	// Ports stay in network byte order, as in the session table's keys.
+	uint16_t src_port;
+	uint16_t dst_port;
+	memcpy(&src_port, data + hdr_len, sizeof(src_port));
+	memcpy(&dst_port, data + hdr_len + 2, sizeof(dst_port));
+
+	return zeek::detail::ConnKey(src, dst, src_port, dst_port, transport, false);
+	}
+
+void ShuntTable::InitMetrics()
+	{
+	if ( flows_metric )
+		return;
+
+	auto flows_family = telemetry_mgr->GaugeFamily(
+		"zeek", "shunted-flows", {}, "Number of flows whose packets are dropped before analysis");
+	auto packets_family = telemetry_mgr->CounterFamily(
+		"zeek", "shunted-packets", {}, "Number of packets dropped for shunted flows", "1", true);
+	auto bytes_family = telemetry_mgr->CounterFamily(
+		"zeek", "shunted-bytes", {}, "Number of bytes dropped for shunted flows", "1", true);
+
+	flows_metric = flows_family.GetOrAdd({});
+	packets_metric = packets_family.GetOrAdd({});
+	bytes_metric = bytes_family.GetOrAdd({});
+	}
+
+void ShuntTable::Expire(double now)
+	{
+	double timeout = BifConst::shunt_inactivity_timeout;
+
+	if ( timeout <= 0.0 )
+		return;
+
+	for ( auto it = flows.begin(); it != flows.end(); )
+		{
+		if ( ! it->second.in_kernel && now - it->second.last_hit > timeout )
+			{
+			it = flows.erase(it);
+			flows_metric->Dec();
+			}
+		else
+			++it;
+		}
+	}
+
+	} // namespace zeek::iosource::detail
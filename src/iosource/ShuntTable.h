@@ -0,0 +1,107 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+
+#include "zeek/IPAddr.h"
+#include "zeek/telemetry/Counter.h"
+#include "zeek/telemetry/Gauge.h"
+
+namespace zeek
+	{
+
+class Packet;
+
+namespace iosource::detail
+	{
+
+/**
+ * The software side of flow shunting: a table of flows whose packets a
+ * packet source drops before handing them to Zeek. Packets are matched on
+ * their outermost IPv4/IPv6 TCP or UDP header, extracted directly from the
+ * raw link-layer frame, so shunted packets never reach packet analysis or
+ * the session table.
+ */
+class ShuntTable
+	{
+public:
+	/**
+	 * Adds a flow.
+	 *
+	 * @param key The flow's connection key.
+	 *
+	 * @param in_kernel True if the packet source also drops the flow's
+	 * packets before they reach user space. Such entries are not expired
+	 * for inactivity, since matching packets are not expected to show up.
+	 *
+	 * @return True if the flow was not in the table yet.
+	 */
+	bool Add(const zeek::detail::ConnKey& key, bool in_kernel);
+
+	/**
+	 * Removes a flow.
+	 *
+	 * @param key The flow's connection key.
+	 *
+	 * @return True if the flow was in the table.
+	 */
+	bool Remove(const zeek::detail::ConnKey& key);
+
+	/**
+	 * Removes all flows.
+	 */
+	void Clear();
+
+	/**
+	 * @return True if there are no shunted flows.
+	 */
+	bool Empty() const { return flows.empty(); }
+
+	/**
+	 * Checks whether a packet belongs to a shunted flow, updating the
+	 * flow's counters if so. Also expires inactive flows periodically.
+	 *
+	 * @param pkt The packet as extracted by the packet source.
+	 *
+	 * @return True if the packet should be dropped.
+	 */
+	bool Match(const Packet* pkt);
+
+	/**
+	 * Extracts the connection key of a packet's outermost TCP or UDP flow.
+	 *
+	 * @param pkt The packet.
+	 *
+	 * @return The key, or nothing if the packet isn't an unfragmented TCP or
+	 * UDP packet over a supported link type.
+	 */
+	static std::optional<zeek::detail::ConnKey> ExtractKey(const Packet* pkt);
+
+private:
+	struct Entry
+		{
+		double last_hit = 0.0;
+		bool in_kernel = false;
+		};
+
+	struct KeyHash
+		{
+		size_t operator()(const zeek::detail::ConnKey& k) const;
+		};
+
+	void InitMetrics();
+	void Expire(double now);
+
+	std::unordered_map<zeek::detail::ConnKey, Entry, KeyHash> flows;
+	double next_expire = 0.0;
+
+	std::optional<telemetry::IntGauge> flows_metric;
+	std::optional<telemetry::IntCounter> packets_metric;
+	std::optional<telemetry::IntCounter> bytes_metric;
+	};
+
+	} // namespace iosource::detail
+	} // namespace zeek
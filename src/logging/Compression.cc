@@ -0,0 +1,407 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek/logging/Compression.h"
+
+#include "zeek/zeek-config.h"
+
+#include <zlib.h>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <memory>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef HAVE_LZ4
+#include <lz4frame.h>
+#endif
+
+#include "zeek/3rdparty/doctest.h"
+#include "zeek/util.h"
+
+namespace zeek::logging::detail
+	{
+
+namespace
+	{
+
+class GzipCodec : public Codec
+	{
+public:
+	const char* Name() const override { return "gzip"; }
+	const char* Extension() const override { return "gz"; }
+	bool HasSkippableFrames() const override { return false; }
+	int MaxLevel() const override { return Z_BEST_COMPRESSION; }
+
+	bool Compress(const char* data, size_t len, int level, std::string* out) const override
+		{
+		z_stream zs;
+		memset(&zs, 0, sizeof(zs));
+
+		// A window of 15 bits plus 16 makes deflate write a complete gzip
+		// member, which gzip treats like a file of its own.
+		if ( deflateInit2(&zs, level > 0 ? level : Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+		                  Z_DEFAULT_STRATEGY) != Z_OK )
+			return false;
+
+		size_t offset = out->size();
+		out->resize(offset + deflateBound(&zs, len));
+
+		zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+		zs.avail_in = len;
+		zs.next_out = reinterpret_cast<Bytef*>(&(*out)[offset]);
+		zs.avail_out = out->size() - offset;
+
+		int res = deflate(&zs, Z_FINISH);
+		deflateEnd(&zs);
+
+		if ( res != Z_STREAM_END )
+			{
+			out->resize(offset);
+			return false;
+			}
+
+		out->resize(offset + zs.total_out);
+		return true;
+		}
+	};
+
+#ifdef HAVE_ZSTD
+class ZstdCodec : public Codec
+	{
+public:
+	const char* Name() const override { return "zstd"; }
+	const char* Extension() const override { return "zst"; }
+	bool HasSkippableFrames() const override { return true; }
+	int MaxLevel() const override { return ZSTD_maxCLevel(); }
+
+	bool Compress(const char* data, size_t len, int level, std::string* out) const override
+		{
+		// Contexts are expensive to set up, so each thread keeps one.
+		thread_local std::unique_ptr<ZSTD_CCtx, size_t (*)(ZSTD_CCtx*)> ctx(ZSTD_createCCtx(),
+		                                                                    ZSTD_freeCCtx);
+		if ( ! ctx )
+			return false;
+
+		size_t offset = out->size();
+		out->resize(offset + ZSTD_compressBound(len));
+
+		size_t n = ZSTD_compressCCtx(ctx.get(), &(*out)[offset], out->size() - offset, data, len,
+		                             level);
+
+		if ( ZSTD_isError(n) )
+			{
+			out->resize(offset);
+			return false;
+			}
+
+		out->resize(offset + n);
+		return true;
+		}
+	};
+#endif
+
+#ifdef HAVE_LZ4
+class Lz4Codec : public Codec
+	{
+public:
+	const char* Name() const override { return "lz4"; }
+	const char* Extension() const override { return "lz4"; }
+	bool HasSkippableFrames() const override { return true; }
+	int MaxLevel() const override { return LZ4F_compressionLevel_max(); }
+
+	bool Compress(const char* data, size_t len, int level, std::string* out) const override
+		{
+		LZ4F_preferences_t prefs;
+		memset(&prefs, 0, sizeof(prefs));
+		prefs.compressionLevel = level;
+		prefs.frameInfo.contentSize = len;
+
+		size_t offset = out->size();
+		out->resize(offset + LZ4F_compressFrameBound(len, &prefs));
+
+		size_t n = LZ4F_compressFrame(&(*out)[offset], out->size() - offset, data, len, &prefs);
+
+		if ( LZ4F_isError(n) )
+			{
+			out->resize(offset);
+			return false;
+			}
+
+		out->resize(offset + n);
+		return true;
+		}
+	};
+#endif
+
+void put_u32le(std::string* out, uint32_t v)
+	{
+	for ( int i = 0; i < 4; ++i )
+		out->push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+	}
+
+	} // namespace
+
+const Codec* Codec::Lookup(const std::string& name)
+	{
+	static const GzipCodec gzip;
+
+	if ( name == gzip.Name() )
+		return &gzip;
+
+#ifdef HAVE_ZSTD
+	static const ZstdCodec zstd;
+
+	if ( name == zstd.Name() )
+		return &zstd;
+#endif
+
+#ifdef HAVE_LZ4
+	static const Lz4Codec lz4;
+
+	if ( name == lz4.Name() )
+		return &lz4;
+#endif
+
+	return nullptr;
+	}
+
+CompressionPool* CompressionPool::Instance(int num_threads)
+	{
+	static std::once_flag once;
+	static std::unique_ptr<CompressionPool> pool;
+
+	std::call_once(once, [num_threads]() { pool = std::make_unique<CompressionPool>(num_threads); });
+	return pool.get();
+	}
+
+CompressionPool::CompressionPool(int num_threads)
+	{
+	for ( int i = 0; i < num_threads; ++i )
+		threads.emplace_back(&CompressionPool::Run, this);
+	}
+
+CompressionPool::~CompressionPool()
+	{
+		{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+		}
+
+	cond.notify_all();
+
+	for ( auto& t : threads )
+		t.join();
+	}
+
+void CompressionPool::Submit(std::function<void()> job)
+	{
+		{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back(std::move(job));
+		}
+
+	cond.notify_one();
+	}
+
+void CompressionPool::Run()
+	{
+#ifndef _MSC_VER
+	// Like all of Zeek's threads, leave signals to the main thread.
+	sigset_t mask_set;
+	sigfillset(&mask_set);
+	sigdelset(&mask_set, SIGFPE);
+	sigdelset(&mask_set, SIGILL);
+	sigdelset(&mask_set, SIGSEGV);
+	sigdelset(&mask_set, SIGBUS);
+	pthread_sigmask(SIG_BLOCK, &mask_set, 0);
+#endif
+
+	util::detail::set_thread_name("zk/compress");
+
+	while ( true )
+		{
+		std::function<void()> job;
+
+			{
+			std::unique_lock<std::mutex> lock(mutex);
+			cond.wait(lock, [this]() { return stopping || ! jobs.empty(); });
+
+			if ( jobs.empty() )
+				return;
+
+			job = std::move(jobs.front());
+			jobs.pop_front();
+			}
+
+		job();
+		}
+	}
+
+BlockCompressor::BlockCompressor(const Codec* arg_codec, int arg_level, size_t arg_block_size,
+                                 CompressionPool* arg_pool)
+	: codec(arg_codec), level(arg_level), block_size(arg_block_size), pool(arg_pool)
+	{
+	assert(block_size > 0);
+
+	if ( pool && pool->NumThreads() == 0 )
+		pool = nullptr;
+
+	block.reserve(block_size);
+	}
+
+void BlockCompressor::Write(const char* data, size_t len)
+	{
+	while ( len > 0 )
+		{
+		size_t n = std::min(len, block_size - block.size());
+		block.append(data, n);
+		data += n;
+		len -= n;
+
+		if ( block.size() >= block_size )
+			Submit();
+		}
+	}
+
+void BlockCompressor::Flush()
+	{
+	if ( ! block.empty() )
+		Submit();
+	}
+
+void BlockCompressor::Submit()
+	{
+	auto job = std::make_shared<Job>();
+	job->input.swap(block);
+	block.reserve(block_size);
+
+	auto promise = std::make_shared<std::promise<bool>>();
+	job->success = promise->get_future();
+	pending.push_back(job);
+
+	auto compress = [codec = codec, level = level, job, promise]()
+	{
+		promise->set_value(
+			codec->Compress(job->input.data(), job->input.size(), level, &job->output));
+	};
+
+	if ( ! pool )
+		{
+		compress();
+		return;
+		}
+
+	pool->Submit(std::move(compress));
+
+	// Don't let a stream that writes faster than the pool can compress
+	// pile up blocks without bound.
+	if ( pending.size() > 2 * static_cast<size_t>(pool->NumThreads()) )
+		pending.front()->success.wait();
+	}
+
+bool BlockCompressor::Drain(std::string* out, bool wait)
+	{
+	while ( ! pending.empty() )
+		{
+		auto& job = pending.front();
+
+		if ( ! wait &&
+		     job->success.wait_for(std::chrono::seconds(0)) != std::future_status::ready )
+			break;
+
+		if ( ! job->success.get() )
+			{
+			pending.pop_front();
+			return false;
+			}
+
+		frames.emplace_back(static_cast<uint32_t>(job->output.size()),
+		                    static_cast<uint32_t>(job->input.size()));
+		out->append(job->output);
+		pending.pop_front();
+		}
+
+	return true;
+	}
+
+std::string BlockCompressor::SeekTable() const
+	{
+	if ( ! codec->HasSkippableFrames() )
+		return "";
+
+	// See the zstd seekable format: a skippable frame holding the sizes of
+	// each frame, followed by a footer. lz4 shares zstd's skippable frames.
+	std::string table;
+	put_u32le(&table, 0x184D2A5E);
+	put_u32le(&table, frames.size() * 8 + 9);
+
+	for ( const auto& [compressed, raw] : frames )
+		{
+		put_u32le(&table, compressed);
+		put_u32le(&table, raw);
+		}
+
+	put_u32le(&table, frames.size());
+	table.push_back(0); // No checksums.
+	put_u32le(&table, 0x8F92EAB1);
+	return table;
+	}
+
+TEST_SUITE_BEGIN("BlockCompressor");
+
+TEST_CASE("gzip frames in order")
+	{
+	auto codec = Codec::Lookup("gzip");
+	REQUIRE(codec);
+	CHECK(Codec::Lookup("nonesuch") == nullptr);
+	CHECK(codec->MaxLevel() == 9);
+
+	CompressionPool pool(2);
+	BlockCompressor bc(codec, 1, 1000, &pool);
+
+	std::string input;
+
+	for ( int i = 0; i < 500; ++i )
+		input += util::fmt("line %d\n", i);
+
+	bc.Write(input.data(), input.size());
+	bc.Flush();
+
+	std::string out;
+	CHECK(bc.Drain(&out, true));
+	CHECK(bc.SeekTable().empty());
+
+	// Decompress the concatenated gzip members.
+	std::string result;
+	z_stream zs;
+	memset(&zs, 0, sizeof(zs));
+	REQUIRE(inflateInit2(&zs, 15 + 32) == Z_OK);
+	zs.next_in = reinterpret_cast<Bytef*>(out.data());
+	zs.avail_in = out.size();
+
+	while ( zs.avail_in > 0 )
+		{
+		char buf[4096];
+		zs.next_out = reinterpret_cast<Bytef*>(buf);
+		zs.avail_out = sizeof(buf);
+		int res = inflate(&zs, Z_NO_FLUSH);
+		result.append(buf, sizeof(buf) - zs.avail_out);
+
+		if ( res == Z_STREAM_END )
+			inflateReset(&zs);
+		else if ( res != Z_OK )
+			break;
+		}
+
+	inflateEnd(&zs);
+	CHECK(result == input);
+	}
+
+TEST_SUITE_END();
+
+	} // namespace zeek::logging::detail
@@ -0,0 +1,199 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Block compression for log writers.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace zeek::logging::detail
+	{
+
+/**
+ * A compression algorithm that turns a block of data into a self-contained
+ * frame. Concatenating the frames of consecutive blocks yields a valid
+ * file for the codec's standard tools (gzip, zstd, lz4), while each frame
+ * can still be decompressed on its own.
+ */
+class Codec
+	{
+public:
+	virtual ~Codec() = default;
+
+	/**
+	 * Returns the codec's name, as used in the script-level options.
+	 */
+	virtual const char* Name() const = 0;
+
+	/**
+	 * Returns the file extension conventionally used for the codec.
+	 */
+	virtual const char* Extension() const = 0;
+
+	/**
+	 * Returns true if the codec's format has skippable frames, allowing
+	 * a seek table at the end of a file.
+	 */
+	virtual bool HasSkippableFrames() const = 0;
+
+	/**
+	 * Returns the highest compression level the codec supports. Valid
+	 * levels range from 1 to this, with 0 selecting the default.
+	 */
+	virtual int MaxLevel() const = 0;
+
+	/**
+	 * Compresses a block into a frame. Must be thread-safe.
+	 *
+	 * @param data The block.
+	 *
+	 * @param len The block's length.
+	 *
+	 * @param level The compression level, or 0 for the codec's default.
+	 *
+	 * @param out The frame is appended here.
+	 *
+	 * @return False if compression failed.
+	 */
+	virtual bool Compress(const char* data, size_t len, int level, std::string* out) const = 0;
+
+	/**
+	 * Returns the codec of the given name, or null if there's no such
+	 * codec or Zeek was built without support for it.
+	 */
+	static const Codec* Lookup(const std::string& name);
+	};
+
+/**
+ * A small pool of threads shared by all writers for compressing blocks, so
+ * that a single busy log stream can use more than one core.
+ */
+class CompressionPool
+	{
+public:
+	/**
+	 * Returns the pool, starting it on the first call.
+	 *
+	 * @param num_threads The number of threads to start the pool with.
+	 * Ignored once the pool runs.
+	 */
+	static CompressionPool* Instance(int num_threads);
+
+	explicit CompressionPool(int num_threads);
+	~CompressionPool();
+
+	CompressionPool(const CompressionPool&) = delete;
+	CompressionPool& operator=(const CompressionPool&) = delete;
+
+	/**
+	 * Returns the number of threads in the pool.
+	 */
+	int NumThreads() const { return static_cast<int>(threads.size()); }
+
+	/**
+	 * Queues a job for the next idle thread.
+	 */
+	void Submit(std::function<void()> job);
+
+private:
+	void Run();
+
+	std::vector<std::thread> threads;
+	std::deque<std::function<void()>> jobs;
+	std::mutex mutex;
+	std::condition_variable cond;
+	bool stopping = false;
+	};
+
+/**
+ * Buffers a writer's output and compresses it in blocks, each becoming an
+ * independent frame. With a pool, blocks are compressed in parallel while
+ * the writer carries on; frames are still handed back in order. Not
+ * thread-safe, but meant to be used by a single writer thread.
+ */
+class BlockCompressor
+	{
+public:
+	/**
+	 * Constructor.
+	 *
+	 * @param codec The codec to use.
+	 *
+	 * @param level The compression level, or 0 for the codec's default.
+	 *
+	 * @param block_size The number of bytes per block.
+	 *
+	 * @param pool The pool to compress blocks in, or null to compress on
+	 * the calling thread.
+	 */
+	BlockCompressor(const Codec* codec, int level, size_t block_size, CompressionPool* pool);
+
+	/**
+	 * Destructor. Blocks still being compressed are discarded.
+	 */
+	~BlockCompressor() = default;
+
+	BlockCompressor(const BlockCompressor&) = delete;
+	BlockCompressor& operator=(const BlockCompressor&) = delete;
+
+	/**
+	 * Adds data, starting to compress the current block once it's full.
+	 */
+	void Write(const char* data, size_t len);
+
+	/**
+	 * Starts to compress the current block even if it isn't full.
+	 */
+	void Flush();
+
+	/**
+	 * Appends the frames that are done, in order, to the given string.
+	 *
+	 * @param out The string to append to.
+	 *
+	 * @param wait If true, waits for all blocks passed on so far.
+	 *
+	 * @return False if compressing a block failed.
+	 */
+	bool Drain(std::string* out, bool wait);
+
+	/**
+	 * Returns a seek table listing the frames drained so far, in the
+	 * zstd seekable format, or an empty string if the codec has no
+	 * skippable frames. It's meant to be the last frame of a file.
+	 */
+	std::string SeekTable() const;
+
+private:
+	// Owned jointly with the pool's thread, so that it may outlive us.
+	struct Job
+		{
+		std::string input;
+		std::string output;
+		std::future<bool> success;
+		};
+
+	void Submit();
+
+	const Codec* codec;
+	int level;
+	size_t block_size;
+	CompressionPool* pool;
+
+	std::string block; // Current block.
+	std::deque<std::shared_ptr<Job>> pending; // In file order.
+
+	std::vector<std::pair<uint32_t, uint32_t>> frames; // Compressed and raw sizes.
+	};
+
+	} // namespace zeek::logging::detail
@@ -17,6 +17,7 @@
 #include "zeek/Type.h"
 #include "zeek/broker/Manager.h"
 #include "zeek/input.h"
+#include "zeek/logging/WriteBatch.h"
 #include "zeek/logging/WriterBackend.h"
 #include "zeek/logging/WriterFrontend.h"
 #include "zeek/logging/logging.bif.h"
@@ -939,16 +940,22 @@ bool Manager::Write(EnumVal* id, RecordVal* columns_arg)
 
 		// Alright, can do the write now.
 
-		threading::Value** vals = RecordToFilterVals(stream, filter, columns.get());
+		assert(writer);
+		threading::Value** vals = RecordToFilterVals(stream, filter, columns.get(), writer);
+
+		if ( ! vals )
+			continue;
+
+		bool hooked = plugin_mgr->HavePluginForHook(plugin::HOOK_LOG_WRITE);
 
-		if ( ! PLUGIN_HOOK_WITH_RESULT(
-				 HOOK_LOG_WRITE,
-				 HookLogWrite(
-					 filter->writer->GetType()->AsEnumType()->Lookup(filter->writer->InternalInt()),
-					 filter->name, *info, filter->num_fields, filter->fields, vals),
-				 true) )
+		if ( hooked &&
+		     ! plugin_mgr->HookLogWrite(
+				 filter->writer->GetType()->AsEnumType()->Lookup(filter->writer->InternalInt()),
+				 filter->name, *info, filter->num_fields, filter->fields, vals) )
 			{
-			DeleteVals(filter->num_fields, vals);
+			// Values the plugin replaced need to go with the row.
+			writer->CurrentBatch(filter->num_fields)->AdoptReplacedValues();
+			writer->DiscardRow();
 
 #ifdef DEBUG
 			DBG_LOG(DBG_LOGGING, "Hook prevented writing to filter '%s' on stream '%s'",
@@ -957,12 +964,15 @@ bool Manager::Write(EnumVal* id, RecordVal* columns_arg)
 			return true;
 			}
 
+		// The values live in the batch's columns. A plugin that replaced
+		// any of them handed us new ones, which need to move there.
+		if ( hooked )
+			writer->CurrentBatch(filter->num_fields)->AdoptReplacedValues();
+
 		assert(w != stream->writers.end());
 		w->second->total_writes.Inc();
 
-		// Write takes ownership of vals.
-		assert(writer);
-		writer->Write(filter->num_fields, vals);
+		writer->WriteRow();
 
 #ifdef DEBUG
 		DBG_LOG(DBG_LOGGING, "Wrote record to filter '%s' on stream '%s'", filter->name.c_str(),
@@ -973,15 +983,16 @@ bool Manager::Write(EnumVal* id, RecordVal* columns_arg)
 	return true;
 	}
 
-threading::Value* Manager::ValToLogVal(Val* val, Type* ty)
+void Manager::ValToLogVal(threading::Value* lval, Val* val, Type* ty, threading::ValueArena& arena)
 	{
 	if ( ! ty )
 		ty = val->GetType().get();
 
-	if ( ! val )
-		return new threading::Value(ty->Tag(), false);
+	lval->type = ty->Tag();
+	lval->present = val != nullptr;
 
-	threading::Value* lval = new threading::Value(ty->Tag());
+	if ( ! val )
+		return;
 
 	switch ( lval->type )
 		{
@@ -996,14 +1007,14 @@ threading::Value* Manager::ValToLogVal(Val* val, Type* ty)
 
 			if ( s )
 				{
-				lval->val.string_val.data = util::copy_string(s);
 				lval->val.string_val.length = strlen(s);
+				lval->val.string_val.data = arena.CopyString(s, lval->val.string_val.length);
 				}
 
 			else
 				{
 				val->GetType()->Error("enum type does not contain value", val);
-				lval->val.string_val.data = util::copy_string("");
+				lval->val.string_val.data = arena.CopyString("", 0);
 				lval->val.string_val.length = 0;
 				}
 			break;
@@ -1035,10 +1046,8 @@ threading::Value* Manager::ValToLogVal(Val* val, Type* ty)
 		case TYPE_STRING:
 			{
 			const String* s = val->AsString();
-			char* buf = new char[s->Len()];
-			memcpy(buf, s->Bytes(), s->Len());
-
-			lval->val.string_val.data = buf;
+			lval->val.string_val.data = arena.CopyString(reinterpret_cast<const char*>(s->Bytes()),
+			                                             s->Len());
 			lval->val.string_val.length = s->Len();
 			break;
 			}
@@ -1047,7 +1056,7 @@ threading::Value* Manager::ValToLogVal(Val* val, Type* ty)
 			{
 			const File* f = val->AsFile();
 			string s = f->Name();
-			lval->val.string_val.data = util::copy_string(s.c_str());
+			lval->val.string_val.data = arena.CopyString(s.data(), s.size());
 			lval->val.string_val.length = s.size();
 			break;
 			}
@@ -1058,8 +1067,8 @@ threading::Value* Manager::ValToLogVal(Val* val, Type* ty)
 			const Func* f = val->AsFunc();
 			f->Describe(&d);
 			const char* s = d.Description();
-			lval->val.string_val.data = util::copy_string(s);
 			lval->val.string_val.length = strlen(s);
+			lval->val.string_val.data = arena.CopyString(s, lval->val.string_val.length);
 			break;
 			}
 
@@ -1072,10 +1081,14 @@ threading::Value* Manager::ValToLogVal(Val* val, Type* ty)
 				set = make_intrusive<ListVal>(TYPE_INT);
 
 			lval->val.set_val.size = set->Length();
-			lval->val.set_val.vals = new threading::Value*[lval->val.set_val.size];
+			lval->val.set_val.vals = arena.NewValueArray(lval->val.set_val.size);
 
 			for ( zeek_int_t i = 0; i < lval->val.set_val.size; i++ )
-				lval->val.set_val.vals[i] = ValToLogVal(set->Idx(i).get());
+				{
+				const auto& v = set->Idx(i);
+				lval->val.set_val.vals[i] = arena.NewValue(v->GetType()->Tag());
+				ValToLogVal(lval->val.set_val.vals[i], v.get(), nullptr, arena);
+				}
 
 			break;
 			}
@@ -1084,12 +1097,14 @@ threading::Value* Manager::ValToLogVal(Val* val, Type* ty)
 			{
 			VectorVal* vec = val->AsVectorVal();
 			lval->val.vector_val.size = vec->Size();
-			lval->val.vector_val.vals = new threading::Value*[lval->val.vector_val.size];
+			lval->val.vector_val.vals = arena.NewValueArray(lval->val.vector_val.size);
+			const auto& yield = vec->GetType()->Yield();
 
 			for ( zeek_int_t i = 0; i < lval->val.vector_val.size; i++ )
 				{
-				lval->val.vector_val.vals[i] = ValToLogVal(vec->ValAt(i).get(),
-				                                           vec->GetType()->Yield().get());
+				lval->val.vector_val.vals[i] = arena.NewValue(yield->Tag());
+				ValToLogVal(lval->val.vector_val.vals[i], vec->ValAt(i).get(), yield.get(),
+				            arena);
 				}
 
 			break;
@@ -1098,11 +1113,10 @@ threading::Value* Manager::ValToLogVal(Val* val, Type* ty)
 		default:
 			reporter->InternalError("unsupported type %s for log_write", type_name(lval->type));
 		}
-
-	return lval;
 	}
 
-threading::Value** Manager::RecordToFilterVals(Stream* stream, Filter* filter, RecordVal* columns)
+threading::Value** Manager::RecordToFilterVals(Stream* stream, Filter* filter, RecordVal* columns,
+                                               WriterFrontend* writer)
 	{
 	RecordValPtr ext_rec;
 
@@ -1114,7 +1128,14 @@ threading::Value** Manager::RecordToFilterVals(Stream* stream, Filter* filter, R
 			ext_rec = {AdoptRef{}, res.release()->AsRecordVal()};
 		}
 
-	threading::Value** vals = new threading::Value*[filter->num_fields];
+	// Only now get the batch, as the extension function may have written
+	// to this log as well, and thereby flushed the writer's batch.
+	WriteBatch* batch = writer->CurrentBatch(filter->num_fields);
+
+	if ( ! batch )
+		return nullptr;
+
+	threading::Value** vals = batch->AddRow();
 
 	for ( int i = 0; i < filter->num_fields; ++i )
 		{
@@ -1124,7 +1145,8 @@ threading::Value** Manager::RecordToFilterVals(Stream* stream, Filter* filter, R
 			if ( ! ext_rec )
 				{
 				// executing function did not return record. Send empty for all vals.
-				vals[i] = new threading::Value(filter->fields[i]->type, false);
+				vals[i]->type = filter->fields[i]->type;
+				vals[i]->present = false;
 				continue;
 				}
 
@@ -1147,13 +1169,14 @@ threading::Value** Manager::RecordToFilterVals(Stream* stream, Filter* filter, R
 			if ( ! val )
 				{
 				// Value, or any of its parents, is not set.
-				vals[i] = new threading::Value(filter->fields[i]->type, false);
+				vals[i]->type = filter->fields[i]->type;
+				vals[i]->present = false;
 				break;
 				}
 			}
 
 		if ( val )
-			vals[i] = ValToLogVal(val);
+			ValToLogVal(vals[i], val, nullptr, batch->Arena());
 		}
 
 	return vals;
@@ -27,6 +27,11 @@ namespace detail
 class SerializationFormat;
 	}
 
+namespace threading
+	{
+class ValueArena;
+	}
+
 namespace logging
 	{
 
@@ -289,9 +294,14 @@ private:
 	bool TraverseRecord(Stream* stream, Filter* filter, RecordType* rt, TableVal* include,
 	                    TableVal* exclude, const std::string& path, const std::list<int>& indices);
 
-	threading::Value** RecordToFilterVals(Stream* stream, Filter* filter, RecordVal* columns);
+	// Converts a record into a new row of the writer's current batch.
+	// Returns nullptr if the writer doesn't take the filter's fields.
+	threading::Value** RecordToFilterVals(Stream* stream, Filter* filter, RecordVal* columns,
+	                                      WriterFrontend* writer);
 
-	threading::Value* ValToLogVal(Val* val, Type* ty = nullptr);
+	// Fills in lval with the value of val, allocating any data it points
+	// to from the arena. A nil val yields an unset value of type ty.
+	void ValToLogVal(threading::Value* lval, Val* val, Type* ty, threading::ValueArena& arena);
 	Stream* FindStream(EnumVal* id);
 	void RemoveDisabledWriters(Stream* stream);
 	void InstallRotationTimer(WriterInfo* winfo);
@@ -0,0 +1,287 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek/logging/WriteBatch.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "zeek/3rdparty/doctest.h"
+#include "zeek/util.h"
+
+using zeek::threading::Value;
+
+namespace zeek::logging
+	{
+
+// Takes over a value's data, leaving the value itself without any.
+static void move_value(Value* dst, Value* src)
+	{
+	dst->type = src->type;
+	dst->subtype = src->subtype;
+	dst->present = src->present;
+	dst->val = src->val;
+	dst->SetFileLineNumber(src->GetFileLineNumber());
+	src->present = false;
+	}
+
+WriteBatch::WriteBatch(int arg_num_fields, int arg_capacity)
+	: num_fields(arg_num_fields), capacity(arg_capacity), columns(arg_num_fields),
+	  columns_end(arena.GetMark())
+	{
+	rows.reserve(capacity);
+	}
+
+WriteBatch::~WriteBatch()
+	{
+	for ( int j = 0; j < NumRows(); ++j )
+		if ( rows[j].adopted )
+			for ( int i = 0; i < num_fields; ++i )
+				columns[i][j].~Value();
+	}
+
+int WriteBatch::NextRow()
+	{
+	int row = NumRows();
+
+	if ( row < column_size )
+		return row;
+
+	int n = column_size > 0 ? column_size * 2 : 16;
+
+	if ( column_size < capacity )
+		n = std::min(n, capacity);
+
+	n = std::max(n, row + 1);
+
+	// The old columns stay behind in the arena until the batch goes away.
+	for ( int i = 0; i < num_fields; ++i )
+		{
+		auto c = static_cast<Value*>(arena.Allocate(n * sizeof(Value)));
+
+		for ( int j = 0; j < row; ++j )
+			{
+			new (&c[j]) Value();
+			move_value(&c[j], &columns[i][j]);
+			rows[j].vals[i] = &c[j];
+			}
+
+		columns[i] = c;
+		}
+
+	column_size = n;
+	columns_end = arena.GetMark();
+	return row;
+	}
+
+Value** WriteBatch::AddRow()
+	{
+	int row = NextRow();
+	auto mark = arena.GetMark();
+	auto vals = arena.NewValueArray(num_fields);
+
+	for ( int i = 0; i < num_fields; ++i )
+		vals[i] = new (&columns[i][row]) Value();
+
+	rows.push_back({vals, mark, false});
+	return vals;
+	}
+
+void WriteBatch::AdoptRow(Value** arg_vals)
+	{
+	int row = NextRow();
+	auto mark = arena.GetMark();
+	auto vals = arena.NewValueArray(num_fields);
+
+	for ( int i = 0; i < num_fields; ++i )
+		{
+		vals[i] = new (&columns[i][row]) Value();
+		move_value(vals[i], arg_vals[i]);
+		}
+
+	Value::delete_value_ptr_array(arg_vals, num_fields);
+	rows.push_back({vals, mark, true});
+	}
+
+int WriteBatch::AdoptReplacedValues()
+	{
+	int row = NumRows() - 1;
+	auto& r = rows.back();
+	int replaced = 0;
+
+	for ( int i = 0; i < num_fields; ++i )
+		{
+		Value* v = &columns[i][row];
+
+		if ( r.vals[i] == v )
+			continue;
+
+		if ( r.adopted )
+			{
+			v->~Value();
+			new (v) Value();
+			move_value(v, r.vals[i]);
+			}
+		else
+			// This allocates after the row's mark, so popping the row
+			// releases the copy as well.
+			arena.CopyValue(v, *r.vals[i]);
+
+		delete r.vals[i];
+		r.vals[i] = v;
+		++replaced;
+		}
+
+	return replaced;
+	}
+
+void WriteBatch::PopRow()
+	{
+	int row = NumRows() - 1;
+	auto& r = rows.back();
+
+	if ( r.adopted )
+		for ( int i = 0; i < num_fields; ++i )
+			columns[i][row].~Value();
+
+	// If the columns grew for a later row, which has been popped since,
+	// they now sit after this row's mark. Keep them.
+	auto m = r.mark;
+
+	if ( m.block < columns_end.block ||
+	     (m.block == columns_end.block && m.used < columns_end.used) )
+		m = columns_end;
+
+	arena.Release(m);
+	rows.pop_back();
+	}
+
+	} // namespace zeek::logging
+
+using zeek::logging::WriteBatch;
+
+TEST_SUITE_BEGIN("WriteBatch");
+
+TEST_CASE("popped rows are reused")
+	{
+	WriteBatch batch(2, 10);
+
+	auto vals = batch.AddRow();
+	vals[0]->type = zeek::TYPE_COUNT;
+	vals[0]->val.uint_val = 1;
+	vals[1]->type = zeek::TYPE_STRING;
+	vals[1]->val.string_val.data = batch.Arena().CopyString("one", 3);
+	vals[1]->val.string_val.length = 3;
+
+	auto capacity = batch.Arena().Capacity();
+	auto popped = batch.AddRow();
+	batch.Arena().CopyString("popped", 6);
+	batch.PopRow();
+
+	CHECK(batch.NumRows() == 1);
+	CHECK(batch.AddRow() == popped);
+	CHECK(batch.Arena().Capacity() == capacity);
+	CHECK(batch.At(0, 0).val.uint_val == 1);
+	CHECK(strcmp(batch.At(0, 1).val.string_val.data, "one") == 0);
+	}
+
+TEST_CASE("filling up with arena and adopted rows")
+	{
+	WriteBatch batch(1, 3);
+
+	for ( zeek_uint_t i = 0; i < 3; ++i )
+		{
+		CHECK_FALSE(batch.Full());
+
+		if ( i == 1 )
+			{
+			auto vals = new Value*[1];
+			vals[0] = new Value(zeek::TYPE_COUNT);
+			vals[0]->val.uint_val = i;
+			batch.AdoptRow(vals);
+			}
+		else
+			{
+			auto vals = batch.AddRow();
+			vals[0]->type = zeek::TYPE_COUNT;
+			vals[0]->val.uint_val = i;
+			}
+		}
+
+	CHECK(batch.Full());
+
+	for ( int i = 0; i < batch.NumRows(); ++i )
+		CHECK(batch.At(i, 0).val.uint_val == static_cast<zeek_uint_t>(i));
+
+	// Popping the last arena row leaves the adopted one, which the batch
+	// then deletes when it goes away.
+	batch.PopRow();
+	CHECK_FALSE(batch.Full());
+	CHECK(batch.Row(1)[0]->val.uint_val == 1);
+	}
+
+TEST_CASE("columns grow and stay contiguous")
+	{
+	WriteBatch batch(2, 40);
+
+	for ( zeek_uint_t i = 0; i < 40; ++i )
+		{
+		auto vals = batch.AddRow();
+		vals[0]->type = zeek::TYPE_COUNT;
+		vals[0]->val.uint_val = i;
+		vals[1]->type = zeek::TYPE_STRING;
+		vals[1]->val.string_val.data = batch.Arena().CopyString("x", 1);
+		vals[1]->val.string_val.length = 1;
+		}
+
+	auto counts = batch.Column(0);
+
+	for ( int i = 0; i < batch.NumRows(); ++i )
+		{
+		CHECK(counts[i].val.uint_val == static_cast<zeek_uint_t>(i));
+		CHECK(batch.Row(i)[0] == &counts[i]);
+		CHECK(batch.Row(i)[1] == &batch.Column(1)[i]);
+		}
+
+	// Popping back beyond where the columns last grew must leave them be.
+	for ( int i = 0; i < 30; ++i )
+		batch.PopRow();
+
+	auto vals = batch.AddRow();
+	vals[0]->type = zeek::TYPE_COUNT;
+	vals[0]->val.uint_val = 100;
+	vals[1]->type = zeek::TYPE_STRING;
+	vals[1]->val.string_val.data = batch.Arena().CopyString("overwrite", 9);
+	vals[1]->val.string_val.length = 9;
+
+	CHECK(batch.Column(0) == counts);
+	CHECK(batch.At(9, 0).val.uint_val == 9);
+	CHECK(batch.At(10, 0).val.uint_val == 100);
+	CHECK(strcmp(batch.At(9, 1).val.string_val.data, "x") == 0);
+	}
+
+TEST_CASE("replaced values are adopted")
+	{
+	WriteBatch batch(2, 10);
+
+	auto vals = batch.AddRow();
+	vals[0]->type = zeek::TYPE_COUNT;
+	vals[0]->val.uint_val = 1;
+	vals[1]->type = zeek::TYPE_STRING;
+	vals[1]->val.string_val.data = batch.Arena().CopyString("old", 3);
+	vals[1]->val.string_val.length = 3;
+
+	CHECK(batch.AdoptReplacedValues() == 0);
+
+	// What a plugin hooking log writes might do.
+	auto s = new Value(zeek::TYPE_STRING);
+	s->val.string_val.data = zeek::util::copy_string("new");
+	s->val.string_val.length = 3;
+	vals[1] = s;
+
+	CHECK(batch.AdoptReplacedValues() == 1);
+	CHECK(vals[1] == &batch.Column(1)[0]);
+	CHECK(strcmp(batch.At(0, 1).val.string_val.data, "new") == 0);
+	CHECK(batch.At(0, 0).val.uint_val == 1);
+	}
+
+TEST_SUITE_END();
@@ -0,0 +1,146 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#pragma once
+
+#include <vector>
+
+#include "zeek/threading/SerialTypes.h"
+#include "zeek/threading/ValueArena.h"
+
+namespace zeek::logging
+	{
+
+/**
+ * A batch of log records on their way from a WriterFrontend to its
+ * WriterBackend. The logging::Manager fills in records' values directly in
+ * the batch's arena, so converting a record allocates nothing per value,
+ * and the frontend hands the whole batch to the writer thread with a single
+ * message. The batch, and with it all of its values, is freed in one go
+ * once the backend has written it.
+ *
+ * Records that arrive already converted, such as from remote peers, are
+ * adopted into the batch, which takes over the data their values point to.
+ *
+ * The values of each field are stored contiguously, one after the other, so
+ * writers that work a column at a time, such as the columnar writer, can
+ * walk them with Column(). Each record additionally gets an array of
+ * pointers to its values, the shape that WriterBackend::DoWrite() takes.
+ */
+class WriteBatch
+	{
+public:
+	/**
+	 * Constructor.
+	 *
+	 * @param num_fields The number of fields of each record.
+	 *
+	 * @param capacity The number of records the batch is meant to hold.
+	 * The columns start out smaller and grow up to that as needed.
+	 */
+	WriteBatch(int num_fields, int capacity);
+
+	~WriteBatch();
+
+	WriteBatch(const WriteBatch&) = delete;
+	WriteBatch& operator=(const WriteBatch&) = delete;
+
+	/**
+	 * Returns the number of fields of each record.
+	 */
+	int NumFields() const { return num_fields; }
+
+	/**
+	 * Returns the number of records in the batch.
+	 */
+	int NumRows() const { return static_cast<int>(rows.size()); }
+
+	/**
+	 * Returns true if the batch holds as many records as it's meant to.
+	 */
+	bool Full() const { return NumRows() >= capacity; }
+
+	/**
+	 * Adds a record whose values live in the batch's arena. The values
+	 * start out as TYPE_ERROR; the caller fills them in, allocating any
+	 * data they point to from Arena().
+	 *
+	 * @return An array of NumFields() values.
+	 */
+	threading::Value** AddRow();
+
+	/**
+	 * Adds a record whose values were allocated with new. The batch moves
+	 * them into its columns, taking ownership of their data, and deletes
+	 * the array and the values themselves right away.
+	 *
+	 * @param vals An array of NumFields() values, allocated with new[].
+	 */
+	void AdoptRow(threading::Value** vals);
+
+	/**
+	 * Moves values that were swapped out of the most recently added
+	 * record's array, such as by a HookLogWrite() plugin, back into the
+	 * batch's columns. Each replacement must have been allocated with
+	 * new; the batch copies it and deletes it.
+	 *
+	 * @return The number of values that had been replaced.
+	 */
+	int AdoptReplacedValues();
+
+	/**
+	 * Removes the most recently added record, releasing its memory.
+	 */
+	void PopRow();
+
+	/**
+	 * Returns the values of a record.
+	 *
+	 * @param row The record's index.
+	 */
+	threading::Value** Row(int row) const { return rows[row].vals; }
+
+	/**
+	 * Returns a value of a record.
+	 *
+	 * @param row The record's index.
+	 *
+	 * @param field The field's index.
+	 */
+	const threading::Value& At(int row, int field) const { return columns[field][row]; }
+
+	/**
+	 * Returns the values of a field, one per record, stored contiguously.
+	 * They remain valid until the next record gets added.
+	 *
+	 * @param field The field's index.
+	 *
+	 * @return An array of NumRows() values.
+	 */
+	const threading::Value* Column(int field) const { return columns[field]; }
+
+	/**
+	 * Returns the arena that AddRow() allocates from.
+	 */
+	threading::ValueArena& Arena() { return arena; }
+
+private:
+	struct RowInfo
+		{
+		threading::Value** vals;
+		threading::ValueArena::Mark mark; // Arena position prior to the row.
+		bool adopted; // Its values own their data, rather than the arena.
+		};
+
+	// Makes room in the columns for another row, returning its index.
+	int NextRow();
+
+	int num_fields;
+	int capacity;
+	int column_size = 0; // The number of rows the columns have room for.
+	std::vector<threading::Value*> columns; // In the arena, one per field.
+	threading::ValueArena::Mark columns_end; // Arena position after the columns.
+	std::vector<RowInfo> rows;
+	threading::ValueArena arena;
+	};
+
+	} // namespace zeek::logging
@@ -3,8 +3,13 @@
 #include "zeek/logging/WriterBackend.h"
 
 #include <broker/data.hh>
+#include <memory>
+#include <vector>
 
+#include "zeek/3rdparty/doctest.h"
+#include "zeek/Type.h"
 #include "zeek/logging/Manager.h"
+#include "zeek/logging/WriteBatch.h"
 #include "zeek/logging/WriterFrontend.h"
 #include "zeek/threading/SerialTypes.h"
 #include "zeek/util.h"
@@ -160,20 +165,6 @@ WriterBackend::~WriterBackend()
 	delete info;
 	}
 
-void WriterBackend::DeleteVals(int num_writes, Value*** vals)
-	{
-	for ( int j = 0; j < num_writes; ++j )
-		{
-		// Note this code is duplicated in Manager::DeleteVals().
-		for ( int i = 0; i < num_fields; i++ )
-			delete vals[j][i];
-
-		delete[] vals[j];
-		}
-
-	delete[] vals;
-	}
-
 bool WriterBackend::FinishedRotation(const char* new_name, const char* old_name, double open,
                                      double close, bool terminating)
 	{
@@ -213,39 +204,39 @@ bool WriterBackend::Init(int arg_num_fields, const Field* const* arg_fields)
 	return true;
 	}
 
-bool WriterBackend::Write(int arg_num_fields, int num_writes, Value*** vals)
+bool WriterBackend::Write(WriteBatch* arg_batch)
 	{
+	std::unique_ptr<WriteBatch> batch(arg_batch);
+
 	// Double-check that the arguments match. If we get this from remote,
 	// something might be mixed up.
-	if ( num_fields != arg_num_fields )
+	if ( num_fields != batch->NumFields() )
 		{
 
 #ifdef DEBUG
 		const char* msg = Fmt("Number of fields don't match in WriterBackend::Write() (%d vs. %d)",
-		                      arg_num_fields, num_fields);
+		                      batch->NumFields(), num_fields);
 		Debug(DBG_LOGGING, msg);
 #endif
 
-		DeleteVals(num_writes, vals);
 		DisableFrontend();
 		return false;
 		}
 
 	// Double-check all the types match.
-	for ( int j = 0; j < num_writes; j++ )
+	for ( int j = 0; j < batch->NumRows(); j++ )
 		{
 		for ( int i = 0; i < num_fields; ++i )
 			{
-			if ( vals[j][i]->type != fields[i]->type )
+			if ( batch->At(j, i).type != fields[i]->type )
 				{
 #ifdef DEBUG
 				const char* msg = Fmt(
 					"Field #%d type doesn't match in WriterBackend::Write() (%d vs. %d)", i,
-					vals[j][i]->type, fields[i]->type);
+					batch->At(j, i).type, fields[i]->type);
 				Debug(DBG_LOGGING, msg);
 #endif
 				DisableFrontend();
-				DeleteVals(num_writes, vals);
 				return false;
 				}
 			}
@@ -254,17 +245,7 @@ bool WriterBackend::Write(int arg_num_fields, int num_writes, Value*** vals)
 	bool success = true;
 
 	if ( ! Failed() )
-		{
-		for ( int j = 0; j < num_writes; j++ )
-			{
-			success = DoWrite(num_fields, fields, vals[j]);
-
-			if ( ! success )
-				break;
-			}
-		}
-
-	DeleteVals(num_writes, vals);
+		success = DoWriteBatch(num_fields, fields, *batch);
 
 	if ( ! success )
 		DisableFrontend();
@@ -272,6 +253,18 @@ bool WriterBackend::Write(int arg_num_fields, int num_writes, Value*** vals)
 	return success;
 	}
 
+bool WriterBackend::DoWriteBatch(int num_fields, const Field* const* fields,
+                                 const WriteBatch& batch)
+	{
+	for ( int j = 0; j < batch.NumRows(); j++ )
+		{
+		if ( ! DoWrite(num_fields, fields, batch.Row(j)) )
+			return false;
+		}
+
+	return true;
+	}
+
 bool WriterBackend::SetBuf(bool enabled)
 	{
 	if ( enabled == buffering )
@@ -348,3 +341,89 @@ bool WriterBackend::OnHeartbeat(double network_time, double current_time)
 	}
 
 	} // namespace zeek::logging
+
+namespace
+	{
+
+// A writer that only records the rows DoWrite() sees. It fails the row
+// holding a given value.
+class RowRecorder final : public zeek::logging::WriterBackend
+	{
+public:
+	RowRecorder(zeek::logging::WriterFrontend* frontend, zeek_uint_t fail_on)
+		: WriterBackend(frontend), fail_on(fail_on)
+		{
+		}
+
+	using WriterBackend::DoWriteBatch;
+
+	std::vector<zeek_uint_t> rows;
+
+protected:
+	bool DoInit(const WriterInfo& info, int num_fields, const Field* const* fields) override
+		{
+		return true;
+		}
+
+	bool DoWrite(int num_fields, const Field* const* fields, Value** vals) override
+		{
+		rows.push_back(vals[0]->val.uint_val);
+		return vals[0]->val.uint_val != fail_on;
+		}
+
+	bool DoSetBuf(bool enabled) override { return true; }
+	bool DoFlush(double network_time) override { return true; }
+	bool DoRotate(const char* rotated_path, double open, double close, bool terminating) override
+		{
+		return true;
+		}
+	bool DoFinish(double network_time) override { return true; }
+	bool DoHeartbeat(double network_time, double current_time) override { return true; }
+
+private:
+	zeek_uint_t fail_on;
+	};
+
+	} // namespace
+
+TEST_SUITE_BEGIN("WriterBackend");
+
+TEST_CASE("DoWriteBatch falls back to DoWrite")
+	{
+	auto et = zeek::make_intrusive<zeek::EnumType>("Test::Writer");
+	et->AddNameInternal("Test::WRITER", 0);
+	const auto& ev = et->GetEnumVal(0);
+
+	zeek::logging::WriterBackend::WriterInfo info;
+	info.path = zeek::util::copy_string("test");
+
+	// Neither local nor remote, so the frontend starts no writer of its own.
+	zeek::logging::WriterFrontend frontend(info, ev.get(), ev.get(), false, false);
+
+	// Never started; the thread manager owns and eventually deletes it.
+	auto writer = new RowRecorder(&frontend, 3);
+
+	Field field("n", nullptr, zeek::TYPE_COUNT, zeek::TYPE_VOID, false);
+	const Field* fields[] = {&field};
+
+	zeek::logging::WriteBatch batch(1, 5);
+
+	for ( zeek_uint_t i = 0; i < 5; ++i )
+		{
+		auto vals = batch.AddRow();
+		vals[0]->type = zeek::TYPE_COUNT;
+		vals[0]->val.uint_val = i;
+		}
+
+	// Every row goes to DoWrite() in order, up to the first failure.
+	CHECK_FALSE(writer->DoWriteBatch(1, fields, batch));
+	CHECK(writer->rows == std::vector<zeek_uint_t>({0, 1, 2, 3}));
+
+	writer->rows.clear();
+	batch.PopRow();
+	batch.PopRow();
+	CHECK(writer->DoWriteBatch(1, fields, batch));
+	CHECK(writer->rows == std::vector<zeek_uint_t>({0, 1, 2}));
+	}
+
+TEST_SUITE_END();
@@ -16,6 +16,7 @@ namespace zeek::logging
 	{
 
 class WriterFrontend;
+class WriteBatch;
 
 /**
  * Base class for writer implementation. When the logging::Manager creates a
@@ -149,21 +150,18 @@ public:
 	bool Init(int num_fields, const threading::Field* const* fields);
 
 	/**
-	 * Writes one log entry.
+	 * Writes a batch of log entries.
 	 *
-	 * @param num_fields: The number of log fields for this stream. The
-	 * value must match what was passed to Init().
-	 *
-	 * @param An array of size \a num_fields with the log values. Their
-	 * types must match with the field passed to Init(). The method
-	 * takes ownership of \a vals..
+	 * @param batch The entries. Their number of fields and value types
+	 * must match with the fields passed to Init(). The method takes
+	 * ownership of the batch.
 	 *
 	 * Returns false if an error occurred, in which case the writer must
 	 * not be used any further.
 	 *
 	 * @return False if an error occurred.
 	 */
-	bool Write(int num_fields, int num_writes, threading::Value*** vals);
+	bool Write(WriteBatch* batch);
 
 	/**
 	 * Sets the buffering status for the writer, assuming the writer
@@ -296,6 +294,20 @@ protected:
 	virtual bool DoWrite(int num_fields, const threading::Field* const* fields,
 	                     threading::Value** vals) = 0;
 
+	/**
+	 * Writer-specific output method implementing recording of a batch of
+	 * log entries, as buffered by the frontend.
+	 *
+	 * A writer implementation may override this method to process a
+	 * whole batch at once, by row with WriteBatch::Row() or by field with
+	 * WriteBatch::Column(). The default implementation calls DoWrite() for
+	 * each entry, in order, and stops at the first one that fails. The
+	 * batch's values are only valid for the duration of the call. The
+	 * same error semantics as for DoWrite() apply.
+	 */
+	virtual bool DoWriteBatch(int num_fields, const threading::Field* const* fields,
+	                          const WriteBatch& batch);
+
 	/**
 	 * Writer-specific method implementing a change of the buffering
 	 * state.  If buffering is disabled, the writer should attempt to
@@ -386,11 +398,6 @@ protected:
 	virtual bool DoHeartbeat(double network_time, double current_time) = 0;
 
 private:
-	/**
-	 * Deletes the values as passed into Write().
-	 */
-	void DeleteVals(int num_writes, threading::Value*** vals);
-
 	// Frontend that instantiated us. This object must not be access from
 	// this class, it's running in a different thread!
 	WriterFrontend* frontend;
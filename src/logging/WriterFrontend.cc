@@ -3,6 +3,7 @@
 #include "zeek/RunState.h"
 #include "zeek/broker/Manager.h"
 #include "zeek/logging/Manager.h"
+#include "zeek/logging/WriteBatch.h"
 #include "zeek/logging/WriterBackend.h"
 #include "zeek/threading/SerialTypes.h"
 
@@ -56,18 +57,15 @@ private:
 class WriteMessage final : public threading::InputMessage<WriterBackend>
 	{
 public:
-	WriteMessage(WriterBackend* backend, int num_fields, int num_writes, Value*** vals)
-		: threading::InputMessage<WriterBackend>("Write", backend), num_fields(num_fields),
-		  num_writes(num_writes), vals(vals)
+	WriteMessage(WriterBackend* backend, WriteBatch* batch)
+		: threading::InputMessage<WriterBackend>("Write", backend), batch(batch)
 		{
 		}
 
-	bool Process() override { return Object()->Write(num_fields, num_writes, vals); }
+	bool Process() override { return Object()->Write(batch.release()); }
 
 private:
-	int num_fields;
-	int num_writes;
-	Value*** vals;
+	std::unique_ptr<WriteBatch> batch;
 	};
 
 class SetBufMessage final : public threading::InputMessage<WriterBackend>
@@ -112,8 +110,7 @@ WriterFrontend::WriterFrontend(const WriterBackend::WriterInfo& arg_info, EnumVa
 	buf = true;
 	local = arg_local;
 	remote = arg_remote;
-	write_buffer = nullptr;
-	write_buffer_pos = 0;
+	write_batch = nullptr;
 	info = new WriterBackend::WriterInfo(arg_info);
 
 	num_fields = 0;
@@ -141,6 +138,8 @@ WriterFrontend::~WriterFrontend()
 
 	delete[] fields;
 
+	delete write_batch;
+
 	Unref(stream);
 	Unref(writer);
 	delete info;
@@ -204,43 +203,68 @@ void WriterFrontend::Write(int arg_num_fields, Value** vals)
 		return;
 		}
 
-	if ( remote )
+	CurrentBatch(num_fields)->AdoptRow(vals);
+	WriteRow();
+	}
+
+WriteBatch* WriterFrontend::CurrentBatch(int arg_num_fields)
+	{
+	if ( arg_num_fields != num_fields )
 		{
-		broker_mgr->PublishLogWrite(stream, writer, info->path, num_fields, vals);
+		reporter->Warning("WriterFrontend %s expected %d fields in write, got %d. Skipping line.",
+		                  name, num_fields, arg_num_fields);
+		return nullptr;
 		}
 
-	if ( ! backend )
+	if ( ! write_batch )
+		write_batch = new WriteBatch(num_fields, WRITER_BUFFER_SIZE);
+
+	return write_batch;
+	}
+
+void WriterFrontend::WriteRow()
+	{
+	if ( disabled )
 		{
-		DeleteVals(arg_num_fields, vals);
+		DiscardRow();
 		return;
 		}
 
-	if ( ! write_buffer )
+	if ( remote )
 		{
-		// Need new buffer.
-		write_buffer = new Value**[WRITER_BUFFER_SIZE];
-		write_buffer_pos = 0;
+		auto vals = write_batch->Row(write_batch->NumRows() - 1);
+		broker_mgr->PublishLogWrite(stream, writer, info->path, num_fields, vals);
 		}
 
-	write_buffer[write_buffer_pos++] = vals;
+	if ( ! backend )
+		{
+		DiscardRow();
+		return;
+		}
 
-	if ( write_buffer_pos >= WRITER_BUFFER_SIZE || ! buf || run_state::terminating )
+	if ( write_batch->Full() || ! buf || run_state::terminating )
 		// Buffer full (or no buffering desired or terminating).
 		FlushWriteBuffer();
 	}
 
+void WriterFrontend::DiscardRow()
+	{
+	write_batch->PopRow();
+	}
+
 void WriterFrontend::FlushWriteBuffer()
 	{
-	if ( ! write_buffer_pos )
+	if ( ! write_batch || ! write_batch->NumRows() )
 		// Nothing to do.
 		return;
 
+	// Ownership of the batch passes to the child thread.
 	if ( backend )
-		backend->SendIn(new WriteMessage(backend, num_fields, write_buffer_pos, write_buffer));
+		backend->SendIn(new WriteMessage(backend, write_batch));
+	else
+		delete write_batch;
 
-	// Clear buffer (no delete, we pass ownership to child thread.)
-	write_buffer = nullptr;
-	write_buffer_pos = 0;
+	write_batch = nullptr;
 	}
 
 void WriterFrontend::SetBuf(bool enabled)
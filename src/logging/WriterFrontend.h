@@ -95,6 +95,37 @@ public:
 	 */
 	void Write(int num_fields, threading::Value** vals);
 
+	/**
+	 * Returns the batch that buffered writes currently go into. To write
+	 * a record without allocating its values individually, add it to the
+	 * batch with WriteBatch::AddRow(), fill in its values, and then call
+	 * either WriteRow() or DiscardRow(). There must not be any other
+	 * writes to the frontend in between.
+	 *
+	 * @param num_fields The number of fields of the record, for checking
+	 * against the fields passed to Init().
+	 *
+	 * @return The batch, or null if the number of fields doesn't match.
+	 *
+	 * This method must only be called from the main thread.
+	 */
+	WriteBatch* CurrentBatch(int num_fields);
+
+	/**
+	 * Writes out the record last added to CurrentBatch(), with the same
+	 * semantics as Write().
+	 *
+	 * This method must only be called from the main thread.
+	 */
+	void WriteRow();
+
+	/**
+	 * Removes the record last added to CurrentBatch() without writing it.
+	 *
+	 * This method must only be called from the main thread.
+	 */
+	void DiscardRow();
+
 	/**
 	 * Sets the buffering state.
 	 *
@@ -205,10 +236,9 @@ protected:
 	int num_fields; // The number of log fields.
 	const threading::Field* const* fields; // The log fields.
 
-	// Buffer for bulk writes.
+	// Batch for bulk writes.
 	static const int WRITER_BUFFER_SIZE = 1000;
-	int write_buffer_pos; // Position of next write in buffer.
-	threading::Value*** write_buffer; // Buffer of size WRITER_BUFFER_SIZE.
+	WriteBatch* write_batch; // Holds up to WRITER_BUFFER_SIZE records.
 	};
 
 	} // namespace zeek::logging
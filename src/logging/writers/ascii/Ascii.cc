@@ -226,7 +226,10 @@ Ascii::Ascii(WriterFrontend* frontend) : WriterBackend(frontend)
 	json_include_unset_fields = false;
 	formatter = nullptr;
 	gzip_level = 0;
-	gzfile = nullptr;
+	compression_level = 0;
+	compression_block_size = 0;
+	compression_threads = 0;
+	codec = nullptr;
 
 	InitConfigOptions();
 	init_options = InitFilterOptions();
@@ -264,6 +267,12 @@ void Ascii::InitConfigOptions()
 	gzip_file_extension.assign((const char*)BifConst::LogAscii::gzip_file_extension->Bytes(),
 	                           BifConst::LogAscii::gzip_file_extension->Len());
 
+	compression.assign((const char*)BifConst::LogAscii::compression->Bytes(),
+	                   BifConst::LogAscii::compression->Len());
+	compression_level = BifConst::LogAscii::compression_level;
+	compression_block_size = BifConst::LogAscii::compression_block_size;
+	compression_threads = BifConst::LogAscii::compression_threads;
+
 	// Remove in v6.1: LogAscii::logdir should be gone in favor
 	// of using Log::default_logdir.
 	logdir.assign((const char*)BifConst::LogAscii::logdir->Bytes(),
@@ -380,6 +389,12 @@ bool Ascii::InitFilterOptions()
 		else if ( strcmp(i->first, "gzip_file_extension") == 0 )
 			gzip_file_extension.assign(i->second);
 
+		else if ( strcmp(i->first, "compression") == 0 )
+			compression.assign(i->second);
+
+		else if ( strcmp(i->first, "compression_level") == 0 )
+			compression_level = atoi(i->second);
+
 		else if ( strcmp(i->first, "logdir") == 0 )
 			{
 			// This doesn't play nice with leftover log rotation
@@ -393,9 +408,69 @@ bool Ascii::InitFilterOptions()
 	if ( ! InitFormatter() )
 		return false;
 
+	if ( ! InitCompression() )
+		return false;
+
+	return true;
+	}
+
+bool Ascii::InitCompression()
+	{
+	codec = nullptr;
+
+	// Checked up front, as gzip_level goes through the block path too.
+	if ( compression_block_size == 0 || compression_block_size > (1 << 30) )
+		{
+		Error("invalid value for 'compression_block_size', must be between 1 and 2^30.");
+		return false;
+		}
+
+	if ( compression.empty() )
+		{
+		if ( gzip_level <= 0 )
+			return true;
+
+		if ( gzip_level > 9 )
+			{
+			Error("invalid value for 'gzip_level', must be a number between 0 and 9.");
+			return false;
+			}
+
+		// The traditional way of enabling gzip.
+		codec = logging::detail::Codec::Lookup("gzip");
+		compression_level = gzip_level;
+		return true;
+		}
+
+	codec = logging::detail::Codec::Lookup(compression);
+
+	if ( ! codec )
+		{
+		Error(Fmt("invalid value for 'compression': %s is unknown or not supported by this "
+		          "build of Zeek",
+		          compression.c_str()));
+		return false;
+		}
+
+	if ( compression_level < 0 || compression_level > codec->MaxLevel() )
+		{
+		Error(Fmt("invalid value for 'compression_level', must be a number between 0 and %d "
+		          "for %s.",
+		          codec->MaxLevel(), codec->Name()));
+		return false;
+		}
+
 	return true;
 	}
 
+string Ascii::CompressionExt() const
+	{
+	if ( codec == logging::detail::Codec::Lookup("gzip") && ! gzip_file_extension.empty() )
+		return gzip_file_extension;
+
+	return codec->Extension();
+	}
+
 bool Ascii::InitFormatter()
 	{
 	delete formatter;
@@ -466,7 +541,6 @@ void Ascii::CloseFile(double t)
 
 	InternalClose(fd);
 	fd = 0;
-	gzfile = nullptr;
 	}
 
 bool Ascii::DoInit(const WriterInfo& info, int num_fields, const threading::Field* const* fields)
@@ -487,10 +561,10 @@ bool Ascii::DoInit(const WriterInfo& info, int num_fields, const threading::Fiel
 		{
 		std::string ext = "." + LogExt();
 
-		if ( gzip_level > 0 )
+		if ( codec )
 			{
 			ext += ".";
-			ext += gzip_file_extension.empty() ? "gz" : gzip_file_extension;
+			ext += CompressionExt();
 			}
 
 		if ( fname.front() != '/' && ! logdir.empty() )
@@ -546,28 +620,13 @@ bool Ascii::DoInit(const WriterInfo& info, int num_fields, const threading::Fiel
 		return false;
 		}
 
-	if ( gzip_level > 0 )
-		{
-		if ( gzip_level < 0 || gzip_level > 9 )
-			{
-			Error("invalid value for 'gzip_level', must be a number between 0 and 9.");
-			return false;
-			}
-
-		char mode[4];
-		snprintf(mode, sizeof(mode), "wb%d", gzip_level);
-		errno = 0; // errno will only be set under certain circumstances by gzdopen.
-		gzfile = gzdopen(fd, mode);
-
-		if ( gzfile == nullptr )
-			{
-			Error(Fmt("cannot gzip %s: %s", fname.c_str(), Strerror(errno)));
-			return false;
-			}
-		}
-	else
+	if ( codec )
 		{
-		gzfile = nullptr;
+		auto pool = compression_threads > 0
+		                ? logging::detail::CompressionPool::Instance(compression_threads)
+		                : nullptr;
+		compressor = std::make_unique<logging::detail::BlockCompressor>(
+			codec, compression_level, compression_block_size, pool);
 		}
 
 	if ( ! WriteHeader(path) )
@@ -630,6 +689,14 @@ bool Ascii::WriteHeader(const string& path)
 
 bool Ascii::DoFlush(double network_time)
 	{
+	if ( compressor )
+		{
+		compressor->Flush();
+
+		if ( ! WriteCompressed(true) )
+			return false;
+		}
+
 	fsync(fd);
 	return true;
 	}
@@ -705,10 +772,10 @@ bool Ascii::DoRotate(const char* rotated_path, double open, double close, bool t
 
 	string nname = string(rotated_path) + "." + LogExt();
 
-	if ( gzip_level > 0 )
+	if ( codec )
 		{
 		nname += ".";
-		nname += gzip_file_extension.empty() ? "gz" : gzip_file_extension;
+		nname += CompressionExt();
 		}
 
 	if ( rename(fname.c_str(), nname.c_str()) != 0 )
@@ -752,7 +819,10 @@ bool Ascii::DoSetBuf(bool enabled)
 
 bool Ascii::DoHeartbeat(double network_time, double current_time)
 	{
-	// Nothing to do.
+	// Write out blocks that the compression threads have finished since.
+	if ( compressor )
+		return WriteCompressed(false);
+
 	return true;
 	}
 
@@ -926,58 +996,47 @@ string Ascii::Timestamp(double t)
 
 bool Ascii::InternalWrite(int fd, const char* data, int len)
 	{
-	if ( ! gzfile )
+	if ( ! compressor )
 		return util::safe_write(fd, data, len);
 
-	while ( len > 0 )
-		{
-		int n = gzwrite(gzfile, data, len);
+	compressor->Write(data, len);
+	return WriteCompressed(false);
+	}
 
-		if ( n <= 0 )
-			{
-			const char* err = gzerror(gzfile, &n);
-			Error(Fmt("Ascii::InternalWrite error: %s\n", err));
-			return false;
-			}
+bool Ascii::WriteCompressed(bool wait)
+	{
+	compressed.clear();
 
-		data += n;
-		len -= n;
+	if ( ! compressor->Drain(&compressed, wait) )
+		{
+		Error(Fmt("Ascii::WriteCompressed error: cannot compress %s", fname.c_str()));
+		return false;
 		}
 
-	return true;
+	return compressed.empty() || util::safe_write(fd, compressed.data(), compressed.size());
 	}
 
 bool Ascii::InternalClose(int fd)
 	{
-	if ( ! gzfile )
+	bool success = true;
+
+	if ( compressor )
 		{
-		util::safe_close(fd);
-		return true;
-		}
+		compressor->Flush();
+		success = WriteCompressed(true);
 
-	int res = gzclose(gzfile);
+		// For zstd and lz4, end the file with an index of its frames, so
+		// readers can seek to the part they need.
+		auto seek_table = compressor->SeekTable();
 
-	if ( res == Z_OK )
-		return true;
+		if ( success && ! seek_table.empty() )
+			success = util::safe_write(fd, seek_table.data(), seek_table.size());
 
-	switch ( res )
-		{
-		case Z_STREAM_ERROR:
-			Error("Ascii::InternalClose gzclose error: invalid file stream");
-			break;
-		case Z_BUF_ERROR:
-			Error("Ascii::InternalClose gzclose error: "
-			      "no compression progress possible during buffer flush");
-			break;
-		case Z_ERRNO:
-			Error(Fmt("Ascii::InternalClose gzclose error: %s\n", Strerror(errno)));
-			break;
-		default:
-			Error("Ascii::InternalClose invalid gzclose result");
-			break;
+		compressor.reset();
 		}
 
-	return false;
+	util::safe_close(fd);
+	return success;
 	}
 
 	} // namespace zeek::logging::writer::detail
@@ -4,9 +4,10 @@
 
 #pragma once
 
-#include <zlib.h>
+#include <memory>
 
 #include "zeek/Desc.h"
+#include "zeek/logging/Compression.h"
 #include "zeek/logging/WriterBackend.h"
 #include "zeek/threading/formatters/Ascii.h"
 #include "zeek/threading/formatters/JSON.h"
@@ -53,11 +54,15 @@ private:
 	void InitConfigOptions();
 	bool InitFilterOptions();
 	bool InitFormatter();
+	bool InitCompression();
+	std::string CompressionExt() const;
 	bool InternalWrite(int fd, const char* data, int len);
+	bool WriteCompressed(bool wait);
 	bool InternalClose(int fd);
 
 	int fd;
-	gzFile gzfile;
+	std::unique_ptr<logging::detail::BlockCompressor> compressor;
+	std::string compressed; // Output of the compressor, ready to write.
 	std::string fname;
 	ODesc desc;
 	bool ascii_done;
@@ -75,6 +80,11 @@ private:
 
 	int gzip_level; // level > 0 enables gzip compression
 	std::string gzip_file_extension;
+	std::string compression; // Codec name; empty for gzip if gzip_level > 0.
+	int compression_level;
+	size_t compression_block_size;
+	int compression_threads;
+	const logging::detail::Codec* codec; // Null if not compressing.
 	bool use_json;
 	bool enable_utf_8;
 	std::string json_timestamps;
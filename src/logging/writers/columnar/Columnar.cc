@@ -0,0 +1,220 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek/logging/writers/columnar/Columnar.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+
+#include "zeek/Val.h"
+#include "zeek/logging/WriteBatch.h"
+#include "zeek/logging/writers/columnar/columnar.bif.h"
+#include "zeek/util.h"
+
+using namespace std;
+using zeek::threading::Field;
+using zeek::threading::Value;
+using zeek::threading::formatter::ColumnarEncoder;
+using zeek::threading::formatter::ColumnarFormat;
+
+static constexpr auto columnar_ext = ".zcol";
+
+namespace zeek::logging::writer::detail
+	{
+
+Columnar::Columnar(WriterFrontend* frontend) : WriterBackend(frontend)
+	{
+	block_rows = BifConst::LogColumnar::block_rows;
+	compression_level = BifConst::LogColumnar::compression_level;
+	logdir = zeek::id::find_const<StringVal>("Log::default_logdir")->ToStdString();
+
+	if ( block_rows == 0 )
+		block_rows = 1;
+	}
+
+Columnar::~Columnar()
+	{
+	// In case of errors aborting the logging altogether, DoFinish() may
+	// not have been called. The buffered rows are lost then.
+	CloseFile();
+	}
+
+bool Columnar::DoInit(const WriterInfo& info, int num_fields, const Field* const* fields)
+	{
+	assert(! fd);
+
+	if ( compression_level > 9 )
+		{
+		Error("invalid value for 'LogColumnar::compression_level', must be a number between 0 "
+		      "and 9.");
+		return false;
+		}
+
+	for ( int i = 0; i < num_fields; ++i )
+		{
+		if ( ! ColumnarFormat::IsSupportedType(fields[i]->type, fields[i]->subtype) )
+			{
+			Error(Fmt("field %s has type %s, which the columnar format does not support",
+			          fields[i]->name, fields[i]->TypeName().c_str()));
+			return false;
+			}
+		}
+
+	fname = info.path;
+
+	if ( fname.front() != '/' && ! logdir.empty() )
+		fname = (zeek::filesystem::path(logdir) / fname).string();
+
+	fname += columnar_ext;
+
+	fd = open(fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+	if ( fd < 0 )
+		{
+		Error(Fmt("cannot open %s: %s", fname.c_str(), Strerror(errno)));
+		fd = 0;
+		return false;
+		}
+
+	encoder = std::make_unique<ColumnarEncoder>(num_fields, fields, compression_level);
+
+	std::vector<std::pair<std::string, std::string>> meta = {
+		{"path", info.path},
+		{"open", Fmt("%.6f", info.network_time)},
+	};
+
+	if ( ! InternalWrite(encoder->Header(meta)) )
+		return false;
+
+	return true;
+	}
+
+void Columnar::CloseFile()
+	{
+	if ( ! fd )
+		return;
+
+	util::safe_close(fd);
+	fd = 0;
+	encoder.reset();
+	}
+
+bool Columnar::InternalWrite(const string& data)
+	{
+	if ( util::safe_write(fd, data.data(), data.size()) )
+		return true;
+
+	Error(Fmt("error writing to %s: %s", fname.c_str(), Strerror(errno)));
+	return false;
+	}
+
+bool Columnar::WriteBlock()
+	{
+	if ( ! fd || ! encoder || encoder->NumRows() == 0 )
+		return true;
+
+	return InternalWrite(encoder->Flush());
+	}
+
+bool Columnar::Add(Value** vals)
+	{
+	if ( ! fd && ! DoInit(Info(), NumFields(), Fields()) )
+		return false;
+
+	encoder->Add(vals);
+
+	if ( encoder->NumRows() >= block_rows )
+		return WriteBlock();
+
+	return true;
+	}
+
+bool Columnar::DoWrite(int num_fields, const Field* const* fields, Value** vals)
+	{
+	if ( ! Add(vals) )
+		return false;
+
+	return IsBuf() || WriteBlock();
+	}
+
+bool Columnar::DoWriteBatch(int num_fields, const Field* const* fields, const WriteBatch& batch)
+	{
+	std::vector<const Value*> columns(num_fields);
+
+	for ( int j = 0; j < batch.NumRows(); )
+		{
+		if ( ! fd && ! DoInit(Info(), NumFields(), Fields()) )
+			return false;
+
+		// Hand the encoder as many rows as fit into its block, a column
+		// at a time.
+		size_t n = std::min(static_cast<size_t>(batch.NumRows() - j),
+		                    block_rows - encoder->NumRows());
+
+		for ( int i = 0; i < num_fields; ++i )
+			columns[i] = batch.Column(i) + j;
+
+		encoder->AddColumns(columns.data(), n);
+		j += n;
+
+		if ( encoder->NumRows() >= block_rows && ! WriteBlock() )
+			return false;
+		}
+
+	// Without buffering, write a (short) block per batch rather than per
+	// row, which the frontend already limits in size and age.
+	return IsBuf() || WriteBlock();
+	}
+
+bool Columnar::DoFlush(double network_time)
+	{
+	if ( ! WriteBlock() )
+		return false;
+
+	if ( fd )
+		fsync(fd);
+
+	return true;
+	}
+
+bool Columnar::DoFinish(double network_time)
+	{
+	bool success = WriteBlock();
+	CloseFile();
+	return success;
+	}
+
+bool Columnar::DoRotate(const char* rotated_path, double open, double close, bool terminating)
+	{
+	// Nothing to rotate if there's no file currently open.
+	if ( ! fd )
+		{
+		FinishedRotation();
+		return true;
+		}
+
+	bool success = WriteBlock();
+	CloseFile();
+
+	string nname = string(rotated_path) + columnar_ext;
+
+	if ( rename(fname.c_str(), nname.c_str()) != 0 )
+		{
+		Error(Fmt("failed to rename %s to %s: %s", fname.c_str(), nname.c_str(),
+		          Strerror(errno)));
+		FinishedRotation();
+		return false;
+		}
+
+	if ( ! FinishedRotation(nname.c_str(), fname.c_str(), open, close, terminating) )
+		{
+		Error(Fmt("error rotating %s to %s", fname.c_str(), nname.c_str()));
+		return false;
+		}
+
+	return success;
+	}
+
+	} // namespace zeek::logging::writer::detail
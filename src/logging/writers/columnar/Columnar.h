@@ -0,0 +1,52 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Log writer for Zeek's columnar binary format.
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "zeek/logging/WriterBackend.h"
+#include "zeek/threading/formatters/Columnar.h"
+
+namespace zeek::logging::writer::detail
+	{
+
+class Columnar : public WriterBackend
+	{
+public:
+	explicit Columnar(WriterFrontend* frontend);
+	~Columnar() override;
+
+	static WriterBackend* Instantiate(WriterFrontend* frontend) { return new Columnar(frontend); }
+
+protected:
+	bool DoInit(const WriterInfo& info, int num_fields,
+	            const threading::Field* const* fields) override;
+	bool DoWrite(int num_fields, const threading::Field* const* fields,
+	             threading::Value** vals) override;
+	bool DoWriteBatch(int num_fields, const threading::Field* const* fields,
+	                  const WriteBatch& batch) override;
+	bool DoSetBuf(bool enabled) override { return true; }
+	bool DoRotate(const char* rotated_path, double open, double close, bool terminating) override;
+	bool DoFlush(double network_time) override;
+	bool DoFinish(double network_time) override;
+	bool DoHeartbeat(double network_time, double current_time) override { return true; }
+
+private:
+	bool Add(threading::Value** vals);
+	bool WriteBlock();
+	bool InternalWrite(const std::string& data);
+	void CloseFile();
+
+	int fd = 0;
+	std::string fname;
+	std::string logdir;
+	size_t block_rows;
+	int compression_level;
+
+	std::unique_ptr<threading::formatter::ColumnarEncoder> encoder;
+	};
+
+	} // namespace zeek::logging::writer::detail
@@ -2,6 +2,7 @@
 
 #include "zeek/packet_analysis/Analyzer.h"
 
+#include "zeek/AnalyzerAccounting.h"
 #include "zeek/DebugLogger.h"
 #include "zeek/Event.h"
 #include "zeek/RunState.h"
@@ -62,6 +63,14 @@ const char* Analyzer::GetAnalyzerName() const
 	return packet_mgr->GetComponentName(tag).c_str();
 	}
 
+zeek::detail::AnalyzerCounters* Analyzer::Accounting()
+	{
+	if ( ! accounting && zeek::detail::AnalyzerAccounting::Enabled() )
+		accounting = zeek::detail::AnalyzerAccounting::Lookup("packet", GetAnalyzerName());
+
+	return accounting;
+	}
+
 bool Analyzer::IsAnalyzer(const char* name)
 	{
 	assert(tag);
@@ -117,6 +126,8 @@ bool Analyzer::ForwardPacket(size_t len, const uint8_t* data, Packet* packet,
 
 	DBG_LOG(DBG_PACKET_ANALYSIS, "Analysis in %s succeeded, next layer identifier is %#x.",
 	        GetAnalyzerName(), identifier);
+
+	zeek::detail::AnalyzerAccounting::Invocation accounted(inner_analyzer->Accounting(), len, true);
 	return inner_analyzer->AnalyzePacket(len, data, packet);
 	}
 
@@ -150,6 +161,7 @@ bool Analyzer::ForwardPacket(size_t len, const uint8_t* data, Packet* packet) co
 		return false;
 		}
 
+	zeek::detail::AnalyzerAccounting::Invocation accounted(inner_analyzer->Accounting(), len, true);
 	return inner_analyzer->AnalyzePacket(len, data, packet);
 	}
 
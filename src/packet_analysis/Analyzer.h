@@ -8,6 +8,11 @@
 #include "zeek/packet_analysis/Manager.h"
 #include "zeek/session/Session.h"
 
+namespace zeek::detail
+	{
+struct AnalyzerCounters;
+	}
+
 namespace zeek::packet_analysis
 	{
 
@@ -271,6 +276,10 @@ private:
 	void EnqueueAnalyzerViolation(session::Session* session, const char* reason, const char* data,
 	                              int len, const zeek::Tag& arg_tag);
 
+	// Returns the analyzer's accounting counters, or null if accounting
+	// is off.
+	zeek::detail::AnalyzerCounters* Accounting();
+
 	zeek::Tag tag;
 	Dispatcher dispatcher;
 	AnalyzerPtr default_analyzer = nullptr;
@@ -283,6 +292,8 @@ private:
 
 	std::set<AnalyzerPtr> analyzers_to_detect;
 
+	zeek::detail::AnalyzerCounters* accounting = nullptr;
+
 	void Init(const zeek::Tag& tag);
 	};
 
@@ -2,6 +2,7 @@
 
 #include "zeek/packet_analysis/Manager.h"
 
+#include "zeek/AnalyzerAccounting.h"
 #include "zeek/RunState.h"
 #include "zeek/Stats.h"
 #include "zeek/iosource/Manager.h"
@@ -115,6 +116,7 @@ void Manager::ProcessPacket(Packet* packet)
 #endif
 
 	zeek::detail::SegmentProfiler prof(detail::segment_logger, "dispatching-packet");
+	zeek::detail::AnalyzerAccounting::PacketScope accounting;
 	if ( pkt_profiler )
 		pkt_profiler->ProfilePkt(zeek::run_state::processing_start_time, packet->cap_len);
 
@@ -174,7 +174,7 @@ zeek::Connection* IPBasedAnalyzer::NewConn(const ConnTuple* id, const detail::Co
 	if ( flip )
 		conn->FlipRoles();
 
-	BuildSessionAnalyzerTree(conn);
+	BuildSessionAnalyzerTree(conn, session_mgr->ShedConnection(key));
 
 	if ( new_connection )
 		conn->Event(new_connection, nullptr);
@@ -182,17 +182,24 @@ zeek::Connection* IPBasedAnalyzer::NewConn(const ConnTuple* id, const detail::Co
 	return conn;
 	}
 
-void IPBasedAnalyzer::BuildSessionAnalyzerTree(Connection* conn)
+void IPBasedAnalyzer::BuildSessionAnalyzerTree(Connection* conn, bool transport_only)
 	{
 	SessionAdapter* root = MakeSessionAdapter(conn);
-	analyzer::pia::PIA* pia = MakePIA(conn);
 
-	bool scheduled = analyzer_mgr->ApplyScheduledAnalyzers(conn, false, root);
+	// When shedding load, the connection keeps its session adapter and the
+	// analyzers feeding its logging, but no application-layer analyzers.
+	if ( transport_only )
+		root->SetTransportOnly();
+
+	analyzer::pia::PIA* pia = transport_only ? nullptr : MakePIA(conn);
+
+	bool scheduled = ! transport_only &&
+	                 analyzer_mgr->ApplyScheduledAnalyzers(conn, false, root);
 
 	// Hmm... Do we want *just* the expected analyzer, or all
 	// other potential analyzers as well?  For now we only take
 	// the scheduled ones.
-	if ( ! scheduled )
+	if ( ! scheduled && ! transport_only )
 		{ // Let's see if it's a port we know.
 		if ( ! analyzers_by_port.empty() && ! zeek::detail::dpd_ignore_ports )
 			{
@@ -196,7 +196,7 @@ private:
 	 */
 	zeek::Connection* NewConn(const ConnTuple* id, const detail::ConnKey& key, const Packet* pkt);
 
-	void BuildSessionAnalyzerTree(Connection* conn);
+	void BuildSessionAnalyzerTree(Connection* conn, bool transport_only = false);
 
 	TransportProto transport;
 	uint32_t server_port_mask;
@@ -87,6 +87,18 @@ public:
 	 */
 	analyzer::pia::PIA* GetPIA() const { return pia; }
 
+	/**
+	 * Marks the session as tracked only at the transport layer, which
+	 * happens when Zeek sheds load. Adapters then skip setting up state
+	 * that only serves application-layer analysis.
+	 */
+	void SetTransportOnly() { transport_only = true; }
+
+	/**
+	 * Returns true if the session is tracked only at the transport layer.
+	 */
+	bool TransportOnly() const { return transport_only; }
+
 	/**
 	 * Helper to raise a \c packet_contents event.
 	 *
@@ -99,6 +111,7 @@ public:
 protected:
 	IPBasedAnalyzer* parent = nullptr;
 	analyzer::pia::PIA* pia = nullptr;
+	bool transport_only = false;
 	};
 
 	} // namespace zeek::packet_analysis::IP
@@ -1638,7 +1638,8 @@ void TCPSessionAdapter::AddExtraAnalyzers(Connection* conn)
 			reass = (bool)tcp_content_delivery_ports_resp->FindOrDefault(dport);
 		}
 
-	if ( reass )
+	// Nothing would consume the reassembled stream.
+	if ( reass && ! TransportOnly() )
 		EnableReassembly();
 
 	if ( analyzer_mgr->IsEnabled(analyzer_tcpstats) )
@@ -1163,7 +1163,12 @@ protected:
 	 * @param fields threading::Field description of the fields being logged.
 	 *
 	 * @param vals threading::Values containing the values being written. Values
-	 *             can be modified in the Hook.
+	 *             can be modified in the Hook. They live in the writer's
+	 *             current logging::WriteBatch, so never delete them. To
+	 *             modify one in place, allocate any new string data from
+	 *             that batch's arena. Alternatively, replace a value with
+	 *             one allocated with new, which the logging manager then
+	 *             moves into the batch and deletes.
 	 *
 	 * @return true if log line should be written, false if log line should be
 	 *         skipped and not passed on to the writer.
@@ -105,8 +105,13 @@ void CPPCompile::Compile(bool report_uncompilable)
 		if ( ! func.ShouldSkip() )
 			total_hash = merge_p_hashes(total_hash, func.Profile()->HashVal());
 
-	auto t = util::current_time();
-	total_hash = merge_p_hashes(total_hash, hash<double>{}(t));
+	// Incremental compilation needs the same body to always yield the
+	// same code, so that it can tell when regenerating it is unnecessary.
+	if ( ! analysis_options.gen_incremental_CPP )
+		{
+		auto t = util::current_time();
+		total_hash = merge_p_hashes(total_hash, hash<double>{}(t));
+		}
 
 	GenProlog();
 
@@ -0,0 +1,163 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek/script_opt/CPP/Incremental.h"
+
+#include <fstream>
+#include <unordered_set>
+
+#include "zeek/script_opt/CPP/Compile.h"
+#include "zeek/script_opt/ProfileFunc.h"
+
+extern const char* zeek_version();
+
+namespace zeek::detail
+	{
+
+using namespace std;
+
+// Records the version of Zeek that generated the files in the directory.
+static const char* version_file = "zeek-version";
+
+static const char* plugin_cmake = R"(# Generated by "zeek -O gen-incremental-C++".  Builds the compiled script
+# bodies in this directory into a Zeek plugin; configure and build it like
+# any other Zeek plugin.
+
+cmake_minimum_required(VERSION 3.15 FATAL_ERROR)
+
+project(ZeekPluginCPPBodies)
+
+include(ZeekPlugin)
+
+zeek_plugin_begin(Zeek CPP_Bodies)
+file(GLOB bodies RELATIVE "${CMAKE_CURRENT_SOURCE_DIR}" CONFIGURE_DEPENDS "CPP-*.cc")
+zeek_plugin_cc(Plugin.cc ${bodies})
+zeek_plugin_end()
+)";
+
+static const char* plugin_cc = R"(// Generated by "zeek -O gen-incremental-C++".
+
+#include "zeek/plugin/Plugin.h"
+
+namespace zeek::plugin::Zeek_CPP_Bodies
+	{
+
+class Plugin : public zeek::plugin::Plugin
+	{
+protected:
+	zeek::plugin::Configuration Configure() override
+		{
+		zeek::plugin::Configuration config;
+		config.name = "Zeek::CPP_Bodies";
+		config.description = "Script function bodies compiled to C++";
+		return config;
+		}
+	} plugin;
+
+	}
+)";
+
+static bool write_file(const string& path, const char* contents)
+	{
+	ofstream f(path);
+	f << contents;
+	return f.good();
+	}
+
+void generate_incremental_CPP(vector<FuncInfo>& funcs, const string& dir, bool report_uncompilable)
+	{
+	if ( ! util::detail::ensure_intermediate_dirs(dir.c_str()) )
+		reporter->FatalError("can't create C++ directory %s", dir.c_str());
+
+	// Code generated by a different version of Zeek might differ from
+	// what we'd generate now, so in that case we start afresh.
+	auto version_path = dir + "/" + version_file;
+	string prev_version;
+		{
+		ifstream f(version_path);
+		getline(f, prev_version);
+		}
+
+	bool same_version = prev_version == zeek_version();
+
+	unordered_set<string> body_files;
+	int num_generated = 0;
+
+	for ( auto& func : funcs )
+		{
+		if ( func.ShouldSkip() )
+			continue;
+
+		const char* reason;
+		if ( ! is_CPP_compilable(func.Profile(), &reason) )
+			{
+			if ( reason && report_uncompilable )
+				reporter->Warning("%s cannot be compiled to C++ due to %s", func.Func()->Name(),
+				                  reason);
+			continue;
+			}
+
+		auto hash = func.Profile()->HashVal();
+		auto file = "CPP-" + to_string(hash) + ".cc";
+
+		if ( ! body_files.insert(file).second )
+			// Identical to a body we've already done.
+			continue;
+
+		auto path = dir + "/" + file;
+		if ( same_version && filesystem::exists(path) )
+			continue;
+
+		// Profile the body on its own, so the generated code only
+		// includes the types and globals it needs.  We keep the hash
+		// computed in the context of all of the scripts, since that's
+		// what "-O use-C++" looks for.
+		vector<FuncInfo> body_funcs{func};
+		ProfileFuncs pfs(body_funcs, is_CPP_compilable, false);
+		body_funcs[0].ProfilePtr()->SetHashVal(hash);
+
+		// Generate into a temporary file so that an interrupted run
+		// can't leave behind a partial body that later runs would
+		// consider up to date.
+		auto tmp_path = path + ".tmp";
+			{
+			CPPCompile cpp(body_funcs, pfs, tmp_path, false, report_uncompilable);
+			}
+
+		std::error_code ec;
+		filesystem::rename(tmp_path, path, ec);
+		if ( ec )
+			reporter->FatalError("can't create %s: %s", path.c_str(), ec.message().c_str());
+
+		++num_generated;
+		}
+
+	int num_removed = 0;
+
+	for ( const auto& entry : filesystem::directory_iterator(dir) )
+		{
+		auto file = entry.path().filename().string();
+
+		if ( util::starts_with(file, "CPP-") && body_files.count(file) == 0 )
+			{
+			std::error_code ec;
+			if ( filesystem::remove(entry.path(), ec) )
+				++num_removed;
+			}
+		}
+
+	auto cmake_path = dir + "/CMakeLists.txt";
+	auto plugin_path = dir + "/Plugin.cc";
+
+	// Only write these when needed, to avoid needless reconfiguring.
+	if ( ! same_version || ! filesystem::exists(cmake_path) || ! filesystem::exists(plugin_path) )
+		{
+		if ( ! write_file(cmake_path, plugin_cmake) || ! write_file(plugin_path, plugin_cc) ||
+		     ! write_file(version_path, zeek_version()) )
+			reporter->FatalError("can't write C++ plugin scaffolding in %s", dir.c_str());
+		}
+
+	reporter->Info("%s: %zu C++ bodies, %d generated, %d removed", dir.c_str(), body_files.size(),
+	               num_generated, num_removed);
+	}
+
+	} // namespace zeek::detail
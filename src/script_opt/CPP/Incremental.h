@@ -0,0 +1,23 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+// Generation of C++ one function body at a time, for incremental rebuilds.
+
+#pragma once
+
+#include "zeek/script_opt/ScriptOpt.h"
+
+namespace zeek::detail
+	{
+
+// Generates C++ for each of the given function bodies into its own source
+// file in "dir", named by the body's hash, along with the scaffolding for
+// building the files into a Zeek plugin.  Files that already exist for a
+// body are left untouched, and those of bodies no longer present removed,
+// so that rebuilding the plugin only recompiles the bodies that changed.
+//
+// Each file is self-contained, so calls between compiled bodies go through
+// the regular function call path rather than being direct C++ calls.
+extern void generate_incremental_CPP(std::vector<FuncInfo>& funcs, const std::string& dir,
+                                     bool report_uncompilable);
+
+	} // namespace zeek::detail
@@ -3,6 +3,7 @@
 #include "zeek/script_opt/CPP/RuntimeVec.h"
 
 #include "zeek/Overflow.h"
+#include "zeek/VectorKernels.h"
 #include "zeek/ZeekString.h"
 
 namespace zeek::detail
@@ -44,6 +45,17 @@ static VectorTypePtr base_vector_type__CPP(const VectorTypePtr& vt)
 		}
 	}
 
+// Applies the typed kernel for a binary vector operation, if the operation
+// has one ("kernel" is nothing if not) and it applies to the operands.
+static VectorValPtr try_vec_kernel__CPP(std::optional<VecKernelOp> kernel, const VectorTypePtr& vt,
+                                        const VectorValPtr& v1, const VectorValPtr& v2)
+	{
+	if ( ! kernel || ! vt )
+		return nullptr;
+
+	return vec_kernel(*kernel, vt, v1.get(), v2.get());
+	}
+
 // The kernel used for unary vector operations.
 #define VEC_OP1_KERNEL(accessor, type, op)                                                         \
 	for ( unsigned int i = 0; i < v->Size(); ++i )                                                 \
@@ -121,14 +133,18 @@ VEC_OP1(comp, ~, )
 // Analogous to VEC_OP1, instantiates a function for a given binary operation,
 // which might-or-might-not be supported for low-level "double" types.
 // This version is for operations whose result type is the same as the
-// operand type.
-#define VEC_OP2(name, op, double_kernel, zero_check)                                               \
+// operand type.  "kernel" is the operation's typed kernel (see
+// VectorKernels.h), which we try first, or std::nullopt if there's none.
+#define VEC_OP2(name, op, double_kernel, zero_check, kernel)                                       \
 	VectorValPtr vec_op_##name##__CPP(const VectorValPtr& v1, const VectorValPtr& v2)              \
 		{                                                                                          \
 		if ( ! check_vec_sizes__CPP(v1, v2) )                                                      \
 			return nullptr;                                                                        \
                                                                                                    \
 		auto vt = base_vector_type__CPP(v1->GetType<VectorType>());                                \
+		if ( auto k_result = try_vec_kernel__CPP(kernel, vt, v1, v2) )                             \
+			return k_result;                                                                       \
+                                                                                                   \
 		auto v_result = make_intrusive<VectorVal>(vt);                                             \
                                                                                                    \
 		switch ( vt->Yield()->InternalType() )                                                     \
@@ -157,32 +173,32 @@ VEC_OP1(comp, ~, )
 		}
 
 // Instantiates a double_kernel for a binary operation.
-#define VEC_OP2_WITH_DOUBLE(name, op, zero_check)                                                  \
+#define VEC_OP2_WITH_DOUBLE(name, op, zero_check, kernel)                                          \
 	VEC_OP2(                                                                                       \
 		name, op, case TYPE_INTERNAL_DOUBLE                                                        \
 		: {                                                                                        \
 			VEC_OP2_KERNEL(AsDouble, DoubleVal, op, zero_check)                                    \
 			break;                                                                                 \
 		},                                                                                         \
-		zero_check)
+		zero_check, kernel)
 
 // The binary operations supported for vectors.
-VEC_OP2_WITH_DOUBLE(add, +, 0)
-VEC_OP2_WITH_DOUBLE(sub, -, 0)
-VEC_OP2_WITH_DOUBLE(mul, *, 0)
-VEC_OP2_WITH_DOUBLE(div, /, 1)
-VEC_OP2(mod, %, , 1)
-VEC_OP2(and, &, , 0)
-VEC_OP2(or, |, , 0)
-VEC_OP2(xor, ^, , 0)
-VEC_OP2(andand, &&, , 0)
-VEC_OP2(oror, ||, , 0)
-VEC_OP2(lshift, <<, , 0)
-VEC_OP2(rshift, >>, , 0)
+VEC_OP2_WITH_DOUBLE(add, +, 0, VK_ADD)
+VEC_OP2_WITH_DOUBLE(sub, -, 0, VK_SUB)
+VEC_OP2_WITH_DOUBLE(mul, *, 0, VK_TIMES)
+VEC_OP2_WITH_DOUBLE(div, /, 1, std::nullopt)
+VEC_OP2(mod, %, , 1, std::nullopt)
+VEC_OP2(and, &, , 0, std::nullopt)
+VEC_OP2(or, |, , 0, std::nullopt)
+VEC_OP2(xor, ^, , 0, std::nullopt)
+VEC_OP2(andand, &&, , 0, std::nullopt)
+VEC_OP2(oror, ||, , 0, std::nullopt)
+VEC_OP2(lshift, <<, , 0, std::nullopt)
+VEC_OP2(rshift, >>, , 0, std::nullopt)
 
 // A version of VEC_OP2 that instead supports relational operations, so
 // the result type is always vector-of-bool.
-#define VEC_REL_OP(name, op)                                                                       \
+#define VEC_REL_OP(name, op, kernel)                                                               \
 	VectorValPtr vec_op_##name##__CPP(const VectorValPtr& v1, const VectorValPtr& v2)              \
 		{                                                                                          \
 		if ( ! check_vec_sizes__CPP(v1, v2) )                                                      \
@@ -190,6 +206,9 @@ VEC_OP2(rshift, >>, , 0)
                                                                                                    \
 		auto vt = v1->GetType<VectorType>();                                                       \
 		auto res_type = make_intrusive<VectorType>(base_type(TYPE_BOOL));                          \
+		if ( auto k_result = try_vec_kernel__CPP(kernel, res_type, v1, v2) )                       \
+			return k_result;                                                                       \
+                                                                                                   \
 		auto v_result = make_intrusive<VectorVal>(res_type);                                       \
                                                                                                    \
 		switch ( vt->Yield()->InternalType() )                                                     \
@@ -220,12 +239,12 @@ VEC_OP2(rshift, >>, , 0)
 		}
 
 // The relational operations supported for vectors.
-VEC_REL_OP(lt, <)
-VEC_REL_OP(gt, >)
-VEC_REL_OP(eq, ==)
-VEC_REL_OP(ne, !=)
-VEC_REL_OP(le, <=)
-VEC_REL_OP(ge, >=)
+VEC_REL_OP(lt, <, VK_LT)
+VEC_REL_OP(gt, >, VK_GT)
+VEC_REL_OP(eq, ==, VK_EQ)
+VEC_REL_OP(ne, !=, VK_NE)
+VEC_REL_OP(le, <=, VK_LE)
+VEC_REL_OP(ge, >=, VK_GE)
 
 VectorValPtr vec_op_add__CPP(VectorValPtr v, int incr)
 	{
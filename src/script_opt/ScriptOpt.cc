@@ -2,6 +2,15 @@
 
 #include "zeek/script_opt/ScriptOpt.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <fstream>
+
 #include "zeek/Desc.h"
 #include "zeek/EventHandler.h"
 #include "zeek/EventRegistry.h"
@@ -10,12 +19,14 @@
 #include "zeek/module_util.h"
 #include "zeek/script_opt/CPP/Compile.h"
 #include "zeek/script_opt/CPP/Func.h"
+#include "zeek/script_opt/CPP/Incremental.h"
 #include "zeek/script_opt/GenIDDefs.h"
 #include "zeek/script_opt/Inline.h"
 #include "zeek/script_opt/ProfileFunc.h"
 #include "zeek/script_opt/Reduce.h"
 #include "zeek/script_opt/UsageAnalyzer.h"
 #include "zeek/script_opt/UseDefs.h"
+#include "zeek/script_opt/ZAM/BodyCache.h"
 #include "zeek/script_opt/ZAM/Compile.h"
 
 namespace zeek::detail
@@ -143,7 +154,7 @@ static bool optimize_AST(ScriptFunc* f, std::shared_ptr<ProfileFunc>& pf,
 	}
 
 static void optimize_func(ScriptFunc* f, std::shared_ptr<ProfileFunc> pf, ScopePtr scope,
-                          StmtPtr& body)
+                          StmtPtr& body, ProfileFuncs* pfs)
 	{
 	if ( reporter->Errors() > 0 )
 		return;
@@ -163,6 +174,24 @@ static void optimize_func(ScriptFunc* f, std::shared_ptr<ProfileFunc> pf, ScopeP
 		return;
 		}
 
+	std::unique_ptr<ZAMBodyCache> cache;
+
+	if ( analysis_options.gen_ZAM_code && ! analysis_options.ZAM_cache_dir.empty() &&
+	     ! analysis_options.dump_xform && ! analysis_options.dump_uds )
+		{
+		cache = std::make_unique<ZAMBodyCache>(f, body, pfs);
+
+		if ( auto zb = cache->Load() )
+			{
+			if ( analysis_options.dump_ZAM )
+				zb->Dump();
+
+			f->ReplaceBody(body, zb);
+			body = zb;
+			return;
+			}
+		}
+
 	push_existing_scope(scope);
 
 	auto rc = std::make_shared<Reducer>();
@@ -239,6 +268,9 @@ static void optimize_func(ScriptFunc* f, std::shared_ptr<ProfileFunc> pf, ScopeP
 		if ( analysis_options.dump_ZAM )
 			ZAM->Dump();
 
+		if ( cache )
+			cache->Save(static_cast<ZBody*>(new_body.get()));
+
 		f->ReplaceBody(body, new_body);
 		body = new_body;
 		}
@@ -246,6 +278,130 @@ static void optimize_func(ScriptFunc* f, std::shared_ptr<ProfileFunc> pf, ScopeP
 	pop_scope();
 	}
 
+// Compiles the given functions using multiple processes, as set by
+// analysis_options.ZAM_jobs.  Each process claims functions one at a time
+// and saves the compiled bodies to the ZAM body cache, from which the
+// subsequent sequential pass loads them.  Thus the end result is the same
+// as compiling sequentially, including for any bodies that can't be cached
+// and so get compiled by that pass.
+//
+// Returns the path of the temporary cache directory used if the user
+// hasn't specified one, which the caller needs to remove once done.
+static bool can_optimize_in_parallel()
+	{
+	// The dumps differ between compiled and loaded bodies, so when
+	// dumping we stick with compiling sequentially.
+	return analysis_options.ZAM_jobs > 1 && analysis_options.gen_ZAM_code &&
+	       ! analysis_options.dump_ZAM && ! analysis_options.dump_xform &&
+	       ! analysis_options.dump_uds;
+	}
+
+static std::string optimize_funcs_in_parallel(const std::vector<FuncInfo*>& to_optimize,
+                                              ProfileFuncs* pfs)
+	{
+	int num_funcs = to_optimize.size();
+	int jobs = std::min(analysis_options.ZAM_jobs, num_funcs);
+
+	if ( jobs <= 1 || ! can_optimize_in_parallel() )
+		return "";
+
+	// A child forked from a multi-threaded process may find locks held
+	// by other threads, such as malloc's, that never get released.
+	if ( analysis_options.threads_started )
+		return "";
+
+	std::string temp_cache_dir;
+
+	if ( analysis_options.ZAM_cache_dir.empty() )
+		{
+		auto tmp = getenv("TMPDIR");
+		std::string tmpl = util::fmt("%s/zeek-zam-XXXXXX", tmp ? tmp : "/tmp");
+
+		if ( ! mkdtemp(tmpl.data()) )
+			{
+			reporter->Warning("cannot create directory for parallel ZAM compilation: %s",
+			                  strerror(errno));
+			return "";
+			}
+
+		temp_cache_dir = analysis_options.ZAM_cache_dir = tmpl;
+		}
+
+	// The index of the next function to compile, shared across the
+	// processes.
+	auto next = static_cast<std::atomic<int>*>(mmap(nullptr, sizeof(std::atomic<int>),
+	                                                PROT_READ | PROT_WRITE,
+	                                                MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+	if ( next == MAP_FAILED )
+		{
+		reporter->Warning("cannot set up parallel ZAM compilation: %s", strerror(errno));
+		return temp_cache_dir;
+		}
+
+	new (next) std::atomic<int>(0);
+
+	// Don't let the children inherit pending output.
+	fflush(stdout);
+	fflush(stderr);
+
+	std::vector<pid_t> children;
+
+	for ( int i = 0; i < jobs; ++i )
+		{
+		auto pid = fork();
+
+		if ( pid < 0 )
+			{
+			reporter->Warning("cannot fork for parallel ZAM compilation: %s", strerror(errno));
+			break;
+			}
+
+		if ( pid == 0 )
+			{
+			// The sequential pass produces any output, including
+			// error messages, for the functions compiled here.
+			auto null_fd = open("/dev/null", O_WRONLY);
+			if ( null_fd >= 0 )
+				{
+				dup2(null_fd, STDOUT_FILENO);
+				dup2(null_fd, STDERR_FILENO);
+				}
+
+			for ( int n; (n = next->fetch_add(1)) < num_funcs; )
+				{
+				auto f = to_optimize[n];
+				auto body = f->Body();
+				optimize_func(f->Func(), f->ProfilePtr(), f->Scope(), body, pfs);
+				}
+
+			_exit(0);
+			}
+
+		children.push_back(pid);
+		}
+
+	for ( auto pid : children )
+		while ( waitpid(pid, nullptr, 0) < 0 && errno == EINTR )
+			;
+
+	munmap(next, sizeof(std::atomic<int>));
+
+	return temp_cache_dir;
+	}
+
+static void init_options();
+
+bool parallel_analysis_requested()
+	{
+	auto zam_jobs = getenv("ZEEK_ZAM_JOBS");
+	if ( ! zam_jobs || atoi(zam_jobs) <= 1 )
+		return false;
+
+	// Whether we generate ZAM may also depend on the environment.
+	init_options();
+	return can_optimize_in_parallel();
+	}
+
 static void check_env_opt(const char* opt, bool& opt_flag)
 	{
 	if ( getenv(opt) )
@@ -254,10 +410,35 @@ static void check_env_opt(const char* opt, bool& opt_flag)
 
 static void init_options()
 	{
+	// parallel_analysis_requested() may have been here already.
+	static bool did_init = false;
+
+	if ( did_init )
+		return;
+
+	did_init = true;
+
 	auto cppd = getenv("ZEEK_CPP_DIR");
 	if ( cppd )
 		CPP_dir = std::string(cppd) + "/";
 
+	auto zam_cache_dir = getenv("ZEEK_ZAM_CACHE");
+	if ( zam_cache_dir )
+		{
+		if ( util::detail::ensure_intermediate_dirs(zam_cache_dir) )
+			analysis_options.ZAM_cache_dir = zam_cache_dir;
+		else
+			reporter->Warning("cannot create ZAM cache directory %s", zam_cache_dir);
+		}
+
+	auto zam_jobs = getenv("ZEEK_ZAM_JOBS");
+	if ( zam_jobs )
+		{
+		analysis_options.ZAM_jobs = atoi(zam_jobs);
+		if ( analysis_options.ZAM_jobs < 1 )
+			reporter->FatalError("bad ZEEK_ZAM_JOBS value: %s", zam_jobs);
+		}
+
 	// ZAM-related options.
 	check_env_opt("ZEEK_DUMP_XFORM", analysis_options.dump_xform);
 	check_env_opt("ZEEK_DUMP_UDS", analysis_options.dump_uds);
@@ -274,12 +455,28 @@ static void init_options()
 	// Compile-to-C++-related options.
 	check_env_opt("ZEEK_GEN_CPP", analysis_options.gen_CPP);
 	check_env_opt("ZEEK_GEN_STANDALONE_CPP", analysis_options.gen_standalone_CPP);
+	check_env_opt("ZEEK_GEN_INCREMENTAL_CPP", analysis_options.gen_incremental_CPP);
 	check_env_opt("ZEEK_COMPILE_ALL", analysis_options.compile_all);
 	check_env_opt("ZEEK_REPORT_CPP", analysis_options.report_CPP);
 	check_env_opt("ZEEK_USE_CPP", analysis_options.use_CPP);
 	check_env_opt("ZEEK_ALLOW_COND", analysis_options.allow_cond);
 
-	if ( analysis_options.gen_standalone_CPP )
+	auto cpp_profile = getenv("ZEEK_CPP_PROFILE");
+	if ( cpp_profile )
+		analysis_options.CPP_profile = cpp_profile;
+
+	auto cpp_hot = getenv("ZEEK_CPP_HOT");
+	if ( cpp_hot )
+		{
+		analysis_options.CPP_hot_bodies = atoi(cpp_hot);
+		if ( analysis_options.CPP_hot_bodies < 1 )
+			reporter->FatalError("bad ZEEK_CPP_HOT value: %s", cpp_hot);
+		}
+
+	if ( analysis_options.gen_incremental_CPP && analysis_options.gen_standalone_CPP )
+		reporter->FatalError("incremental C++ generation incompatible with standalone C++");
+
+	if ( analysis_options.gen_standalone_CPP || analysis_options.gen_incremental_CPP )
 		analysis_options.gen_CPP = true;
 
 	if ( analysis_options.gen_CPP )
@@ -288,6 +485,9 @@ static void init_options()
 	if ( analysis_options.use_CPP && generating_CPP )
 		reporter->FatalError("generating C++ incompatible with using C++");
 
+	if ( ! analysis_options.CPP_profile.empty() && ! generating_CPP )
+		reporter->FatalError("ZEEK_CPP_PROFILE only relevant when generating C++");
+
 	if ( analysis_options.allow_cond && ! analysis_options.gen_standalone_CPP )
 		reporter->FatalError(
 			"\"-O allow-cond\" only relevant when also using \"-O gen-standalone-C++\"");
@@ -421,13 +621,83 @@ static void use_CPP()
 		reporter->FatalError("no C++ functions found to use");
 	}
 
-static void generate_CPP(std::unique_ptr<ProfileFuncs>& pfs)
+// Marks all but the hottest function bodies in the script profile as
+// to-skip.  A body's heat is the CPU time spent in it, excluding the
+// time spent in the functions it calls.
+static void select_hot_CPP_bodies()
 	{
-	const auto gen_name = CPP_dir + "CPP-gen.cc";
+	const auto& fn = analysis_options.CPP_profile;
+	std::ifstream profile(fn);
+	if ( ! profile )
+		reporter->FatalError("can't open script profile %s", fn.c_str());
+
+	// Maps a body's function name and location, as they appear in
+	// the profile, to its CPU time.
+	std::unordered_map<std::string, double> body_times;
+
+	std::string line;
+	while ( std::getline(profile, line) )
+		{
+		if ( line.empty() || line[0] == '#' )
+			continue;
+
+		// Fields: function, location, type, calls, total CPU, child CPU.
+		auto fields = util::tokenize_string(line, '\t');
+		if ( fields.size() < 6 || fields[2] == "BiF" || fields[2] == "TOTAL" )
+			continue;
+
+		auto key = std::string(fields[0]) + "\t" + std::string(fields[1]);
+		auto cpu = atof(std::string(fields[4]).c_str()) - atof(std::string(fields[5]).c_str());
+		body_times[key] = cpu;
+		}
+
+	std::vector<std::pair<double, FuncInfo*>> hot;
 
+	for ( auto& f : funcs )
+		{
+		if ( f.ShouldSkip() )
+			continue;
+
+		auto loc = f.Body()->GetLocationInfo();
+		auto key = std::string(f.Func()->Name()) + "\t" + loc->filename + ":" +
+		           std::to_string(loc->first_line);
+
+		auto bt = body_times.find(key);
+		if ( bt != body_times.end() && bt->second > 0.0 )
+			hot.emplace_back(bt->second, &f);
+
+		f.SetSkip(true);
+		}
+
+	if ( hot.empty() )
+		reporter->FatalError("no function bodies in %s match the loaded scripts", fn.c_str());
+
+	std::sort(hot.begin(), hot.end(),
+	          [](const auto& a, const auto& b) { return a.first > b.first; });
+
+	if ( hot.size() > static_cast<size_t>(analysis_options.CPP_hot_bodies) )
+		hot.resize(analysis_options.CPP_hot_bodies);
+
+	for ( auto& h : hot )
+		h.second->SetSkip(false);
+	}
+
+static void generate_CPP(std::unique_ptr<ProfileFuncs>& pfs)
+	{
 	const bool standalone = analysis_options.gen_standalone_CPP;
 	const bool report = analysis_options.report_uncompilable;
 
+	if ( ! analysis_options.CPP_profile.empty() )
+		select_hot_CPP_bodies();
+
+	if ( analysis_options.gen_incremental_CPP )
+		{
+		generate_incremental_CPP(funcs, CPP_dir + "CPP-bodies", report);
+		return;
+		}
+
+	const auto gen_name = CPP_dir + "CPP-gen.cc";
+
 	CPPCompile cpp(funcs, *pfs, gen_name, standalone, report);
 	}
 
@@ -490,7 +760,7 @@ static void analyze_scripts_for_ZAM(std::unique_ptr<ProfileFuncs>& pfs)
 			}
 		}
 
-	bool did_one = false;
+	std::vector<FuncInfo*> to_optimize;
 
 	for ( auto& f : funcs )
 		{
@@ -507,15 +777,28 @@ static void analyze_scripts_for_ZAM(std::unique_ptr<ProfileFuncs>& pfs)
 			// No need to compile as it won't be called directly.
 			continue;
 
-		auto new_body = f.Body();
-		optimize_func(func, f.ProfilePtr(), f.Scope(), new_body);
-		f.SetBody(new_body);
-		did_one = true;
+		to_optimize.push_back(&f);
 		}
 
-	if ( ! did_one )
+	if ( to_optimize.empty() )
 		reporter->FatalError("no matching functions/files for -O ZAM");
 
+	auto temp_cache_dir = optimize_funcs_in_parallel(to_optimize, pfs.get());
+
+	for ( auto f : to_optimize )
+		{
+		auto new_body = f->Body();
+		optimize_func(f->Func(), f->ProfilePtr(), f->Scope(), new_body, pfs.get());
+		f->SetBody(new_body);
+		}
+
+	if ( ! temp_cache_dir.empty() )
+		{
+		std::error_code ec;
+		filesystem::remove_all(temp_cache_dir, ec);
+		analysis_options.ZAM_cache_dir.clear();
+		}
+
 	finalize_functions(funcs);
 	}
 
@@ -72,6 +72,22 @@ struct AnalyOpt
 	// Produce a profile of ZAM execution.
 	bool profile_ZAM = false;
 
+	// If non-empty, a directory in which to save compiled ZAM bodies,
+	// and from which later invocations load them rather than compiling
+	// anew.
+	std::string ZAM_cache_dir;
+
+	// Number of processes to use for compiling function bodies.  When
+	// greater than one, requires the ability to cache compiled bodies
+	// (see ZAM_cache_dir), though a temporary cache gets used if none
+	// is specified.
+	int ZAM_jobs = 1;
+
+	// Set once Zeek has started threads (Broker's, for example).  From
+	// then on, forking for parallel compilation isn't safe anymore, so
+	// it falls back to compiling sequentially.
+	bool threads_started = false;
+
 	// If true, dump out transformed code: the results of reducing
 	// interpreted scripts, and, if optimize is set, of then optimizing
 	// them.
@@ -102,6 +118,21 @@ struct AnalyOpt
 	// of the corresponding script, and not activated by default).
 	bool gen_standalone_CPP = false;
 
+	// If true, generate the C++ for each function body into its own
+	// source file, named by the body's hash, so that after a change to
+	// the scripts only the bodies that changed need recompiling.  The
+	// files are built into a plugin rather than into Zeek itself.
+	bool gen_incremental_CPP = false;
+
+	// If non-empty, a script profile as written by --profile-scripts.
+	// When generating C++, only the hottest function bodies in the
+	// profile are compiled.
+	std::string CPP_profile;
+
+	// How many of the hottest function bodies to compile when using
+	// a profile.
+	int CPP_hot_bodies = 25;
+
 	// If true, use C++ bodies if available.
 	bool use_CPP = false;
 
@@ -187,6 +218,10 @@ extern bool should_analyze(const ScriptFuncPtr& f, const StmtPtr& body);
 // suppressed by the flag) and optimization.
 extern void analyze_scripts(bool no_unused_warnings);
 
+// True if ZAM function bodies will get compiled in parallel, as the user
+// asked for, which requires analyzing the scripts before any threads start.
+extern bool parallel_analysis_requested();
+
 // Called when Zeek is terminating.
 extern void finish_script_execution();
 
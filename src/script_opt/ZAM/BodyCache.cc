@@ -0,0 +1,1079 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek/script_opt/ZAM/BodyCache.h"
+
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <unordered_set>
+
+#include "zeek/Desc.h"
+#include "zeek/EventRegistry.h"
+#include "zeek/IPAddr.h"
+#include "zeek/RE.h"
+#include "zeek/digest.h"
+#include "zeek/script_opt/ProfileFunc.h"
+#include "zeek/script_opt/ScriptOpt.h"
+
+extern "C" const char zeek_build_info[];
+
+namespace zeek
+	{
+
+extern const char* zeek_version();
+
+namespace detail
+	{
+
+// Defined in AM-Opt.cc.
+extern std::unordered_map<const Func*, int> remapped_intrp_frame_sizes;
+
+// Identifies the file format, so we can change it without having
+// to worry about stale files from earlier versions.
+static const char* CACHE_MAGIC = "ZAM body cache v1";
+
+// Codes for the different forms of types we can save.
+enum CacheTypeCode
+	{
+	CTC_NIL,
+	CTC_BASE,
+	CTC_NAMED,
+	CTC_VECTOR,
+	CTC_SET,
+	CTC_TABLE,
+	CTC_LIST,
+	CTC_OPAQUE,
+	CTC_FILE,
+	CTC_TYPE,
+	};
+
+// Returns a persistent copy of the given string, for the members of
+// loaded bodies that are C strings.
+static const char* intern_string(std::string s)
+	{
+	static std::unordered_set<std::string> strings;
+	return strings.insert(std::move(s)).first->c_str();
+	}
+
+// Returns the global function of the given name, if it's unambiguous.
+static const IDPtr& find_global_func(const char* name)
+	{
+	const auto& id = id::find(name);
+
+	if ( id && id->GetType()->Tag() == TYPE_FUNC && id->GetVal() )
+		return id;
+
+	return ID::nil;
+	}
+
+// Serializes the elements of a compiled body.  The methods that take
+// script-level elements return false if the element can't be identified
+// in a later invocation.
+class ZAMCacheWriter
+	{
+public:
+	void Int(int64_t i) { buf.append(reinterpret_cast<const char*>(&i), sizeof i); }
+	void Double(double d) { buf.append(reinterpret_cast<const char*>(&d), sizeof d); }
+
+	void Str(std::string_view s)
+		{
+		Int(s.size());
+		buf.append(s);
+		}
+
+	// Strings that might be absent.
+	void OptStr(const char* s)
+		{
+		Int(s != nullptr);
+		if ( s )
+			Str(s);
+		}
+
+	template <typename T> void IntVec(const std::vector<T>& v)
+		{
+		Int(v.size());
+		for ( auto i : v )
+			Int(i);
+		}
+
+	bool Type(const Type* t);
+	bool Type(const TypePtr& t) { return Type(t.get()); }
+
+	bool Val(const ValPtr& v);
+
+	const std::string& Buffer() const { return buf; }
+
+private:
+	std::string buf;
+	};
+
+bool ZAMCacheWriter::Type(const zeek::Type* t)
+	{
+	if ( ! t )
+		{
+		Int(CTC_NIL);
+		return true;
+		}
+
+	const auto& name = t->GetName();
+	if ( ! name.empty() )
+		{
+		const auto& id = id::find(name);
+		if ( id && id->IsType() && id->GetType().get() == t )
+			{
+			Int(CTC_NAMED);
+			Str(name);
+			return true;
+			}
+		}
+
+	auto tag = t->Tag();
+
+	if ( base_type(tag).get() == t )
+		{
+		Int(CTC_BASE);
+		Int(tag);
+		return true;
+		}
+
+	switch ( tag )
+		{
+		case TYPE_VECTOR:
+			Int(CTC_VECTOR);
+			return Type(t->Yield());
+
+		case TYPE_TABLE:
+			{
+			auto tt = t->AsTableType();
+			if ( tt->IsSet() )
+				{
+				Int(CTC_SET);
+				return Type(tt->GetIndices());
+				}
+
+			Int(CTC_TABLE);
+			return Type(tt->GetIndices()) && Type(tt->Yield());
+			}
+
+		case TYPE_LIST:
+			{
+			auto tl = t->AsTypeList();
+			Int(CTC_LIST);
+
+			if ( ! Type(tl->GetPureType()) )
+				return false;
+
+			const auto& types = tl->GetTypes();
+			Int(types.size());
+			for ( const auto& lt : types )
+				if ( ! Type(lt) )
+					return false;
+
+			return true;
+			}
+
+		case TYPE_OPAQUE:
+			Int(CTC_OPAQUE);
+			Str(t->AsOpaqueType()->Name());
+			return true;
+
+		case TYPE_FILE:
+			Int(CTC_FILE);
+			return Type(t->Yield());
+
+		case TYPE_TYPE:
+			Int(CTC_TYPE);
+			return Type(t->AsTypeType()->GetType());
+
+		default:
+			// Anonymous records, enums and functions.
+			return false;
+		}
+	}
+
+bool ZAMCacheWriter::Val(const ValPtr& v)
+	{
+	Int(v != nullptr);
+
+	if ( ! v )
+		return true;
+
+	const auto& t = v->GetType();
+	if ( ! Type(t) )
+		return false;
+
+	switch ( t->Tag() )
+		{
+		case TYPE_BOOL:
+		case TYPE_INT:
+		case TYPE_ENUM:
+			Int(v->AsInt());
+			return true;
+
+		case TYPE_COUNT:
+		case TYPE_PORT:
+			Int(static_cast<int64_t>(v->AsCount()));
+			return true;
+
+		case TYPE_DOUBLE:
+		case TYPE_TIME:
+		case TYPE_INTERVAL:
+			Double(v->AsDouble());
+			return true;
+
+		case TYPE_STRING:
+			{
+			auto s = v->AsString();
+			Str({reinterpret_cast<const char*>(s->Bytes()), static_cast<size_t>(s->Len())});
+			return true;
+			}
+
+		case TYPE_ADDR:
+			Str(v->AsAddr().AsString());
+			return true;
+
+		case TYPE_SUBNET:
+			Str(v->AsSubNet().Prefix().AsString());
+			Int(v->AsSubNet().Length());
+			return true;
+
+		case TYPE_PATTERN:
+			Str(v->AsPattern()->PatternText());
+			Str(v->AsPattern()->AnywherePatternText());
+			return true;
+
+		case TYPE_FUNC:
+			{
+			auto f = v->AsFunc();
+			const auto& id = find_global_func(f->Name());
+			if ( ! id || id->GetVal()->AsFunc() != f )
+				return false;
+
+			Str(f->Name());
+			return true;
+			}
+
+		default:
+			return false;
+		}
+	}
+
+// The counterpart to ZAMCacheWriter.  Rather than checking for errors
+// after each step, users check Ok() once they're done with a group of
+// elements.
+class ZAMCacheReader
+	{
+public:
+	ZAMCacheReader(std::string _buf) : buf(std::move(_buf)) { }
+
+	bool Ok() const { return ok; }
+	bool AtEnd() const { return pos == buf.size(); }
+
+	int64_t Int()
+		{
+		int64_t i = 0;
+		Get(&i, sizeof i);
+		return i;
+		}
+
+	double Double()
+		{
+		double d = 0.0;
+		Get(&d, sizeof d);
+		return d;
+		}
+
+	// An element count, which we sanity-check so that corrupted
+	// files can't lead to huge allocations.
+	int Count()
+		{
+		auto n = Int();
+		if ( n < 0 || n > static_cast<int64_t>(buf.size()) )
+			{
+			ok = false;
+			return 0;
+			}
+
+		return n;
+		}
+
+	std::string Str()
+		{
+		auto n = Count();
+		if ( ! ok || pos + n > buf.size() )
+			{
+			ok = false;
+			return "";
+			}
+
+		std::string s = buf.substr(pos, n);
+		pos += n;
+		return s;
+		}
+
+	const char* OptStr(std::string& s)
+		{
+		if ( ! Int() )
+			return nullptr;
+
+		s = Str();
+		return s.c_str();
+		}
+
+	template <typename T> std::vector<T> IntVec()
+		{
+		std::vector<T> v;
+		auto n = Count();
+		for ( auto i = 0; i < n && ok; ++i )
+			v.push_back(static_cast<T>(Int()));
+
+		return v;
+		}
+
+	TypePtr Type();
+	ValPtr Val();
+
+private:
+	void Get(void* dst, size_t n)
+		{
+		if ( ! ok || pos + n > buf.size() )
+			{
+			ok = false;
+			return;
+			}
+
+		memcpy(dst, buf.data() + pos, n);
+		pos += n;
+		}
+
+	TypePtr Fail()
+		{
+		ok = false;
+		return nullptr;
+		}
+
+	ValPtr FailVal()
+		{
+		ok = false;
+		return nullptr;
+		}
+
+	std::string buf;
+	size_t pos = 0;
+	bool ok = true;
+	};
+
+TypePtr ZAMCacheReader::Type()
+	{
+	auto code = Int();
+
+	switch ( code )
+		{
+		case CTC_NIL:
+			return nullptr;
+
+		case CTC_BASE:
+			{
+			auto tag = Int();
+			if ( tag < 0 || tag >= NUM_TYPES )
+				return Fail();
+
+			return base_type(static_cast<TypeTag>(tag));
+			}
+
+		case CTC_NAMED:
+			{
+			const auto& id = id::find(Str());
+			if ( ! id || ! id->IsType() )
+				return Fail();
+
+			return id->GetType();
+			}
+
+		case CTC_VECTOR:
+		case CTC_FILE:
+		case CTC_TYPE:
+			{
+			auto sub = Type();
+			if ( ! sub )
+				return Fail();
+
+			if ( code == CTC_VECTOR )
+				return make_intrusive<VectorType>(std::move(sub));
+			if ( code == CTC_FILE )
+				return make_intrusive<FileType>(std::move(sub));
+			return make_intrusive<TypeType>(std::move(sub));
+			}
+
+		case CTC_SET:
+		case CTC_TABLE:
+			{
+			auto indices = Type();
+			if ( ! indices || indices->Tag() != TYPE_LIST )
+				return Fail();
+
+			auto tl = cast_intrusive<TypeList>(std::move(indices));
+
+			if ( code == CTC_SET )
+				return make_intrusive<SetType>(std::move(tl), nullptr);
+
+			auto yield = Type();
+			if ( ! yield )
+				return Fail();
+
+			return make_intrusive<TableType>(std::move(tl), std::move(yield));
+			}
+
+		case CTC_LIST:
+			{
+			auto tl = make_intrusive<TypeList>(Type());
+
+			auto n = Count();
+			for ( auto i = 0; i < n && ok; ++i )
+				{
+				auto lt = Type();
+				if ( ! lt )
+					return Fail();
+
+				tl->AppendEvenIfNotPure(std::move(lt));
+				}
+
+			return tl;
+			}
+
+		case CTC_OPAQUE:
+			return make_intrusive<OpaqueType>(Str());
+
+		default:
+			return Fail();
+		}
+	}
+
+ValPtr ZAMCacheReader::Val()
+	{
+	if ( ! Int() )
+		return nullptr;
+
+	auto t = Type();
+	if ( ! t )
+		return FailVal();
+
+	switch ( t->Tag() )
+		{
+		case TYPE_BOOL:
+			return val_mgr->Bool(Int());
+
+		case TYPE_INT:
+			return val_mgr->Int(Int());
+
+		case TYPE_ENUM:
+			return t->AsEnumType()->GetEnumVal(Int());
+
+		case TYPE_COUNT:
+			return val_mgr->Count(Int());
+
+		case TYPE_PORT:
+			return val_mgr->Port(Int());
+
+		case TYPE_DOUBLE:
+			return make_intrusive<DoubleVal>(Double());
+
+		case TYPE_TIME:
+			return make_intrusive<TimeVal>(Double());
+
+		case TYPE_INTERVAL:
+			return make_intrusive<IntervalVal>(Double());
+
+		case TYPE_STRING:
+			return make_intrusive<StringVal>(Str());
+
+		case TYPE_ADDR:
+			return make_intrusive<AddrVal>(Str());
+
+		case TYPE_SUBNET:
+			{
+			auto prefix = Str();
+			auto len = Int();
+			return make_intrusive<SubNetVal>(IPPrefix(IPAddr(prefix), len));
+			}
+
+		case TYPE_PATTERN:
+			{
+			auto exact = Str();
+			auto anywhere = Str();
+			auto re = new RE_Matcher(exact.c_str(), anywhere.c_str());
+
+			if ( ! ok || ! re->Compile() )
+				{
+				delete re;
+				return FailVal();
+				}
+
+			return make_intrusive<PatternVal>(re);
+			}
+
+		case TYPE_FUNC:
+			{
+			const auto& id = find_global_func(Str().c_str());
+			if ( ! id )
+				return FailVal();
+
+			return id->GetVal();
+			}
+
+		default:
+			return FailVal();
+		}
+	}
+
+// Collects the calls in a function body, in traversal order.
+class CallCollector : public TraversalCallback
+	{
+public:
+	CallCollector(std::vector<CallExprPtr>& _calls) : calls(_calls) { }
+
+	TraversalCode PreExpr(const Expr* e) override
+		{
+		if ( e->Tag() == EXPR_CALL )
+			{
+			auto c = const_cast<CallExpr*>(static_cast<const CallExpr*>(e));
+			calls.emplace_back(NewRef{}, c);
+			}
+
+		return TC_CONTINUE;
+		}
+
+private:
+	std::vector<CallExprPtr>& calls;
+	};
+
+ZAMBodyCache::ZAMBodyCache(ScriptFunc* f, StmtPtr _body, ProfileFuncs* pfs)
+	: func(f), body(std::move(_body))
+	{
+	ComputeKey(pfs);
+
+	CallCollector cc(calls);
+	body->Traverse(&cc);
+	}
+
+void ZAMBodyCache::ComputeKey(ProfileFuncs* pfs)
+	{
+	auto ctx = hash_init(Hash_SHA256);
+
+	auto add = [ctx](std::string_view s)
+	{
+		// Include a separator so that adjacent elements can't run
+		// together ambiguously.
+		hash_update(ctx, s.data(), s.size());
+		hash_update(ctx, "", 1);
+	};
+
+	add(CACHE_MAGIC);
+	add(zeek_version());
+	add(zeek_build_info);
+	add(std::to_string(OP_NOP));
+
+	const auto& ao = analysis_options;
+	add(util::fmt("%d%d%d%d", ao.inliner, ao.optimize_AST, ao.no_ZAM_opt, ao.profile_ZAM));
+
+	add(func->Name());
+	add(std::to_string(func->Flavor()));
+	add(obj_desc(body.get()));
+
+	// The body's description includes the names of the types and
+	// globals it uses, but not what they currently are.
+	ProfileFunc pf(func, body, true);
+
+	for ( auto t : pf.OrderedTypes() )
+		add(std::to_string(pfs->HashType(t)));
+
+	for ( auto id : pf.OrderedIdentifiers() )
+		{
+		if ( ! id->IsGlobal() )
+			continue;
+
+		add(id->Name());
+		add(std::to_string(pfs->HashType(id->GetType())));
+
+		// Constants can get folded into the compiled code.
+		if ( id->IsConst() && id->GetType()->Tag() != TYPE_FUNC && id->GetVal() )
+			add(obj_desc(id->GetVal().get()));
+		}
+
+	u_char digest[SHA256_DIGEST_LENGTH];
+	hash_final(ctx, digest);
+
+	key = sha256_digest_print(digest);
+	}
+
+std::string ZAMBodyCache::CachePath() const
+	{
+	return analysis_options.ZAM_cache_dir + "/" + key + ".zam";
+	}
+
+int ZAMBodyCache::CallIndex(const CallExpr* c) const
+	{
+	for ( auto i = 0U; i < calls.size(); ++i )
+		if ( calls[i].get() == c )
+			return i;
+
+	// Reduction can replace calls with copies, which we can still
+	// identify by the expression they originated from - as long as
+	// that's unique.
+	int match = -1;
+
+	for ( auto i = 0U; i < calls.size(); ++i )
+		if ( calls[i]->Original() == c->Original() )
+			{
+			if ( match >= 0 )
+				return -1;
+
+			match = i;
+			}
+
+	return match;
+	}
+
+template <typename T> static void save_cases(ZAMCacheWriter& w, const CaseMaps<T>& cases)
+	{
+	w.Int(cases.size());
+
+	for ( const auto& cm : cases )
+		{
+		w.Int(cm.size());
+
+		for ( const auto& [v, inst] : cm )
+			{
+			if constexpr ( std::is_same_v<T, double> )
+				w.Double(v);
+			else if constexpr ( std::is_same_v<T, std::string> )
+				w.Str(v);
+			else
+				w.Int(static_cast<int64_t>(v));
+
+			w.Int(inst);
+			}
+		}
+	}
+
+template <typename T> static CaseMaps<T> load_cases(ZAMCacheReader& r)
+	{
+	CaseMaps<T> cases;
+
+	auto n = r.Count();
+	for ( auto i = 0; i < n && r.Ok(); ++i )
+		{
+		CaseMap<T> cm;
+
+		auto ncm = r.Count();
+		for ( auto j = 0; j < ncm && r.Ok(); ++j )
+			{
+			T v;
+
+			if constexpr ( std::is_same_v<T, double> )
+				v = r.Double();
+			else if constexpr ( std::is_same_v<T, std::string> )
+				v = r.Str();
+			else
+				v = static_cast<T>(r.Int());
+
+			cm[v] = r.Int();
+			}
+
+		cases.push_back(std::move(cm));
+		}
+
+	return cases;
+	}
+
+bool ZAMBodyCache::Save(const ZBody* zb)
+	{
+	ZAMCacheWriter w;
+
+	w.Str(CACHE_MAGIC);
+	w.Str(key);
+
+	auto ifs = remapped_intrp_frame_sizes.find(func);
+	w.Int(ifs == remapped_intrp_frame_sizes.end() ? -1 : ifs->second);
+
+	w.Int(zb->frame_denizens.size());
+	for ( const auto& fd : zb->frame_denizens )
+		{
+		w.Int(fd.names.size());
+		for ( auto n : fd.names )
+			w.Str(n);
+
+		w.IntVec(fd.id_start);
+		w.Int(fd.scope_end);
+		w.Int(fd.is_managed);
+		}
+
+	w.IntVec(zb->managed_slots);
+
+	w.Int(zb->globals.size());
+	for ( const auto& g : zb->globals )
+		{
+		w.Str(g.id->Name());
+		w.Int(g.slot);
+		}
+
+	w.Int(zb->table_iters.size());
+	w.Int(zb->num_step_iters);
+
+	save_cases(w, zb->int_cases);
+	save_cases(w, zb->uint_cases);
+	save_cases(w, zb->double_cases);
+	save_cases(w, zb->str_cases);
+
+	w.Int(zb->ninst);
+	for ( auto i = 0U; i < zb->ninst; ++i )
+		if ( ! SaveInst(w, zb->insts[i]) )
+			return false;
+
+	// Write to a temporary file first, so that concurrent Zeek
+	// processes never see a partial one.
+	auto path = CachePath();
+	std::string tmp_path = util::fmt("%s.%d.tmp", path.c_str(), getpid());
+
+	std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+	if ( ! out )
+		return false;
+
+	const auto& buf = w.Buffer();
+	out.write(buf.data(), buf.size());
+	out.close();
+
+	if ( ! out || rename(tmp_path.c_str(), path.c_str()) != 0 )
+		{
+		unlink(tmp_path.c_str());
+		return false;
+		}
+
+	return true;
+	}
+
+bool ZAMBodyCache::SaveInst(ZAMCacheWriter& w, const ZInst& z) const
+	{
+	if ( z.e || z.attrs )
+		return false;
+
+	w.Int(z.op);
+	w.Int(z.op_type);
+	w.Int(z.v1);
+	w.Int(z.v2);
+	w.Int(z.v3);
+	w.Int(z.v4);
+	w.Int(z.is_managed);
+
+	if ( ! w.Type(z.t) || ! w.Type(z.t2) )
+		return false;
+
+	// Without a type, there's no way to interpret the constant, if any.
+	if ( ! w.Val(z.t ? z.ConstVal() : nullptr) )
+		return false;
+
+	if ( z.func )
+		{
+		const auto& id = find_global_func(z.func->Name());
+		if ( ! id || id->GetVal()->AsFunc() != z.func )
+			return false;
+		}
+
+	w.OptStr(z.func ? z.func->Name() : nullptr);
+	w.OptStr(z.event_handler ? z.event_handler->Name() : nullptr);
+
+	w.Int(z.loc != nullptr);
+	if ( z.loc )
+		{
+		w.Str(z.loc->filename ? z.loc->filename : "");
+		w.Int(z.loc->first_line);
+		w.Int(z.loc->last_line);
+		w.Int(z.loc->first_column);
+		w.Int(z.loc->last_column);
+		}
+
+	int call_index = -1;
+	if ( z.call_expr )
+		{
+		call_index = CallIndex(z.call_expr);
+		if ( call_index < 0 )
+			return false;
+		}
+
+	w.Int(call_index);
+
+	auto aux = z.aux;
+	w.Int(aux != nullptr);
+
+	if ( ! aux )
+		return true;
+
+	if ( aux->cat_args )
+		return false;
+
+	w.Int(aux->n);
+	w.Int(aux->slots != nullptr);
+
+	for ( auto i = 0; i < aux->n; ++i )
+		{
+		w.Int(aux->ints[i]);
+		if ( ! w.Val(aux->constants[i]) || ! w.Type(aux->types[i]) )
+			return false;
+		}
+
+	if ( aux->id_val && id::find(aux->id_val->Name()).get() != aux->id_val )
+		return false;
+
+	w.OptStr(aux->id_val ? aux->id_val->Name() : nullptr);
+	w.Int(aux->can_change_globals);
+	w.IntVec(aux->map);
+	w.IntVec(aux->loop_vars);
+
+	w.Int(aux->loop_var_types.size());
+	for ( const auto& lvt : aux->loop_var_types )
+		if ( ! w.Type(lvt) )
+			return false;
+
+	w.IntVec(aux->lvt_is_managed);
+
+	return w.Type(aux->value_var_type);
+	}
+
+IntrusivePtr<ZBody> ZAMBodyCache::Load()
+	{
+	std::ifstream in(CachePath(), std::ios::binary);
+	if ( ! in )
+		return nullptr;
+
+	std::string buf{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+	ZAMCacheReader r(std::move(buf));
+
+	if ( r.Str() != CACHE_MAGIC || r.Str() != key )
+		return nullptr;
+
+	auto interp_frame_size = r.Int();
+
+	auto zb = make_intrusive<ZBody>(func->Name());
+
+	auto nfd = r.Count();
+	for ( auto i = 0; i < nfd && r.Ok(); ++i )
+		{
+		FrameSharingInfo fd;
+
+		auto nn = r.Count();
+		for ( auto j = 0; j < nn && r.Ok(); ++j )
+			fd.names.push_back(intern_string(r.Str()));
+
+		fd.id_start = r.IntVec<zeek_uint_t>();
+		fd.scope_end = r.Int();
+		fd.is_managed = r.Int();
+
+		zb->frame_denizens.push_back(std::move(fd));
+		}
+
+	zb->managed_slots = r.IntVec<int>();
+
+	auto ng = r.Count();
+	for ( auto i = 0; i < ng && r.Ok(); ++i )
+		{
+		GlobalInfo g;
+		g.id = id::find(r.Str());
+		g.slot = r.Int();
+
+		if ( ! g.id )
+			return nullptr;
+
+		zb->globals.push_back(std::move(g));
+		}
+
+	zb->table_iters.resize(r.Count());
+	zb->num_step_iters = r.Int();
+
+	zb->int_cases = load_cases<zeek_int_t>(r);
+	zb->uint_cases = load_cases<zeek_uint_t>(r);
+	zb->double_cases = load_cases<double>(r);
+	zb->str_cases = load_cases<std::string>(r);
+
+	std::vector<ZInst*> insts;
+
+	auto discard_insts = [&insts]()
+	{
+		for ( auto z : insts )
+			{
+			delete z->aux;
+			delete z;
+			}
+	};
+
+	auto ninst = r.Count();
+	for ( auto i = 0; i < ninst && r.Ok(); ++i )
+		{
+		auto z = LoadInst(r, zb.get());
+
+		if ( ! z )
+			{
+			discard_insts();
+			return nullptr;
+			}
+
+		insts.push_back(z);
+		}
+
+	if ( ! r.Ok() || ! r.AtEnd() )
+		{
+		discard_insts();
+		return nullptr;
+		}
+
+	zb->InitFrame(non_recursive_funcs.count(func) > 0);
+	zb->SetInsts(insts);
+
+	// SetInsts() copies the instructions, but not their auxiliary
+	// information.
+	for ( auto z : insts )
+		delete z;
+
+	zb->cached_orig_body = body;
+
+	if ( interp_frame_size >= 0 )
+		{
+		auto& ifs = remapped_intrp_frame_sizes[func];
+		ifs = std::max(ifs, static_cast<int>(interp_frame_size));
+		}
+
+	return zb;
+	}
+
+ZInst* ZAMBodyCache::LoadInst(ZAMCacheReader& r, ZBody* zb) const
+	{
+	auto op = r.Int();
+	auto op_type = r.Int();
+
+	if ( op < 0 || op > OP_NOP || op_type < 0 || op_type > OP_VVVV_I2_I3_I4 )
+		return nullptr;
+
+	auto z = new ZInst(static_cast<ZOp>(op), static_cast<ZAMOpType>(op_type));
+
+	z->v1 = r.Int();
+	z->v2 = r.Int();
+	z->v3 = r.Int();
+	z->v4 = r.Int();
+	z->is_managed = r.Int();
+
+	z->t = r.Type();
+	z->t2 = r.Type();
+
+	if ( auto c = r.Val() )
+		z->c = ZVal(c, z->t);
+
+	std::string name;
+
+	if ( r.OptStr(name) )
+		{
+		const auto& id = find_global_func(name.c_str());
+		if ( ! id )
+			{
+			delete z;
+			return nullptr;
+			}
+
+		z->func = id->GetVal()->AsFunc();
+		}
+
+	if ( r.OptStr(name) )
+		{
+		z->event_handler = event_registry->Lookup(name);
+		if ( ! z->event_handler )
+			{
+			delete z;
+			return nullptr;
+			}
+		}
+
+	if ( r.Int() )
+		{
+		auto filename = r.Str();
+		auto first_line = r.Int();
+		auto last_line = r.Int();
+		auto first_column = r.Int();
+		auto last_column = r.Int();
+
+		// Consecutive instructions usually share their location.
+		auto& locs = zb->cached_locs;
+		auto fn = filename.empty() ? nullptr : intern_string(std::move(filename));
+		Location loc(fn, first_line, last_line, first_column, last_column);
+
+		if ( locs.empty() || *locs.back() != loc )
+			locs.push_back(std::make_unique<Location>(loc));
+
+		z->loc = locs.back().get();
+		}
+
+	auto call_index = r.Int();
+	if ( call_index >= static_cast<int64_t>(calls.size()) )
+		{
+		delete z;
+		return nullptr;
+		}
+
+	if ( call_index >= 0 )
+		z->call_expr = calls[call_index].get();
+
+	if ( ! r.Int() )
+		{
+		if ( r.Ok() )
+			return z;
+
+		delete z;
+		return nullptr;
+		}
+
+	auto n = r.Count();
+	auto aux = z->aux = new ZInstAux(n);
+
+	if ( ! r.Int() )
+		aux->slots = nullptr;
+
+	for ( auto i = 0; i < n && r.Ok(); ++i )
+		{
+		aux->ints[i] = r.Int();
+		aux->constants[i] = r.Val();
+		aux->types[i] = r.Type();
+		}
+
+	if ( r.OptStr(name) )
+		{
+		aux->id_val = id::find(name).get();
+		if ( ! aux->id_val )
+			{
+			delete aux;
+			delete z;
+			return nullptr;
+			}
+		}
+
+	aux->can_change_globals = r.Int();
+	aux->map = r.IntVec<int>();
+	aux->loop_vars = r.IntVec<int>();
+
+	auto nlvt = r.Count();
+	for ( auto i = 0; i < nlvt && r.Ok(); ++i )
+		aux->loop_var_types.push_back(r.Type());
+
+	aux->lvt_is_managed = r.IntVec<bool>();
+	aux->value_var_type = r.Type();
+
+	if ( ! r.Ok() )
+		{
+		delete aux;
+		delete z;
+		return nullptr;
+		}
+
+	return z;
+	}
+
+	} // namespace detail
+	} // namespace zeek
@@ -0,0 +1,66 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+// ZAMBodyCache: persistent storage of compiled ZAM function bodies.
+
+#pragma once
+
+#include "zeek/script_opt/ZAM/ZBody.h"
+
+namespace zeek::detail
+	{
+
+class ProfileFuncs;
+class ZAMCacheReader;
+class ZAMCacheWriter;
+
+// Saves compiled function bodies to the directory given by
+// analysis_options.ZAM_cache_dir, and loads them back in later Zeek
+// invocations so they needn't be compiled again.  Each body lives in
+// its own file, named by a hash over the Zeek build, the ZAM-related
+// options, the function's body (after inlining) and the types and
+// constant globals it uses.  Thus changing any of these simply leads
+// to a cache miss.
+//
+// Bodies that refer to elements we can't identify across invocations,
+// such as anonymous record types, "when" conditions or attributes,
+// don't get cached, and are compiled every time.
+class ZAMBodyCache
+	{
+public:
+	// "body" is the function body after inlining but prior to
+	// reduction.  Needs to be constructed before reducing the body,
+	// as we track the body's calls in their original order.
+	ZAMBodyCache(ScriptFunc* f, StmtPtr body, ProfileFuncs* pfs);
+
+	// Returns the cached compiled body, or nil if there isn't one
+	// (or it's unusable).
+	IntrusivePtr<ZBody> Load();
+
+	// Saves the given compiled body.  Returns false if the body
+	// can't be cached or writing it failed.
+	bool Save(const ZBody* zb);
+
+private:
+	// Computes the key identifying the body.
+	void ComputeKey(ProfileFuncs* pfs);
+
+	std::string CachePath() const;
+
+	bool SaveInst(ZAMCacheWriter& w, const ZInst& z) const;
+	ZInst* LoadInst(ZAMCacheReader& r, ZBody* zb) const;
+
+	// Returns the index of the given call in "calls", or -1 if
+	// we can't unambiguously identify it.
+	int CallIndex(const CallExpr* c) const;
+
+	ScriptFunc* func;
+	StmtPtr body;
+	std::string key;
+
+	// The calls present in the body, in traversal order.  Compiled
+	// instructions refer to these for error reporting and stack
+	// backtraces, so we save them as indices into this vector.
+	std::vector<CallExprPtr> calls;
+	};
+
+	} // namespace zeek::detail
@@ -2,6 +2,8 @@
 
 // Methods for dealing with ZAM branches.
 
+#include <unordered_map>
+
 #include "zeek/Desc.h"
 #include "zeek/Reporter.h"
 #include "zeek/script_opt/ZAM/Compile.h"
@@ -176,4 +178,65 @@ void ZAMCompiler::SetV4(ZAMStmt s, const InstLabel l)
 		inst->op_type = OP_VVVV_I4;
 	}
 
+void ZAMCompiler::FuseLoopBackEdges()
+	{
+	// Maps loop iteration instructions to the superinstructions that
+	// combine them with a preceding GoTo.  Next-Vector-Iter-Val-Var
+	// already uses all four operands, so it can't be fused.
+	static const std::unordered_map<ZOp, ZOp> fused_ops = {
+		{OP_NEXT_TABLE_ITER_VV, OP_GOTO_NEXT_TABLE_ITER_VVV},
+		{OP_NEXT_TABLE_ITER_NO_VARS_VV, OP_GOTO_NEXT_TABLE_ITER_NO_VARS_VVV},
+		{OP_NEXT_TABLE_ITER_VAL_VAR_VVV, OP_GOTO_NEXT_TABLE_ITER_VAL_VAR_VVVV},
+		{OP_NEXT_TABLE_ITER_VAL_VAR_NO_VARS_VVV, OP_GOTO_NEXT_TABLE_ITER_VAL_VAR_NO_VARS_VVVV},
+		{OP_NEXT_VECTOR_ITER_VVV, OP_GOTO_NEXT_VECTOR_ITER_VVVV},
+		{OP_NEXT_VECTOR_BLANK_ITER_VV, OP_GOTO_NEXT_VECTOR_BLANK_ITER_VVV},
+		{OP_NEXT_VECTOR_BLANK_ITER_VAL_VAR_VVV, OP_GOTO_NEXT_VECTOR_BLANK_ITER_VAL_VAR_VVVV},
+		{OP_NEXT_STRING_ITER_VVV, OP_GOTO_NEXT_STRING_ITER_VVVV},
+		{OP_NEXT_STRING_BLANK_ITER_VV, OP_GOTO_NEXT_STRING_BLANK_ITER_VVV},
+	};
+
+	int n = insts2.size();
+
+	for ( auto inst : insts2 )
+		{
+		if ( inst->op != OP_GOTO_V )
+			continue;
+
+		int t = inst->v1;
+		if ( t >= n )
+			// Branch to the end.
+			continue;
+
+		auto iter = insts2[t];
+		auto f = fused_ops.find(iter->op);
+		if ( f == fused_ops.end() )
+			continue;
+
+		// Take on the iteration instruction's operands, type, and
+		// auxiliary information, but leave our own location intact.
+		// Since instructions are neither added nor removed, all of
+		// the branch targets remain valid.
+		auto loc = inst->loc;
+		static_cast<ZInst&>(*inst) = *iter;
+		inst->loc = loc;
+		inst->op = f->second;
+		inst->target = iter->target;
+		inst->target_slot = iter->target_slot;
+
+		// The fused instruction resumes at the loop body, where the
+		// iteration instruction would have fallen through to.
+		if ( iter->op_type == OP_VV_I1_I2 )
+			{
+			inst->v3 = t + 1;
+			inst->op_type = OP_VVV_I1_I2_I3;
+			}
+		else
+			{
+			ASSERT(iter->op_type == OP_VVV_I2_I3);
+			inst->v4 = t + 1;
+			inst->op_type = OP_VVVV_I2_I3_I4;
+			}
+		}
+	}
+
 	} // zeek::detail
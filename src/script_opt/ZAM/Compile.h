@@ -103,6 +103,10 @@ private:
 	void CreateSharedFrameDenizens();
 	void ConcretizeSwitches();
 
+	// Replaces GoTo's to loop iteration instructions with combined
+	// superinstructions.  Runs once branches have been concretized.
+	void FuseLoopBackEdges();
+
 	// The following are used for switch statements, mapping the
 	// switch value (which can be any atomic type) to a branch target.
 	// We have vectors of them because functions can contain multiple
@@ -200,6 +200,9 @@ StmtPtr ZAMCompiler::CompileBody()
 
 	ConcretizeSwitches();
 
+	if ( ! analysis_options.no_ZAM_opt )
+		FuseLoopBackEdges();
+
 	// Could erase insts1 here to recover memory, but it's handy
 	// for debugging.
 
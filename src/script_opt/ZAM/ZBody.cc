@@ -1,5 +1,8 @@
 // See the file "COPYING" in the main distribution directory for copyright.
 
+#include <algorithm>
+#include <unordered_map>
+
 #include "zeek/Desc.h"
 #include "zeek/EventHandler.h"
 #include "zeek/Frame.h"
@@ -35,11 +38,24 @@ static bool did_init = false;
 int ZOP_count[OP_NOP + 1];
 double ZOP_CPU[OP_NOP + 1];
 
+// Count of how often each pair of ZOPs executed in succession, indexed by
+// the first times (OP_NOP + 1) plus the second.  Frequent pairs are
+// candidates for superinstructions.
+static std::unordered_map<int, int> ZOP_pair_count;
+
 void report_ZOP_profile()
 	{
 	for ( int i = 1; i <= OP_NOP; ++i )
 		if ( ZOP_count[i] > 0 )
 			printf("%s\t%d\t%.06f\n", ZOP_name(ZOp(i)), ZOP_count[i], ZOP_CPU[i]);
+
+	vector<std::pair<int, int>> pairs(ZOP_pair_count.begin(), ZOP_pair_count.end());
+	std::sort(pairs.begin(), pairs.end(),
+	          [](const auto& a, const auto& b) { return a.second > b.second; });
+
+	for ( auto& [p, n] : pairs )
+		printf("%s -> %s\t%d\n", ZOP_name(ZOp(p / (OP_NOP + 1))), ZOP_name(ZOp(p % (OP_NOP + 1))),
+		       n);
 	}
 
 // Sets the given element to a copy of an existing (not newly constructed)
@@ -129,7 +145,6 @@ ZBody::ZBody(const char* _func_name, const ZAMCompiler* zc) : Stmt(STMT_ZAM)
 	func_name = _func_name;
 
 	frame_denizens = zc->FrameDenizens();
-	frame_size = frame_denizens.size();
 
 	// Concretize the names of the frame denizens.
 	for ( auto& f : frame_denizens )
@@ -139,14 +154,29 @@ ZBody::ZBody(const char* _func_name, const ZAMCompiler* zc) : Stmt(STMT_ZAM)
 	managed_slots = zc->ManagedSlots();
 
 	globals = zc->Globals();
-	num_globals = globals.size();
 
 	int_cases = zc->GetCases<zeek_int_t>();
 	uint_cases = zc->GetCases<zeek_uint_t>();
 	double_cases = zc->GetCases<double>();
 	str_cases = zc->GetCases<std::string>();
 
-	if ( zc->NonRecursive() )
+	table_iters = zc->GetTableIters();
+	num_step_iters = zc->NumStepIters();
+
+	InitFrame(zc->NonRecursive());
+	}
+
+ZBody::ZBody(const char* _func_name) : Stmt(STMT_ZAM)
+	{
+	func_name = _func_name;
+	}
+
+void ZBody::InitFrame(bool non_recursive)
+	{
+	frame_size = frame_denizens.size();
+	num_globals = globals.size();
+
+	if ( non_recursive )
 		{
 		fixed_frame = new ZVal[frame_size];
 
@@ -154,10 +184,7 @@ ZBody::ZBody(const char* _func_name, const ZAMCompiler* zc) : Stmt(STMT_ZAM)
 			fixed_frame[ms].ClearManagedVal();
 		}
 
-	table_iters = zc->GetTableIters();
-	num_step_iters = zc->NumStepIters();
-
-	// It's a little weird doing this in the constructor, but unless
+	// It's a little weird doing this here, but unless
 	// we add a general "initialize for ZAM" function, this is as good
 	// a place as any.
 	if ( ! did_init )
@@ -189,7 +216,10 @@ void ZBody::SetInsts(vector<ZInst*>& _insts)
 	auto insts_copy = new ZInst[ninst];
 
 	for ( auto i = 0U; i < ninst; ++i )
+		{
 		insts_copy[i] = *_insts[i];
+		AddTableCache(insts_copy[i]);
+		}
 
 	insts = insts_copy;
 
@@ -207,6 +237,7 @@ void ZBody::SetInsts(vector<ZInstI*>& instsI)
 		insts_copy[i] = iI;
 		if ( iI.stmt )
 			insts_copy[i].loc = iI.stmt->Original()->GetLocationInfo();
+		AddTableCache(insts_copy[i]);
 		}
 
 	insts = insts_copy;
@@ -214,6 +245,18 @@ void ZBody::SetInsts(vector<ZInstI*>& instsI)
 	InitProfile();
 	}
 
+void ZBody::AddTableCache(ZInst& z)
+	{
+	if ( ! ZOpUsesTableCache(z.op) )
+		return;
+
+	if ( ! z.aux )
+		z.aux = new ZInstAux(0);
+
+	if ( ! z.aux->table_cache )
+		z.aux->table_cache = std::make_unique<ZAMTableCache>();
+	}
+
 void ZBody::InitProfile()
 	{
 	if ( analysis_options.profile_ZAM )
@@ -260,6 +303,7 @@ ValPtr ZBody::DoExec(Frame* f, int start_pc, StmtFlowType& flow)
 
 #ifdef DEBUG
 	bool do_profile = analysis_options.profile_ZAM;
+	ZOp prev_op = OP_NOP;
 #endif
 
 	ZVal* frame;
@@ -298,6 +342,10 @@ ValPtr ZBody::DoExec(Frame* f, int start_pc, StmtFlowType& flow)
 			++ZOP_count[z.op];
 			++(*inst_count)[pc];
 
+			if ( prev_op != OP_NOP )
+				++ZOP_pair_count[prev_op * (OP_NOP + 1) + z.op];
+			prev_op = z.op;
+
 			profile_pc = pc;
 			profile_CPU = util::curr_CPU_time();
 			}
@@ -31,32 +31,39 @@ class ZBody : public Stmt
 public:
 	ZBody(const char* _func_name, const ZAMCompiler* zc);
 
+	// Constructs an empty body, which ZAMBodyCache then populates
+	// from a cache file.
+	explicit ZBody(const char* _func_name);
+
 	~ZBody() override;
 
 	// These are split out from the constructor to allow construction
-	// of a ZBody from either save-file full instructions (first method,
-	// not currently supported) or intermediary instructions (second method).
+	// of a ZBody from either cached full instructions (first method)
+	// or intermediary instructions (second method).
 	void SetInsts(std::vector<ZInst*>& insts);
 	void SetInsts(std::vector<ZInstI*>& instsI);
 
 	ValPtr Exec(Frame* f, StmtFlowType& flow) override;
 
-	// Older code exists for save files, but let's see if we can
-	// avoid having to support them, as they're a fairly elaborate
-	// production.
-	//
-	// void SaveTo(FILE* f, int interp_frame_size) const;
-
 	void Dump() const;
 
 	void ProfileExecution() const;
 
 protected:
 	friend class ZAMResumption;
+	friend class ZAMBodyCache;
+
+	// Sets up the frame-related state once the frame denizens,
+	// managed slots and globals are in place.
+	void InitFrame(bool non_recursive);
 
 	// Initializes profiling information, if needed.
 	void InitProfile();
 
+	// Gives the instruction an inline table-lookup cache, if its
+	// op-code uses one.
+	void AddTableCache(ZInst& z);
+
 	ValPtr DoExec(Frame* f, int start_pc, StmtFlowType& flow);
 
 	// Run-time checking for "any" type being consistent with
@@ -115,6 +122,12 @@ private:
 	CaseMaps<zeek_uint_t> uint_cases;
 	CaseMaps<double> double_cases;
 	CaseMaps<std::string> str_cases;
+
+	// For bodies loaded from the cache, the instructions' locations,
+	// and the original AST, which holds the CallExpr's the instructions
+	// refer to.
+	std::vector<std::unique_ptr<Location>> cached_locs;
+	StmtPtr cached_orig_body;
 	};
 
 // This is a statement that resumes execution into a code block in a
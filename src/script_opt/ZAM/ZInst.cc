@@ -2,8 +2,11 @@
 
 #include "zeek/script_opt/ZAM/ZInst.h"
 
+#include <cstring>
+
 #include "zeek/Desc.h"
 #include "zeek/Func.h"
+#include "zeek/IPAddr.h"
 #include "zeek/Reporter.h"
 
 using std::string;
@@ -99,6 +102,10 @@ void ZInst::Dump(const string& id1, const string& id2, const string& id3, const
 			printf("%s, %d, %d", id1.c_str(), v2, v3);
 			break;
 
+		case OP_VVV_I1_I2_I3:
+			printf("%d, %d, %d", v1, v2, v3);
+			break;
+
 		case OP_VVVV_I4:
 			printf("%s, %s, %s, %d", id1.c_str(), id2.c_str(), id3.c_str(), v4);
 			break;
@@ -139,6 +146,7 @@ int ZInst::NumFrameSlots() const
 		case OP_V_I1:
 		case OP_VC_I1:
 		case OP_VV_I1_I2:
+		case OP_VVV_I1_I2_I3:
 		case OP_VVVC_I1_I2_I3:
 			return 0;
 
@@ -196,6 +204,7 @@ int ZInst::NumSlots() const
 		case OP_VVV:
 		case OP_VVV_I3:
 		case OP_VVV_I2_I3:
+		case OP_VVV_I1_I2_I3:
 		case OP_VVVC:
 		case OP_VVVC_I3:
 		case OP_VVVC_I2_I3:
@@ -275,6 +284,7 @@ ValPtr ZInst::ConstVal() const
 		case OP_VV_I1_I2:
 		case OP_VVV_I3:
 		case OP_VVV_I2_I3:
+		case OP_VVV_I1_I2_I3:
 		case OP_VVVV_I4:
 		case OP_VVVV_I3_I4:
 		case OP_VVVV_I2_I3_I4:
@@ -417,6 +427,7 @@ bool ZInstI::AssignsToSlot1() const
 		case OP_V_I1:
 		case OP_VC_I1:
 		case OP_VV_I1_I2:
+		case OP_VVV_I1_I2_I3:
 		case OP_VVVC_I1_I2_I3:
 			return false;
 
@@ -473,6 +484,7 @@ bool ZInstI::UsesSlot(int slot) const
 		case OP_V_I1:
 		case OP_VC_I1:
 		case OP_VV_I1_I2:
+		case OP_VVV_I1_I2_I3:
 		case OP_VVVC_I1_I2_I3:
 			return false;
 
@@ -519,6 +531,7 @@ bool ZInstI::UsesSlots(int& s1, int& s2, int& s3, int& s4) const
 		case OP_V_I1:
 		case OP_VC_I1:
 		case OP_VV_I1_I2:
+		case OP_VVV_I1_I2_I3:
 		case OP_VVVC_I1_I2_I3:
 			return false;
 
@@ -582,6 +595,7 @@ void ZInstI::UpdateSlots(std::vector<int>& slot_mapping)
 		case OP_V_I1:
 		case OP_VC_I1:
 		case OP_VV_I1_I2:
+		case OP_VVV_I1_I2_I3:
 		case OP_VVVC_I1_I2_I3:
 			return; // so we don't do any v1 remapping.
 
@@ -657,4 +671,124 @@ void ZInstI::InitConst(const ConstExpr* ce)
 		reporter->InternalError("bad value compiling code");
 	}
 
+const ValPtr& ZAMTableCache::Find(TableVal* tv, const ValPtr& index)
+	{
+	if ( tv == table && tv->ModificationStamp() == stamp && SameIndex(index.get()) )
+		return result;
+
+	const auto& r = tv->Find(index);
+
+	if ( Cacheable(tv, index) )
+		{
+		table = tv;
+		stamp = tv->ModificationStamp();
+		this->index = index;
+		result = r;
+		}
+
+	else if ( table )
+		{
+		// Don't hold on to values we won't be using.
+		table = nullptr;
+		this->index = nullptr;
+		result = nullptr;
+		}
+
+	return r;
+	}
+
+ValPtr ZAMTableCache::FindOrDefault(TableVal* tv, const ValPtr& index)
+	{
+	if ( auto r = Find(tv, index) )
+		return r;
+
+	return tv->FindOrDefault(index);
+	}
+
+bool ZAMTableCache::Cacheable(const TableVal* tv, const ValPtr& index)
+	{
+	// Subnet-indexed tables do longest-prefix matching, and
+	// lookups in tables with &read_expire have a side effect.
+	if ( tv->GetType<TableType>()->IsSubNetIndex() || tv->GetAttr(ATTR_EXPIRE_READ) )
+		return false;
+
+	switch ( index->GetType()->InternalType() )
+		{
+		case TYPE_INTERNAL_INT:
+		case TYPE_INTERNAL_UNSIGNED:
+		case TYPE_INTERNAL_DOUBLE:
+		case TYPE_INTERNAL_STRING:
+		case TYPE_INTERNAL_ADDR:
+			return true;
+
+		default:
+			return false;
+		}
+	}
+
+bool ZAMTableCache::SameIndex(const Val* v) const
+	{
+	if ( v->GetType()->Tag() != index->GetType()->Tag() )
+		return false;
+
+	switch ( v->GetType()->InternalType() )
+		{
+		case TYPE_INTERNAL_INT:
+			return v->InternalInt() == index->InternalInt();
+
+		case TYPE_INTERNAL_UNSIGNED:
+			return v->InternalUnsigned() == index->InternalUnsigned();
+
+		case TYPE_INTERNAL_DOUBLE:
+			{
+			// Compare representations, since the table hashes those:
+			// 0.0 and -0.0 are different indices.
+			auto d1 = v->InternalDouble();
+			auto d2 = index->InternalDouble();
+			return memcmp(&d1, &d2, sizeof(d1)) == 0;
+			}
+
+		case TYPE_INTERNAL_STRING:
+			return Bstr_eq(v->AsString(), index->AsString());
+
+		case TYPE_INTERNAL_ADDR:
+			return v->AsAddr() == index->AsAddr();
+
+		default:
+			return false;
+		}
+	}
+
+bool ZOpUsesTableCache(ZOp op)
+	{
+	static std::unordered_set<ZOp> cache_ops;
+
+	if ( cache_ops.empty() )
+		{ // Initialize the set.
+		cache_ops = {OP_VAL_IS_IN_TABLE_VVV,          OP_VAL_IS_IN_TABLE_COND_VVV,
+		             OP_VAL_IS_NOT_IN_TABLE_COND_VVV, OP_CONST_IS_IN_TABLE_VCV,
+		             OP_CONST_IS_IN_TABLE_COND_VVC,   OP_CONST_IS_NOT_IN_TABLE_COND_VVC};
+
+		// Table-Index1 is an assignment op, so we need its
+		// type-specific flavors, plus their assignment-less
+		// counterparts in case the optimizer prunes the assignment.
+		for ( auto index_op : {OP_TABLE_INDEX1_VVV, OP_TABLE_INDEX1_VVC} )
+			for ( int t = 0; t < NUM_TYPES; ++t )
+				{
+				ZOp flavor = AssignmentFlavor(index_op, TypeTag(t), false);
+
+				if ( flavor == OP_NOP )
+					continue;
+
+				cache_ops.insert(flavor);
+
+				auto aless = assignmentless_op.find(flavor);
+				if ( aless != assignmentless_op.end() )
+					cache_ops.insert(aless->second);
+				}
+		}
+
+	return cache_ops.count(op) > 0;
+	}
+
 	} // zeek::detail
@@ -301,6 +301,43 @@ private:
 	void InitConst(const ConstExpr* ce);
 	};
 
+// A single-entry inline cache for instructions that look up an atomic
+// index in a table.  Scripts often probe the same table with the same
+// index repeatedly (e.g., a loop testing membership in a constant set),
+// so we remember the last table, index and result.  The entry is only
+// used while the table's modification stamp is unchanged, so any
+// insertion, deletion, expiration or clearing of the table invalidates it.
+class ZAMTableCache
+	{
+public:
+	// Returns the same as tv->Find(index).
+	const ValPtr& Find(TableVal* tv, const ValPtr& index);
+
+	// Returns the same as tv->FindOrDefault(index).  Only actual
+	// entries are cached, not &default values.
+	ValPtr FindOrDefault(TableVal* tv, const ValPtr& index);
+
+private:
+	// Whether lookups of the given index can be cached for the table.
+	static bool Cacheable(const TableVal* tv, const ValPtr& index);
+
+	bool SameIndex(const Val* v) const;
+
+	// We only compare this to the table being looked up, never
+	// dereference it, so it's fine if it's stale.  The modification
+	// stamp is unique across tables, so a different table allocated
+	// at the same address won't match.
+	const TableVal* table = nullptr;
+	uint64_t stamp = 0;
+
+	ValPtr index;
+	ValPtr result;
+	};
+
+// Returns whether instructions with the given op-code look up tables
+// via a ZAMTableCache.
+extern bool ZOpUsesTableCache(ZOp op);
+
 // Auxiliary information, used when the fixed ZInst layout lacks
 // sufficient expressiveness to represent all of the elements that
 // an instruction needs.
@@ -441,6 +478,11 @@ public:
 	// iteration.
 	TypePtr value_var_type;
 
+	// Inline cache for table lookups, for the op-codes for which
+	// ZOpUsesTableCache() is true.  Created when the instructions
+	// are installed in their ZBody.
+	std::unique_ptr<ZAMTableCache> table_cache;
+
 	// This is only used to return values stored elsewhere in this
 	// object - it's not set directly.
 	//
@@ -449,6 +491,25 @@ public:
 	ValVec vv;
 	};
 
+// Looks up the given index in the given table, using the instruction's
+// inline cache if it has one.
+inline const ValPtr& ZAM_table_find(const ZInst& z, TableVal* tv, const ValPtr& index)
+	{
+	if ( z.aux && z.aux->table_cache )
+		return z.aux->table_cache->Find(tv, index);
+
+	return tv->Find(index);
+	}
+
+// Same, but for the semantics of TableVal::FindOrDefault().
+inline ValPtr ZAM_table_find_or_default(const ZInst& z, TableVal* tv, const ValPtr& index)
+	{
+	if ( z.aux && z.aux->table_cache )
+		return z.aux->table_cache->FindOrDefault(tv, index);
+
+	return tv->FindOrDefault(index);
+	}
+
 // Returns a human-readable version of the given ZAM op-code.
 extern const char* ZOP_name(ZOp op);
 
@@ -53,6 +53,8 @@ static const char* op_type_name(ZAMOpType ot)
 			return "VVV_I3";
 		case OP_VVV_I2_I3:
 			return "VVV_I2_I3";
+		case OP_VVV_I1_I2_I3:
+			return "VVV_I1_I2_I3";
 		case OP_VVVC:
 			return "VVVC";
 		case OP_VVVC_I3:
@@ -42,6 +42,7 @@ enum ZAMOpType
 	OP_VVV,
 	OP_VVV_I3,
 	OP_VVV_I2_I3,
+	OP_VVV_I1_I2_I3,
 
 	OP_VVVC,
 	OP_VVVC_I3,
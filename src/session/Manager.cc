@@ -8,6 +8,8 @@
 #include <netinet/in.h>
 #include <pcap.h>
 #include <unistd.h>
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
 
 #include "zeek/Desc.h"
@@ -20,6 +22,8 @@
 #include "zeek/TunnelEncapsulation.h"
 #include "zeek/analyzer/Manager.h"
 #include "zeek/iosource/IOSource.h"
+#include "zeek/iosource/Manager.h"
+#include "zeek/iosource/PktSrc.h"
 #include "zeek/packet_analysis/Manager.h"
 #include "zeek/session/Session.h"
 #include "zeek/telemetry/Manager.h"
@@ -241,6 +245,87 @@ void Manager::GetStats(Stats& s)
 	s.num_packets = packet_mgr->PacketsProcessed();
 	}
 
+bool Manager::ShedConnection(const zeek::detail::ConnKey& conn_key)
+	{
+	if ( ! BifConst::LoadShedding::enable )
+		return false;
+
+	if ( ! shedding_ratio_metric )
+		{
+		auto ratio_family = telemetry_mgr->GaugeFamily<double>(
+			"zeek", "load-shedding-ratio", {},
+			"Fraction of new connections excluded from application-layer analysis");
+		auto shed_family = telemetry_mgr->CounterFamily(
+			"zeek", "shed-sessions", {},
+			"Number of connections excluded from application-layer analysis", "1", true);
+
+		shedding_ratio_metric = ratio_family.GetOrAdd({});
+		shed_sessions_metric = shed_family.GetOrAdd({});
+		}
+
+	if ( shedding_last_update == 0.0 ||
+	     run_state::network_time - shedding_last_update >= BifConst::LoadShedding::update_interval )
+		UpdateSheddingRatio();
+
+	if ( shedding_ratio <= 0.0 )
+		return false;
+
+	// Map the connection onto [0, 1) by its hash. A connection shed at some
+	// ratio is shed at all higher ratios too, so raising the ratio never
+	// brings back connections that already lost their analyzers.
+	auto h = zeek::detail::HashKey::HashBytes(&conn_key, sizeof(conn_key));
+
+	if ( std::ldexp(static_cast<double>(h), -64) >= shedding_ratio )
+		return false;
+
+	shed_sessions_metric->Inc();
+	return true;
+	}
+
+void Manager::UpdateSheddingRatio()
+	{
+	shedding_last_update = run_state::network_time;
+
+	bool overloaded = false;
+
+	if ( auto* ps = iosource_mgr->GetPktSrc() )
+		{
+		iosource::PktSrc::Stats s;
+		ps->Statistics(&s);
+
+		// Counters may restart, e.g. when the source gets reopened.
+		uint64_t received = s.received >= shedding_last_received
+		                        ? s.received - shedding_last_received
+		                        : s.received;
+		uint64_t dropped = s.dropped >= shedding_last_dropped ? s.dropped - shedding_last_dropped
+		                                                      : s.dropped;
+
+		shedding_last_received = s.received;
+		shedding_last_dropped = s.dropped;
+
+		if ( dropped > 0 && static_cast<double>(dropped) / (received + dropped) >
+		                        BifConst::LoadShedding::drop_threshold )
+			overloaded = true;
+		}
+
+	if ( BifConst::LoadShedding::event_queue_threshold > 0 &&
+	     static_cast<zeek_uint_t>(event_mgr.Size()) > BifConst::LoadShedding::event_queue_threshold )
+		overloaded = true;
+
+	double min_ratio = BifConst::LoadShedding::min_ratio;
+	double max_ratio = std::max(min_ratio, BifConst::LoadShedding::max_ratio);
+	double step = BifConst::LoadShedding::ratio_step;
+	double ratio = overloaded ? shedding_ratio + step : shedding_ratio - step;
+
+	ratio = std::clamp(ratio, min_ratio, max_ratio);
+
+	if ( ratio != shedding_ratio )
+		{
+		shedding_ratio_metric->Inc(ratio - shedding_ratio);
+		shedding_ratio = ratio;
+		}
+	}
+
 void Manager::Weird(const char* name, const Packet* pkt, const char* addl, const char* source)
 	{
 	const char* weird_name = name;
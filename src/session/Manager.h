@@ -3,6 +3,7 @@
 #pragma once
 
 #include <sys/types.h> // for u_char
+#include <optional>
 #include <unordered_map>
 #include <utility>
 
@@ -91,6 +92,22 @@ public:
 
 	unsigned int CurrentSessions() { return session_map.size(); }
 
+	/**
+	 * Decides whether a new connection gets tracked only at the transport
+	 * layer because Zeek is shedding load. Updates the shedding ratio from
+	 * the current backlog signals first if that is due.
+	 *
+	 * @param conn_key The key of the new connection.
+	 * @return True if no application-layer analysis should be done for the
+	 * connection.
+	 */
+	bool ShedConnection(const zeek::detail::ConnKey& conn_key);
+
+	/**
+	 * @return The fraction of new connections currently being shed.
+	 */
+	double SheddingRatio() const { return shedding_ratio; }
+
 private:
 	using SessionMap = std::unordered_map<detail::Key, Session*, detail::KeyHash>;
 
@@ -101,8 +118,19 @@ private:
 	// avoid unnecessary incrementing of connecting counts).
 	void InsertSession(detail::Key key, Session* session);
 
+	// Samples packet drops and event queue depth and adjusts the
+	// shedding ratio accordingly.
+	void UpdateSheddingRatio();
+
 	SessionMap session_map;
 	detail::ProtocolStats* stats;
+
+	double shedding_ratio = 0.0;
+	double shedding_last_update = 0.0;
+	uint64_t shedding_last_received = 0;
+	uint64_t shedding_last_dropped = 0;
+	std::optional<telemetry::DblGauge> shedding_ratio_metric;
+	std::optional<telemetry::IntCounter> shed_sessions_metric;
 	};
 
 	} // namespace session
@@ -71,6 +71,50 @@ struct Stem
 		 * The Stem's parent process ID (i.e. PID of the Supervisor).
 		 */
 		pid_t parent_pid = 0;
+		/**
+		 * Whether the Stem runs in a node template, whose parent is
+		 * another Stem.
+		 */
+		bool is_template = false;
+		};
+
+	/**
+	 * A node template: a process that loads the scripts for a set of
+	 * prefork nodes once, and then forks them as their own Stem.
+	 */
+	struct NodeTemplate
+		{
+		NodeTemplate(Supervisor::NodeConfig arg_config);
+
+		/**
+		 * The configuration of the node the template loads scripts as.
+		 */
+		Supervisor::NodeConfig config;
+		/**
+		 * The template process.
+		 */
+		SupervisorNode process;
+		/**
+		 * Bidirectional pipes that allow the Stem and template to talk.
+		 */
+		std::unique_ptr<detail::PipePair> pipe;
+		/**
+		 * Whether the template has loaded its scripts and is ready to
+		 * receive node configurations.
+		 */
+		bool ready = false;
+		/**
+		 * Partial messages read from the template.
+		 */
+		std::string msg_buffer;
+		/**
+		 * Messages not yet written to the template.
+		 */
+		std::string out_buffer;
+		/**
+		 * The messages creating the template's nodes, keyed by node name.
+		 */
+		std::map<std::string, std::string> nodes;
 		};
 
 	Stem(State stem_state);
@@ -94,6 +138,31 @@ struct Stem
 	 */
 	std::variant<bool, SupervisedNode> Spawn(SupervisorNode* node);
 
+	/**
+	 * Like Spawn(), but for a node template.  If this returns a
+	 * SupervisedNode, we are the template process.
+	 */
+	std::variant<bool, SupervisedNode> SpawnTemplate(NodeTemplate* t);
+
+	/**
+	 * Hands a prefork node to the template for its configuration, spawning
+	 * the template first if there's none yet.
+	 */
+	std::optional<SupervisedNode> CreateFromTemplate(Supervisor::NodeConfig config,
+	                                                 std::string create_msg);
+
+	NodeTemplate* FindTemplate(std::string_view node_name);
+
+	void DestroyTemplate(const std::string& key);
+
+	void SendToTemplate(NodeTemplate* t, std::string_view msg);
+
+	void FlushTemplate(NodeTemplate* t);
+
+	void ProcessTemplateMessages(NodeTemplate* t);
+
+	bool DueForRevival(SupervisorNode* node) const;
+
 	int AliveNodeCount() const;
 
 	void KillNodes(int signal);
@@ -119,13 +188,18 @@ struct Stem
 	std::unique_ptr<detail::Flare> signal_flare;
 	std::unique_ptr<detail::PipePair> pipe;
 	std::map<std::string, SupervisorNode> nodes;
+	std::map<std::string, NodeTemplate> templates; // Keyed by template_key().
 	std::string msg_buffer;
 	bool shutting_down = false;
+	bool is_template;
 	};
 	}
 
 static Stem* stem = nullptr;
 
+// In a node template, the pipes to its parent Stem until it runs its own.
+static std::unique_ptr<detail::PipePair> node_template_pipe;
+
 static RETSIGTYPE stem_signal_handler(int signo)
 	{
 	stem->last_signal = signo;
@@ -622,8 +696,15 @@ size_t Supervisor::ProcessMessages()
 	return msgs.size();
 	}
 
+Stem::NodeTemplate::NodeTemplate(Supervisor::NodeConfig arg_config)
+	: config(std::move(arg_config)), process(config)
+	{
+	process.config.name = util::fmt("%s-template", config.name.data());
+	}
+
 Stem::Stem(State ss)
-	: parent_pid(ss.parent_pid), signal_flare(new detail::Flare()), pipe(std::move(ss.pipe))
+	: parent_pid(ss.parent_pid), signal_flare(new detail::Flare()), pipe(std::move(ss.pipe)),
+	  is_template(ss.is_template)
 	{
 	util::detail::set_thread_name("zeek.stem");
 	pipe->Swap();
@@ -645,6 +726,13 @@ Stem::Stem(State ss)
 
 	if ( res == -1 )
 		LogError("failed to set stem process group: %s", strerror(errno));
+
+	if ( is_template )
+		{
+		// Tell the parent Stem to send the node configurations now.
+		std::string msg = "ready";
+		util::safe_write(pipe->OutFD(), msg.data(), msg.size() + 1);
+		}
 	}
 
 Stem::~Stem()
@@ -664,6 +752,19 @@ void Stem::Reap()
 
 		Wait(&node, WNOHANG);
 		}
+
+	for ( auto& [key, t] : templates )
+		{
+		if ( ! t.process.pid || ! Wait(&t.process, WNOHANG) )
+			continue;
+
+		// Its nodes orphaned, they'll terminate, and the revived
+		// template gets their configurations once ready.
+		t.pipe = nullptr;
+		t.ready = false;
+		t.msg_buffer.clear();
+		t.out_buffer.clear();
+		}
 	}
 
 bool Stem::Wait(SupervisorNode* node, int options) const
@@ -776,39 +877,47 @@ void Stem::Destroy(SupervisorNode* node) const
 		}
 	}
 
-std::optional<SupervisedNode> Stem::Revive()
+bool Stem::DueForRevival(SupervisorNode* node) const
 	{
 	constexpr auto attempts_before_delay_increase = 3;
 	constexpr auto delay_increase_factor = 2;
 	constexpr auto reset_revival_state_after = 30;
 	auto now = std::chrono::steady_clock::now();
 	auto revival_reset = std::chrono::seconds(reset_revival_state_after);
+	auto time_since_spawn = now - node->spawn_time;
 
-	for ( auto& n : nodes )
+	if ( node->pid )
 		{
-		auto& node = n.second;
-		auto time_since_spawn = now - node.spawn_time;
-
-		if ( node.pid )
+		if ( time_since_spawn > revival_reset )
 			{
-			if ( time_since_spawn > revival_reset )
-				{
-				node.revival_attempts = 0;
-				node.revival_delay = 1;
-				}
-
-			continue;
+			node->revival_attempts = 0;
+			node->revival_delay = 1;
 			}
 
-		auto delay = std::chrono::seconds(node.revival_delay);
+		return false;
+		}
 
-		if ( time_since_spawn < delay )
-			continue;
+	auto delay = std::chrono::seconds(node->revival_delay);
+
+	if ( time_since_spawn < delay )
+		return false;
 
-		++node.revival_attempts;
+	++node->revival_attempts;
 
-		if ( node.revival_attempts % attempts_before_delay_increase == 0 )
-			node.revival_delay *= delay_increase_factor;
+	if ( node->revival_attempts % attempts_before_delay_increase == 0 )
+		node->revival_delay *= delay_increase_factor;
+
+	return true;
+	}
+
+std::optional<SupervisedNode> Stem::Revive()
+	{
+	for ( auto& n : nodes )
+		{
+		auto& node = n.second;
+
+		if ( ! DueForRevival(&node) )
+			continue;
 
 		auto spawn_res = Spawn(&node);
 
@@ -822,6 +931,21 @@ std::optional<SupervisedNode> Stem::Revive()
 		ReportStatus(node);
 		}
 
+	for ( auto& [key, t] : templates )
+		{
+		if ( ! DueForRevival(&t.process) )
+			continue;
+
+		auto spawn_res = SpawnTemplate(&t);
+
+		if ( std::holds_alternative<SupervisedNode>(spawn_res) )
+			return std::get<SupervisedNode>(spawn_res);
+
+		if ( std::get<bool>(spawn_res) )
+			LogError("Supervised node template '%s' (PID %d) revived after premature exit",
+			         t.process.Name().data(), t.process.pid);
+		}
+
 	return {};
 	}
 
@@ -861,6 +985,225 @@ std::variant<bool, SupervisedNode> Stem::Spawn(SupervisorNode* node)
 	return true;
 	}
 
+static std::string template_key(const Supervisor::NodeConfig& config)
+	{
+	// Everything that may affect loading scripts, leaving out what a
+	// node template's nodes set up for themselves after it forks them.
+	std::string rval;
+
+	auto add = [&rval](std::string_view s)
+	{
+		rval += std::to_string(s.size());
+		rval += ':';
+		rval += s;
+	};
+
+	auto role = BifEnum::Supervisor::NONE;
+
+	if ( auto it = config.cluster.find(config.name); it != config.cluster.end() )
+		role = it->second.role;
+
+	add(std::to_string(role));
+	add(config.pcap_file.value_or(""));
+	add(config.bare_mode ? (*config.bare_mode ? "T" : "F") : "");
+
+	for ( const auto& script : config.addl_base_scripts )
+		add(script);
+
+	add("");
+
+	for ( const auto& script : config.addl_user_scripts )
+		add(script);
+
+	add("");
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+#endif
+	for ( const auto& script : config.scripts )
+		add(script);
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+
+	add("");
+
+	for ( const auto& [name, value] : config.env )
+		{
+		add(name);
+		add(value);
+		}
+
+	add("");
+
+	for ( const auto& [name, ep] : config.cluster )
+		{
+		add(name);
+		add(std::to_string(ep.role));
+		add(ep.host);
+		add(std::to_string(ep.port));
+		add(ep.interface.value_or(""));
+		add(ep.pcap_file.value_or(""));
+		}
+
+	return rval;
+	}
+
+std::variant<bool, SupervisedNode> Stem::SpawnTemplate(NodeTemplate* t)
+	{
+	auto ppid = getpid();
+	auto& process = t->process;
+	auto template_pipe = std::make_unique<detail::PipePair>(FD_CLOEXEC, O_NONBLOCK);
+	auto fork_res = fork_with_stdio_redirect(util::fmt("node %s", process.Name().data()));
+	auto template_pid = fork_res.pid;
+
+	if ( template_pid == -1 )
+		{
+		LogError("failed to fork Zeek node template '%s': %s", process.Name().data(),
+		         strerror(errno));
+		return false;
+		}
+
+	if ( template_pid == 0 )
+		{
+		setsignal(SIGCHLD, SIG_DFL);
+		setsignal(SIGTERM, SIG_DFL);
+		util::detail::set_thread_name(util::fmt("zeek.%s", process.Name().data()));
+		node_template_pipe = std::move(template_pipe);
+		SupervisedNode rval;
+		rval.config = t->config;
+		rval.parent_pid = ppid;
+		rval.is_template = true;
+		return rval;
+		}
+
+	process.pid = template_pid;
+	// The template's nodes' output arrives already prefixed.
+	process.stdout_pipe.pipe = std::move(fork_res.stdout_pipe);
+	process.stdout_pipe.stream = stdout;
+	process.stderr_pipe.pipe = std::move(fork_res.stderr_pipe);
+	process.stderr_pipe.stream = stderr;
+	process.spawn_time = std::chrono::steady_clock::now();
+	t->pipe = std::move(template_pipe);
+	t->ready = false;
+	t->msg_buffer.clear();
+	t->out_buffer.clear();
+	DBG_STEM("Stem spawned node template: %s (PID %d)", process.Name().data(), process.pid);
+	return true;
+	}
+
+std::optional<SupervisedNode> Stem::CreateFromTemplate(Supervisor::NodeConfig config,
+                                                       std::string create_msg)
+	{
+	auto key = template_key(config);
+	auto it = templates.find(key);
+	auto name = config.name;
+
+	if ( it == templates.end() )
+		{
+		it = templates.emplace(key, std::move(config)).first;
+		auto spawn_res = SpawnTemplate(&it->second);
+
+		if ( std::holds_alternative<SupervisedNode>(spawn_res) )
+			return std::get<SupervisedNode>(spawn_res);
+		}
+
+	auto& t = it->second;
+	SendToTemplate(&t, create_msg);
+	t.nodes.emplace(std::move(name), std::move(create_msg));
+	return {};
+	}
+
+Stem::NodeTemplate* Stem::FindTemplate(std::string_view node_name)
+	{
+	for ( auto& [key, t] : templates )
+		if ( t.nodes.find(std::string(node_name)) != t.nodes.end() )
+			return &t;
+
+	return nullptr;
+	}
+
+void Stem::DestroyTemplate(const std::string& key)
+	{
+	auto it = templates.find(key);
+	assert(it != templates.end());
+	auto& t = it->second;
+	DBG_STEM("Stem destroying node template: %s (PID %d)", t.process.Name().data(),
+	         t.process.pid);
+	// The template itself terminates its remaining nodes.
+	Destroy(&t.process);
+	templates.erase(it);
+	}
+
+void Stem::SendToTemplate(NodeTemplate* t, std::string_view msg)
+	{
+	// Until it's ready, the template's nodes are only tracked here, and it
+	// gets all of them at once.
+	if ( ! t->ready )
+		return;
+
+	t->out_buffer.append(msg.data(), msg.size());
+	t->out_buffer += '\0';
+	FlushTemplate(t);
+	}
+
+void Stem::FlushTemplate(NodeTemplate* t)
+	{
+	// The template may be busy forking nodes for a while, so rather than
+	// blocking on a full pipe, keep what doesn't fit for later.
+	while ( t->ready && ! t->out_buffer.empty() )
+		{
+		auto n = write(t->pipe->OutFD(), t->out_buffer.data(), t->out_buffer.size());
+
+		if ( n < 0 )
+			{
+			if ( errno == EINTR )
+				continue;
+
+			if ( errno != EAGAIN && errno != EWOULDBLOCK )
+				LogError("Stem failed to write to node template '%s': %s",
+				         t->process.Name().data(), strerror(errno));
+
+			return;
+			}
+
+		t->out_buffer.erase(0, n);
+		}
+	}
+
+void Stem::ProcessTemplateMessages(NodeTemplate* t)
+	{
+	for ( ;; )
+		{
+		if ( ! t->pipe )
+			return;
+
+		auto [bytes_read, msgs] = read_msgs(t->pipe->InFD(), &t->msg_buffer, '\0');
+
+		for ( auto& msg : msgs )
+			{
+			if ( msg == "ready" )
+				{
+				DBG_STEM("Stem node template ready: %s (PID %d)", t->process.Name().data(),
+				         t->process.pid);
+				t->ready = true;
+
+				for ( const auto& [name, create_msg] : t->nodes )
+					SendToTemplate(t, create_msg);
+
+				continue;
+				}
+
+			// Status updates and logs about the template's nodes pass
+			// through to the Supervisor.
+			util::safe_write(pipe->OutFD(), msg.data(), msg.size() + 1);
+			}
+
+		if ( bytes_read <= 0 )
+			return;
+		}
+	}
+
 int Stem::AliveNodeCount() const
 	{
 	auto rval = 0;
@@ -869,6 +1212,10 @@ int Stem::AliveNodeCount() const
 		if ( n.second.pid )
 			++rval;
 
+	for ( const auto& [key, t] : templates )
+		if ( t.process.pid )
+			++rval;
+
 	return rval;
 	}
 
@@ -876,6 +1223,9 @@ void Stem::KillNodes(int signal)
 	{
 	for ( auto& n : nodes )
 		KillNode(&n.second, signal);
+
+	for ( auto& [key, t] : templates )
+		KillNode(&t.process, signal);
 	}
 
 void Stem::Shutdown(int exit_code)
@@ -983,8 +1333,9 @@ SupervisedNode Stem::Run()
 std::optional<SupervisedNode> Stem::Poll()
 	{
 	std::map<std::string, int> node_pollfd_indices;
+	std::map<std::string, int> template_pollfd_indices;
 	constexpr auto fixed_fd_count = 2;
-	const auto total_fd_count = fixed_fd_count + (nodes.size() * 2);
+	const auto total_fd_count = fixed_fd_count + (nodes.size() * 2) + (templates.size() * 4);
 	auto pfds = std::make_unique<pollfd[]>(total_fd_count);
 	int pfd_idx = 0;
 	pfds[pfd_idx++] = {static_cast<decltype(pollfd::fd)>(pipe->InFD()), POLLIN, 0};
@@ -1007,6 +1358,22 @@ std::optional<SupervisedNode> Stem::Poll()
 			pfds[pfd_idx++] = {static_cast<decltype(pollfd::fd)>(-1), POLLIN, 0};
 		}
 
+	for ( auto& [key, t] : templates )
+		{
+		template_pollfd_indices[key] = pfd_idx;
+		const auto& process = t.process;
+		FlushTemplate(&t);
+
+		auto out_fd = process.stdout_pipe.pipe ? process.stdout_pipe.pipe->ReadFD() : -1;
+		auto err_fd = process.stderr_pipe.pipe ? process.stderr_pipe.pipe->ReadFD() : -1;
+		auto in_fd = t.pipe ? t.pipe->InFD() : -1;
+		auto write_fd = t.pipe && ! t.out_buffer.empty() ? t.pipe->OutFD() : -1;
+		pfds[pfd_idx++] = {static_cast<decltype(pollfd::fd)>(out_fd), POLLIN, 0};
+		pfds[pfd_idx++] = {static_cast<decltype(pollfd::fd)>(err_fd), POLLIN, 0};
+		pfds[pfd_idx++] = {static_cast<decltype(pollfd::fd)>(in_fd), POLLIN, 0};
+		pfds[pfd_idx++] = {static_cast<decltype(pollfd::fd)>(write_fd), POLLOUT, 0};
+		}
+
 	// Note: the poll timeout here is for periodically checking if the parent
 	// process died (see below).
 	constexpr auto poll_timeout_ms = 1000;
@@ -1072,6 +1439,23 @@ std::optional<SupervisedNode> Stem::Poll()
 			node.stderr_pipe.Process();
 		}
 
+	for ( auto& [key, t] : templates )
+		{
+		auto idx = template_pollfd_indices[key];
+
+		if ( pfds[idx].revents )
+			t.process.stdout_pipe.Process();
+
+		if ( pfds[idx + 1].revents )
+			t.process.stderr_pipe.Process();
+
+		if ( pfds[idx + 2].revents )
+			ProcessTemplateMessages(&t);
+
+		if ( pfds[idx + 3].revents )
+			FlushTemplate(&t);
+		}
+
 	if ( ! pfds[0].revents )
 		// No messages from supervisor to process, so return early.
 		return {};
@@ -1103,6 +1487,20 @@ std::optional<SupervisedNode> Stem::Poll()
 			const auto& node_json = msg_tokens[2];
 			assert(nodes.find(node_name) == nodes.end());
 			auto node_config = Supervisor::NodeConfig::FromJSON(node_json);
+
+			if ( node_config.prefork && ! is_template )
+				{
+				DBG_STEM("Stem creating node from template: %s", node_name.data());
+				std::string create_msg = util::fmt("create %s %s", node_name.data(),
+				                                   node_json.data());
+				auto new_node = CreateFromTemplate(std::move(node_config), create_msg);
+
+				if ( new_node )
+					return new_node;
+
+				continue;
+				}
+
 			auto it = nodes.emplace(node_name, std::move(node_config)).first;
 			auto& node = it->second;
 
@@ -1116,6 +1514,19 @@ std::optional<SupervisedNode> Stem::Poll()
 			}
 		else if ( cmd == "destroy" )
 			{
+			if ( auto t = FindTemplate(node_name) )
+				{
+				DBG_STEM("Stem destroying node from template: %s", node_name.data());
+				t->nodes.erase(node_name);
+
+				if ( t->nodes.empty() )
+					DestroyTemplate(template_key(t->config));
+				else
+					SendToTemplate(t, util::fmt("destroy %s", node_name.data()));
+
+				continue;
+				}
+
 			auto it = nodes.find(node_name);
 			auto& node = it->second;
 			DBG_STEM("Stem destroying node: %s (PID %d)", node_name.data(), node.pid);
@@ -1124,6 +1535,13 @@ std::optional<SupervisedNode> Stem::Poll()
 			}
 		else if ( cmd == "restart" )
 			{
+			if ( auto t = FindTemplate(node_name) )
+				{
+				DBG_STEM("Stem restarting node from template: %s", node_name.data());
+				SendToTemplate(t, util::fmt("restart %s", node_name.data()));
+				continue;
+				}
+
 			auto it = nodes.find(node_name);
 			assert(it != nodes.end());
 			auto& node = it->second;
@@ -1210,6 +1628,63 @@ std::optional<SupervisorStemHandle> Supervisor::CreateStem(bool supervisor_mode)
 	return std::optional<SupervisorStemHandle>(std::move(sh));
 	}
 
+// Globals that scripts set to the node's name while they're parsed, and
+// that a node forked from a template of another name updates.
+static constexpr const char* node_name_globals[] = {
+	"Cluster::node",
+	"peer_description",
+	"Broker::metrics_export_endpoint_name",
+};
+
+void Supervisor::RunNodeTemplate(Options* options)
+	{
+	auto template_name = supervised_node->config.name;
+	Stem::State ss;
+	ss.pipe = std::move(node_template_pipe);
+	ss.parent_pid = supervised_node->parent_pid;
+	ss.is_template = true;
+
+		{
+		Stem template_stem{std::move(ss)};
+		supervised_node = template_stem.Run();
+		}
+
+	const auto& node = *supervised_node;
+	node.InitProcess();
+
+	if ( ! node.config.cluster.empty() )
+		{
+		if ( setenv("CLUSTER_NODE", node.config.name.data(), true) == -1 )
+			{
+			fprintf(stderr, "node '%s' failed to setenv: %s\n", node.config.name.data(),
+			        strerror(errno));
+			exit(1);
+			}
+		}
+
+	if ( node.config.interface )
+		options->interface = *node.config.interface;
+
+	if ( node.config.name != template_name )
+		{
+		for ( auto name : node_name_globals )
+			{
+			const auto& id = id::find(name);
+
+			if ( ! id || ! id->GetVal() || id->GetType()->Tag() != TYPE_STRING )
+				continue;
+
+			if ( id->GetVal()->AsStringVal()->ToStdString() == template_name )
+				id->SetVal(make_intrusive<StringVal>(node.config.name));
+			}
+		}
+
+	// Otherwise all nodes would continue the template's random number
+	// sequence, e.g. generating the same connection UIDs.
+	if ( ! util::detail::have_random_seed() )
+		util::detail::init_random_seed(nullptr, nullptr, false);
+	}
+
 static BifEnum::Supervisor::ClusterRole role_str_to_enum(std::string_view r)
 	{
 	if ( r == "Supervisor::LOGGER" )
@@ -1339,6 +1814,7 @@ Supervisor::NodeConfig Supervisor::NodeConfig::FromRecord(const RecordVal* node)
 		rval.cluster.emplace(name, std::move(ep));
 		}
 
+	rval.prefork = node->GetFieldOrDefault("prefork")->AsBool();
 	return rval;
 	}
 
@@ -1421,6 +1897,9 @@ Supervisor::NodeConfig Supervisor::NodeConfig::FromJSON(std::string_view json)
 		rval.cluster.emplace(key, std::move(ep));
 		}
 
+	if ( auto it = j.FindMember("prefork"); it != j.MemberEnd() )
+		rval.prefork = it->value.GetBool();
+
 	return rval;
 	}
 
@@ -1524,6 +2003,7 @@ RecordValPtr Supervisor::NodeConfig::ToRecord() const
 		cluster_val->Assign(std::move(key), std::move(val));
 		}
 
+	rval->AssignField("prefork", prefork);
 	return rval;
 	}
 
@@ -1605,7 +2085,7 @@ bool SupervisedNode::InitCluster() const
 	return true;
 	}
 
-void SupervisedNode::Init(Options* options) const
+void SupervisedNode::InitProcess() const
 	{
 	const auto& node_name = config.name;
 
@@ -1657,6 +2137,15 @@ void SupervisedNode::Init(Options* options) const
 			fprintf(stderr, "node '%s' failed to set CPU affinity: %s\n", node_name.data(),
 			        strerror(errno));
 		}
+	}
+
+void SupervisedNode::Init(Options* options) const
+	{
+	const auto& node_name = config.name;
+
+	// A node template leaves these to the nodes it forks.
+	if ( ! is_template )
+		InitProcess();
 
 	if ( ! config.env.empty() )
 		{
@@ -1685,7 +2174,7 @@ void SupervisedNode::Init(Options* options) const
 	if ( config.bare_mode )
 		options->bare_mode = *config.bare_mode;
 
-	if ( config.interface )
+	if ( config.interface && ! is_template )
 		options->interface = *config.interface;
 
 	if ( config.pcap_file )
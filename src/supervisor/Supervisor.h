@@ -254,6 +254,12 @@ public:
 		 * Entries in the map use node names for keys.
 		 */
 		std::map<std::string, ClusterEndpoint> cluster;
+		/**
+		 * Whether to fork the node from a node template: a process that
+		 * has already loaded and optimized the scripts, which it shares
+		 * copy-on-write with all nodes of the same configuration.
+		 */
+		bool prefork = false;
 		};
 
 	/**
@@ -267,6 +273,17 @@ public:
 	 */
 	static std::optional<detail::SupervisorStemHandle> CreateStem(bool supervisor_mode);
 
+	/**
+	 * Turn a node template into the stem of its nodes.  To be called once
+	 * the template has loaded and optimized its scripts, but before any
+	 * threads start.
+	 * @param options  the Zeek options, adjusted for the node the template
+	 * forks.
+	 * The template itself does not return from this function, but a node it
+	 * forks does, and information about it is then available in ThisNode().
+	 */
+	static void RunNodeTemplate(Options* options);
+
 	/**
 	 * @return  the state which describes what a supervised node should know
 	 * about itself if this is a supervised process.  If called from a process
@@ -428,15 +445,29 @@ struct SupervisedNode
 	 */
 	void Init(Options* options) const;
 
+	/**
+	 * Initialize the parts of the Supervised node's process state that
+	 * aren't shared with a node template: working directory, stdout/stderr
+	 * redirection and CPU affinity.
+	 */
+	void InitProcess() const;
+
 	/**
 	 * The node's configuration options.
 	 */
 	Supervisor::NodeConfig config;
 	/**
 	 * The process ID of the supervised node's parent process (i.e. the PID
-	 * of the Stem process).
+	 * of the Stem process, or of the node template the node was forked
+	 * from).
 	 */
 	pid_t parent_pid;
+	/**
+	 * Whether this is a node template that loads the scripts for nodes
+	 * configured with prefork, and then forks them instead of running
+	 * itself.  See Supervisor::RunNodeTemplate().
+	 */
+	bool is_template = false;
 	};
 
 /**
@@ -25,6 +25,7 @@ class IntCounter
 	{
 public:
 	friend class IntCounterFamily;
+	friend class Manager;
 
 	static inline const char* OpaqueName = "IntCounterMetricVal";
 
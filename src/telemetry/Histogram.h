@@ -27,6 +27,7 @@ class IntHistogram
 	{
 public:
 	friend class IntHistogramFamily;
+	friend class Manager;
 
 	static inline const char* OpaqueName = "IntHistogramMetricVal";
 
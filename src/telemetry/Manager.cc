@@ -10,6 +10,7 @@
 #include "zeek/ID.h"
 #include "zeek/broker/Manager.h"
 #include "zeek/telemetry/Timer.h"
+#include "zeek/util.h"
 #include "zeek/telemetry/telemetry.bif.h"
 
 #include "broker/telemetry/metric_registry.hh"
@@ -380,6 +381,8 @@ private:
 std::vector<Manager::CollectedValueMetric> Manager::CollectMetrics(std::string_view prefix,
                                                                    std::string_view name)
 	{
+	FlushShardedMetrics();
+
 	auto collector = MetricsCollector(prefix, name);
 
 	pimpl->collect(collector);
@@ -395,8 +398,8 @@ class HistogramMetricsCollector : public broker::telemetry::metrics_collector
 	using MetricType = Manager::MetricType;
 
 public:
-	HistogramMetricsCollector(std::string_view prefix, std::string_view name)
-		: matches(prefix, name)
+	HistogramMetricsCollector(Manager* mgr, std::string_view prefix, std::string_view name)
+		: mgr(mgr), matches(prefix, name)
 		{
 		}
 
@@ -472,6 +475,7 @@ public:
 			}
 
 		histogram_data.sum = broker::telemetry::sum(histogram);
+		mgr->MergeShardedHistogram(histogram, &histogram_data);
 
 		metrics.emplace_back(family, extract_label_values(labels), std::move(histogram_data));
 		}
@@ -479,6 +483,7 @@ public:
 	std::vector<Manager::CollectedHistogramMetric>& GetResult() { return metrics; }
 
 private:
+	Manager* mgr;
 	MetricFamilyMatcher matches;
 	std::vector<Manager::CollectedHistogramMetric> metrics;
 	};
@@ -486,13 +491,96 @@ private:
 std::vector<Manager::CollectedHistogramMetric>
 Manager::CollectHistogramMetrics(std::string_view prefix, std::string_view name)
 	{
-	auto collector = HistogramMetricsCollector(prefix, name);
+	auto collector = HistogramMetricsCollector(this, prefix, name);
 
 	pimpl->collect(collector);
 
 	return std::move(collector.GetResult());
 	}
 
+// -- sharded metrics ----------------------------------------------------------
+
+ShardedIntCounter Manager::ShardedCounter(IntCounter counter)
+	{
+	std::lock_guard<std::mutex> lock(sharded_mutex);
+
+	auto it = sharded_counters.find(counter.hdl);
+
+	if ( it == sharded_counters.end() )
+		{
+		ShardedCounterInfo info{counter, detail::Shard::Allocate(1), 0};
+		it = sharded_counters.emplace(counter.hdl, info).first;
+		have_sharded_counters = true;
+		}
+
+	return ShardedIntCounter{it->second.index};
+	}
+
+ShardedIntHistogram Manager::ShardedHistogram(IntHistogram histogram)
+	{
+	std::lock_guard<std::mutex> lock(sharded_mutex);
+
+	auto it = sharded_histograms.find(histogram.hdl);
+
+	if ( it == sharded_histograms.end() )
+		{
+		std::vector<int64_t> bounds;
+
+		for ( size_t i = 0; i + 1 < histogram.NumBuckets(); ++i )
+			bounds.push_back(histogram.UpperBoundAt(i));
+
+		// One cell per bucket, plus the sum.
+		size_t index = detail::Shard::Allocate(bounds.size() + 2);
+		it = sharded_histograms.emplace(histogram.hdl, ShardedHistogramInfo{index, bounds}).first;
+		}
+
+	// The map's nodes don't move, so the bounds stay where they are.
+	return ShardedIntHistogram{it->second.index, &it->second.bounds};
+	}
+
+void Manager::FlushShardedMetrics(bool force)
+	{
+	if ( ! have_sharded_counters )
+		return;
+
+	double now = util::current_time();
+
+	if ( ! force && now - last_sharded_flush < 1.0 )
+		return;
+
+	std::lock_guard<std::mutex> lock(sharded_mutex);
+	last_sharded_flush = now;
+
+	for ( auto& [hdl, info] : sharded_counters )
+		{
+		int64_t total = detail::Shard::Total(info.index);
+
+		if ( total > info.flushed )
+			{
+			info.counter.Inc(total - info.flushed);
+			info.flushed = total;
+			}
+		}
+	}
+
+void Manager::MergeShardedHistogram(const broker::telemetry::int_histogram_hdl* histogram,
+                                    CollectedHistogramMetric::IntHistogramData* data)
+	{
+	std::lock_guard<std::mutex> lock(sharded_mutex);
+
+	auto it = sharded_histograms.find(histogram);
+
+	if ( it == sharded_histograms.end() )
+		return;
+
+	const auto& info = it->second;
+
+	for ( size_t i = 0; i < data->buckets.size() && i <= info.bounds.size(); ++i )
+		data->buckets[i].count += detail::Shard::Total(info.index + i);
+
+	data->sum += detail::Shard::Total(info.index + info.bounds.size() + 1);
+	}
+
 	} // namespace zeek::telemetry
 
 // -- unit tests ---------------------------------------------------------------
@@ -702,3 +790,72 @@ SCENARIO("telemetry managers provide access to histogram families")
 			}
 		}
 	}
+
+SCENARIO("sharded metrics add up the updates of all threads")
+	{
+	GIVEN("a telemetry manager")
+		{
+		Manager mgr;
+		WHEN("incrementing a sharded counter from several threads")
+			{
+			auto family = mgr.CounterFamily("zeek", "sharded-packets", {"thread"}, "test");
+			auto counter = family.GetOrAdd({{"thread", "any"}});
+			auto sharded = mgr.ShardedCounter(counter);
+			counter.Inc(5);
+			sharded.Inc();
+			auto count = [sharded]() mutable
+			{
+				for ( int i = 0; i < 1000; ++i )
+					sharded.Inc();
+			};
+			std::thread t1{count};
+			std::thread t2{[sharded]() mutable { sharded.Inc(10); }};
+			t1.join();
+			t2.join();
+			THEN("the counter sees the sum once the shards are flushed")
+				{
+				CHECK_EQ(sharded.Value(), 1011);
+				CHECK_EQ(counter.Value(), 5);
+				mgr.FlushShardedMetrics();
+				CHECK_EQ(counter.Value(), 1016);
+				sharded.Inc();
+				mgr.FlushShardedMetrics();
+				CHECK_EQ(counter.Value(), 1017);
+				CHECK_EQ(mgr.ShardedCounter(counter).Value(), 1012);
+				}
+			}
+		WHEN("observing values with a sharded histogram from two threads")
+			{
+			int64_t buckets[] = {10, 20};
+			auto family = mgr.HistogramFamily("zeek", "sharded-sizes", {"thread"}, buckets, "test");
+			auto histogram = family.GetOrAdd({{"thread", "any"}});
+			auto sharded = mgr.ShardedHistogram(histogram);
+			histogram.Observe(5);
+			auto observe = [sharded]() mutable
+			{
+				sharded.Observe(15);
+				sharded.Observe(25);
+			};
+			std::thread t1{observe};
+			t1.join();
+			sharded.Observe(10);
+			THEN("collecting merges the shards into the histogram's data")
+				{
+				CHECK_EQ(sharded.NumBuckets(), 3u);
+				CHECK_EQ(sharded.CountAt(0), 1);
+				CHECK_EQ(sharded.CountAt(1), 1);
+				CHECK_EQ(sharded.CountAt(2), 1);
+				CHECK_EQ(sharded.Sum(), 50);
+				auto metrics = mgr.CollectHistogramMetrics("zeek", "sharded-sizes");
+				REQUIRE_EQ(metrics.size(), 1u);
+				const auto& data = std::get<Manager::CollectedHistogramMetric::IntHistogramData>(
+					metrics[0].histogram);
+				REQUIRE_EQ(data.buckets.size(), 3u);
+				CHECK_EQ(data.buckets[0].count, 2);
+				CHECK_EQ(data.buckets[1].count, 1);
+				CHECK_EQ(data.buckets[2].count, 1);
+				CHECK_EQ(data.sum, 55);
+				}
+			}
+		}
+	}
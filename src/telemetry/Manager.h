@@ -2,8 +2,10 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <initializer_list>
+#include <mutex>
 #include <string_view>
 #include <unordered_map>
 #include <variant>
@@ -14,6 +16,7 @@
 #include "zeek/telemetry/Counter.h"
 #include "zeek/telemetry/Gauge.h"
 #include "zeek/telemetry/Histogram.h"
+#include "zeek/telemetry/Sharded.h"
 
 #include "broker/telemetry/fwd.hh"
 
@@ -36,6 +39,8 @@ class Manager;
 namespace zeek::telemetry
 	{
 
+class HistogramMetricsCollector;
+
 /**
  * Manages a collection of metric families.
  */
@@ -43,6 +48,7 @@ class Manager
 	{
 public:
 	friend class Broker::Manager;
+	friend class HistogramMetricsCollector;
 
 	Manager();
 
@@ -443,6 +449,29 @@ public:
 		return HistogramInstance(prefix, name, lbls, default_upper_bounds, helptext, unit, is_sum);
 		}
 
+	/**
+	 * Returns a sharded counter that adds to a given counter. Repeated
+	 * calls for the same counter return handles to the same shards.
+	 * @param counter The counter to add to.
+	 */
+	ShardedIntCounter ShardedCounter(IntCounter counter);
+
+	/**
+	 * Returns a sharded histogram that's merged into a given histogram.
+	 * Repeated calls for the same histogram return handles to the same
+	 * shards.
+	 * @param histogram The histogram to merge into.
+	 */
+	ShardedIntHistogram ShardedHistogram(IntHistogram histogram);
+
+	/**
+	 * Adds what sharded counters counted since the last flush to their
+	 * counters.
+	 * @param force If false, flushes only if a second has passed since the
+	 *              last flush. Checking that is cheap, and takes no lock.
+	 */
+	void FlushShardedMetrics(bool force = true);
+
 protected:
 	template <class F> static void WithLabelNames(Span<const LabelView> xs, F continuation)
 		{
@@ -473,9 +502,39 @@ protected:
 	IntrusivePtr<broker::telemetry::metric_registry_impl> pimpl;
 
 private:
+	struct ShardedCounterInfo
+		{
+		IntCounter counter;
+		size_t index;
+		int64_t flushed; // The total at the last flush.
+		};
+
+	struct ShardedHistogramInfo
+		{
+		size_t index;
+		std::vector<int64_t> bounds; // Excluding the infinite bucket.
+		};
+
+	// Adds a sharded histogram's data to the data collected for its
+	// histogram, if the histogram has one.
+	void MergeShardedHistogram(const broker::telemetry::int_histogram_hdl* histogram,
+	                           CollectedHistogramMetric::IntHistogramData* data);
+
 	// Caching of metric_family_hdl instances to their Zeek record representation.
 	std::unordered_map<const broker::telemetry::metric_family_hdl*, zeek::RecordValPtr>
 		metric_opts_cache;
+
+	// Sharded metrics, keyed by the metrics they're merged into.
+	std::mutex sharded_mutex;
+	std::unordered_map<const broker::telemetry::int_counter_hdl*, ShardedCounterInfo>
+		sharded_counters;
+	std::unordered_map<const broker::telemetry::int_histogram_hdl*, ShardedHistogramInfo>
+		sharded_histograms;
+
+	// For unforced flushes, which the main loop asks for all the time, to
+	// check without locking if they have anything to do.
+	std::atomic<bool> have_sharded_counters{false};
+	std::atomic<double> last_sharded_flush{0.0};
 	};
 
 	} // namespace zeek::telemetry
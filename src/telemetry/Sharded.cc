@@ -0,0 +1,117 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek/telemetry/Sharded.h"
+
+#include <algorithm>
+#include <mutex>
+
+#include "zeek/Reporter.h"
+
+namespace zeek::telemetry::detail
+	{
+
+namespace
+	{
+
+struct Registry
+	{
+	std::mutex mutex;
+	std::vector<Shard*> shards; // Of running threads.
+	std::vector<int64_t> retired; // Cell totals of exited threads.
+	size_t num_cells = 0;
+	};
+
+// Leaked on purpose, as threads may exit after static destruction started.
+Registry& registry()
+	{
+	static auto* r = new Registry;
+	return *r;
+	}
+
+// Releases a thread's shard when the thread exits.
+struct ShardOwner
+	{
+	Shard* shard = nullptr;
+
+	~ShardOwner() { delete shard; }
+	};
+
+thread_local ShardOwner owner;
+
+	} // namespace
+
+Shard::~Shard()
+	{
+	auto& r = registry();
+	std::lock_guard<std::mutex> lock(r.mutex);
+
+	r.retired.resize(r.num_cells);
+
+	for ( size_t i = 0; i < MaxBlocks; ++i )
+		{
+		auto* block = blocks[i].load(std::memory_order_relaxed);
+
+		if ( ! block )
+			continue;
+
+		for ( size_t j = 0; j < BlockSize && i * BlockSize + j < r.num_cells; ++j )
+			r.retired[i * BlockSize + j] += block[j].load(std::memory_order_relaxed);
+
+		delete[] block;
+		}
+
+	r.shards.erase(std::remove(r.shards.begin(), r.shards.end(), this), r.shards.end());
+
+	if ( local == this )
+		local = nullptr;
+	}
+
+Shard* Shard::Attach()
+	{
+	auto* s = new Shard;
+
+		{
+		auto& r = registry();
+		std::lock_guard<std::mutex> lock(r.mutex);
+		r.shards.push_back(s);
+		}
+
+	owner.shard = s;
+	return s;
+	}
+
+Shard::Cell* Shard::AddBlock(size_t block)
+	{
+	// Value-initialization zeroes the cells.
+	auto* cells = new Cell[BlockSize]();
+	blocks[block].store(cells, std::memory_order_release);
+	return cells;
+	}
+
+size_t Shard::Allocate(size_t n)
+	{
+	auto& r = registry();
+	std::lock_guard<std::mutex> lock(r.mutex);
+
+	if ( r.num_cells + n > BlockSize * MaxBlocks )
+		reporter->FatalError("too many sharded telemetry metrics");
+
+	size_t index = r.num_cells;
+	r.num_cells += n;
+	return index;
+	}
+
+int64_t Shard::Total(size_t index)
+	{
+	auto& r = registry();
+	std::lock_guard<std::mutex> lock(r.mutex);
+
+	int64_t total = index < r.retired.size() ? r.retired[index] : 0;
+
+	for ( const auto* s : r.shards )
+		total += s->Value(index);
+
+	return total;
+	}
+
+	} // namespace zeek::telemetry::detail
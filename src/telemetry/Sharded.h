@@ -0,0 +1,186 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace zeek::telemetry
+	{
+
+class Manager;
+
+namespace detail
+	{
+
+/**
+ * A thread's private set of metric cells. Only the owning thread updates
+ * its cells, so an update is a plain load and store rather than an atomic
+ * read-modify-write, and threads never share a cache line. Other threads
+ * may read the cells at any time to aggregate them across threads.
+ */
+class Shard
+	{
+public:
+	static constexpr size_t BlockSize = 512;
+	static constexpr size_t MaxBlocks = 1024;
+
+	Shard() = default;
+	~Shard();
+
+	Shard(const Shard&) = delete;
+	Shard& operator=(const Shard&) = delete;
+
+	/**
+	 * Returns the calling thread's shard, creating it on first use.
+	 */
+	static Shard* Local()
+		{
+		if ( ! local )
+			local = Attach();
+
+		return local;
+		}
+
+	/**
+	 * Adds to a cell. Must only be called by the owning thread.
+	 */
+	void Add(size_t index, int64_t amount) noexcept
+		{
+		auto* block = blocks[index / BlockSize].load(std::memory_order_relaxed);
+
+		if ( ! block )
+			block = AddBlock(index / BlockSize);
+
+		auto& cell = block[index % BlockSize];
+		cell.store(cell.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+		}
+
+	/**
+	 * Returns a cell's value. May be called by any thread.
+	 */
+	int64_t Value(size_t index) const noexcept
+		{
+		auto* block = blocks[index / BlockSize].load(std::memory_order_acquire);
+		return block ? block[index % BlockSize].load(std::memory_order_relaxed) : 0;
+		}
+
+	/**
+	 * Reserves a range of cells in all shards, present and future.
+	 *
+	 * @param n The number of cells.
+	 *
+	 * @return The index of the first cell.
+	 */
+	static size_t Allocate(size_t n);
+
+	/**
+	 * Returns the sum of a cell across all threads, including those that
+	 * have exited already.
+	 */
+	static int64_t Total(size_t index);
+
+private:
+	using Cell = std::atomic<int64_t>;
+
+	static Shard* Attach();
+	Cell* AddBlock(size_t block);
+
+	std::array<std::atomic<Cell*>, MaxBlocks> blocks = {};
+
+	static inline thread_local Shard* local = nullptr;
+	};
+
+	} // namespace detail
+
+/**
+ * A counter for hot paths, such as per-packet processing. Each thread
+ * counts in its own shard without any synchronization. The shards are
+ * summed up and added to the IntCounter the sharded counter was created
+ * from whenever the telemetry manager flushes sharded metrics, which it
+ * does when collecting metrics and about once a second from the main loop.
+ * Instances are cheap handles that may be copied freely.
+ */
+class ShardedIntCounter
+	{
+public:
+	/**
+	 * Increments the value by 1.
+	 */
+	void Inc() noexcept { detail::Shard::Local()->Add(index, 1); }
+
+	/**
+	 * Increments the value by @p amount.
+	 * @pre `amount >= 0`
+	 */
+	void Inc(int64_t amount) noexcept { detail::Shard::Local()->Add(index, amount); }
+
+	/**
+	 * @return The sum of all increments across all threads, flushed or not.
+	 */
+	int64_t Value() const { return detail::Shard::Total(index); }
+
+private:
+	friend class Manager;
+
+	explicit ShardedIntCounter(size_t index) : index(index) { }
+
+	size_t index;
+	};
+
+/**
+ * A histogram for hot paths. Each thread records observations in its own
+ * shard. The shards are merged into the data of the IntHistogram the
+ * sharded histogram was created from when collecting histogram metrics.
+ * Since histogram observations can't be added in bulk, Broker's metrics
+ * exporter only sees the observations made through the IntHistogram itself.
+ * Instances are cheap handles that may be copied freely.
+ */
+class ShardedIntHistogram
+	{
+public:
+	/**
+	 * Increments the bucket @p value falls into and adds @p value to the
+	 * sum of all observed values.
+	 */
+	void Observe(int64_t value) noexcept
+		{
+		size_t bucket = 0;
+
+		while ( bucket < bounds->size() && value > (*bounds)[bucket] )
+			++bucket;
+
+		auto* shard = detail::Shard::Local();
+		shard->Add(index + bucket, 1);
+		shard->Add(index + bounds->size() + 1, value);
+		}
+
+	/// @return The sum of all observed values across all threads.
+	int64_t Sum() const { return detail::Shard::Total(index + bounds->size() + 1); }
+
+	/// @return The number of buckets, including the implicit "infinite" bucket.
+	size_t NumBuckets() const noexcept { return bounds->size() + 1; }
+
+	/// @return The number of observations in the bucket at @p bucket across
+	///         all threads.
+	/// @pre bucket < NumBuckets()
+	int64_t CountAt(size_t bucket) const { return detail::Shard::Total(index + bucket); }
+
+private:
+	friend class Manager;
+
+	// The cells are one per bucket, followed by the sum. The bounds exclude
+	// the infinite bucket and are owned by the manager.
+	ShardedIntHistogram(size_t index, const std::vector<int64_t>* bounds)
+		: index(index), bounds(bounds)
+		{
+		}
+
+	size_t index;
+	const std::vector<int64_t>* bounds;
+	};
+
+	} // namespace zeek::telemetry
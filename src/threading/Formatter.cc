@@ -5,6 +5,8 @@
 #include "zeek/zeek-config.h"
 
 #include <cerrno>
+#include <cstdarg>
+#include <cstdio>
 
 #include "zeek/3rdparty/zeek_inet_ntop.h"
 #include "zeek/threading/MsgThread.h"
@@ -22,6 +24,35 @@ Formatter::Formatter(threading::MsgThread* t)
 
 Formatter::~Formatter() { }
 
+void Formatter::Warning(const std::string& msg) const
+	{
+	if ( collected_warnings )
+		collected_warnings->push_back(msg);
+	else
+		thread->Warning(msg.c_str());
+	}
+
+std::string Formatter::Fmt(const char* format, ...) const
+	{
+	char buf[1024];
+	va_list al;
+	va_start(al, format);
+	int n = vsnprintf(buf, sizeof(buf), format, al);
+	va_end(al);
+
+	if ( n < 0 )
+		return format;
+
+	if ( static_cast<size_t>(n) < sizeof(buf) )
+		return std::string(buf, n);
+
+	std::string result(n, '\0');
+	va_start(al, format);
+	vsnprintf(result.data(), n + 1, format, al);
+	va_end(al);
+	return result;
+	}
+
 std::string Formatter::Render(const threading::Value::addr_t& addr)
 	{
 	if ( addr.family == IPv4 )
@@ -55,7 +86,7 @@ TransportProto Formatter::ParseProto(const std::string& proto) const
 	else if ( proto == "icmp" )
 		return TRANSPORT_ICMP;
 
-	thread->Warning(thread->Fmt("Tried to parse invalid/unknown protocol: %s", proto.c_str()));
+	Warning(Fmt("Tried to parse invalid/unknown protocol: %s", proto.c_str()));
 
 	return TRANSPORT_UNKNOWN;
 	}
@@ -71,7 +102,7 @@ threading::Value::addr_t Formatter::ParseAddr(const std::string& s) const
 
 		if ( inet_aton(s.c_str(), &(val.in.in4)) <= 0 )
 			{
-			thread->Warning(thread->Fmt("Bad address: %s", s.c_str()));
+			Warning(Fmt("Bad address: %s", s.c_str()));
 			memset(&val.in.in4.s_addr, 0, sizeof(val.in.in4.s_addr));
 			}
 		}
@@ -84,7 +115,7 @@ threading::Value::addr_t Formatter::ParseAddr(const std::string& s) const
 			clean_s = s.substr(1, s.length() - 2);
 		if ( inet_pton(AF_INET6, clean_s.c_str(), val.in.in6.s6_addr) <= 0 )
 			{
-			thread->Warning(thread->Fmt("Bad address: %s", clean_s.c_str()));
+			Warning(Fmt("Bad address: %s", clean_s.c_str()));
 			memset(val.in.in6.s6_addr, 0, sizeof(val.in.in6.s6_addr));
 			}
 		}
@@ -3,6 +3,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "zeek/Type.h"
 #include "zeek/threading/SerialTypes.h"
@@ -154,6 +155,17 @@ public:
 	 */
 	Value::addr_t ParseAddr(const std::string& addr) const;
 
+	/**
+	 * Collects the warnings of subsequent parsing in a list rather than
+	 * flagging them via the thread. This makes parsing safe on threads
+	 * other than the formatter's own, as long as each of them uses a
+	 * separate formatter.
+	 *
+	 * @param warnings The list to append warnings to, or null to flag
+	 * them via the thread again.
+	 */
+	void CollectWarnings(std::vector<std::string>* warnings) { collected_warnings = warnings; }
+
 protected:
 	/**
 	 * Returns the thread associated with the formatter via the
@@ -161,8 +173,21 @@ protected:
 	 */
 	MsgThread* GetThread() const { return thread; }
 
+	/**
+	 * Flags a warning via the thread, or appends it to the list passed to
+	 * CollectWarnings().
+	 */
+	void Warning(const std::string& msg) const;
+
+	/**
+	 * Formats a warning message. Unlike MsgThread::Fmt(), this is safe to
+	 * use from any thread.
+	 */
+	std::string Fmt(const char* format, ...) const __attribute__((format(printf, 2, 3)));
+
 private:
 	MsgThread* thread;
+	std::vector<std::string>* collected_warnings = nullptr;
 	};
 
 	} // namespace zeek::threading
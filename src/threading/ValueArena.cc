@@ -0,0 +1,171 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek/threading/ValueArena.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "zeek/3rdparty/doctest.h"
+#include "zeek/util.h"
+
+namespace zeek::threading
+	{
+
+void* ValueArena::Allocate(size_t size)
+	{
+	constexpr size_t align = alignof(std::max_align_t);
+	size = (size + align - 1) & ~(align - 1);
+
+	if ( blocks.empty() || used + size > blocks[current].size )
+		NextBlock(size);
+
+	void* p = blocks[current].data.get() + used;
+	used += size;
+	return p;
+	}
+
+Value* ValueArena::NewValues(size_t n)
+	{
+	auto vals = static_cast<Value*>(Allocate(n * sizeof(Value)));
+
+	for ( size_t i = 0; i < n; ++i )
+		new (&vals[i]) Value();
+
+	return vals;
+	}
+
+char* ValueArena::CopyString(const char* data, size_t len)
+	{
+	auto s = static_cast<char*>(Allocate(len + 1));
+	memcpy(s, data, len);
+	s[len] = '\0';
+	return s;
+	}
+
+void ValueArena::CopyValue(Value* dst, const Value& src)
+	{
+	dst->type = src.type;
+	dst->subtype = src.subtype;
+	dst->present = src.present;
+	dst->val = src.val;
+	dst->SetFileLineNumber(src.GetFileLineNumber());
+
+	if ( ! src.present )
+		return;
+
+	switch ( src.type )
+		{
+		case TYPE_ENUM:
+		case TYPE_STRING:
+		case TYPE_FILE:
+		case TYPE_FUNC:
+			dst->val.string_val.data = CopyString(src.val.string_val.data,
+			                                      src.val.string_val.length);
+			break;
+
+		case TYPE_PATTERN:
+			dst->val.pattern_text_val = CopyString(src.val.pattern_text_val,
+			                                       strlen(src.val.pattern_text_val));
+			break;
+
+		case TYPE_TABLE:
+		case TYPE_VECTOR:
+			{
+			// Sets and vectors share the same layout.
+			auto& elems = dst->val.set_val;
+			elems.vals = NewValueArray(elems.size);
+
+			for ( zeek_int_t i = 0; i < elems.size; ++i )
+				{
+				elems.vals[i] = NewValue(TYPE_ERROR);
+				CopyValue(elems.vals[i], *src.val.set_val.vals[i]);
+				}
+
+			break;
+			}
+
+		default:
+			break;
+		}
+	}
+
+size_t ValueArena::Capacity() const
+	{
+	size_t n = 0;
+
+	for ( const auto& b : blocks )
+		n += b.size;
+
+	return n;
+	}
+
+void ValueArena::NextBlock(size_t min_size)
+	{
+	used = 0;
+
+	while ( ! blocks.empty() && current + 1 < blocks.size() )
+		{
+		if ( blocks[++current].size >= min_size )
+			return;
+		}
+
+	// Blocks come from new[], which aligns them for any type.
+	size_t n = std::max(block_size, min_size);
+	blocks.push_back({std::unique_ptr<char[]>(new char[n]), n});
+	current = blocks.size() - 1;
+	}
+
+TEST_SUITE_BEGIN("ValueArena");
+
+TEST_CASE("allocation and release")
+	{
+	ValueArena arena(256);
+
+	auto v = arena.NewValue(TYPE_COUNT);
+	v->val.uint_val = 42;
+	CHECK(v->present);
+	CHECK(reinterpret_cast<uintptr_t>(v) % alignof(std::max_align_t) == 0);
+
+	auto s = arena.CopyString("hello", 5);
+	CHECK(strcmp(s, "hello") == 0);
+
+	auto m = arena.GetMark();
+	auto big = arena.Allocate(1024);
+	CHECK(arena.Capacity() >= 1024 + 256);
+
+	arena.Release(m);
+	CHECK(arena.Allocate(1024) == big);
+	CHECK(v->val.uint_val == 42);
+	}
+
+TEST_CASE("copying values")
+	{
+	ValueArena arena(256);
+
+	Value src(TYPE_VECTOR, TYPE_STRING);
+	src.val.vector_val.size = 2;
+	src.val.vector_val.vals = new Value*[2];
+
+	for ( int i = 0; i < 2; ++i )
+		{
+		auto s = new Value(TYPE_STRING);
+		s->val.string_val.data = util::copy_string(i ? "two" : "one");
+		s->val.string_val.length = 3;
+		src.val.vector_val.vals[i] = s;
+		}
+
+	auto v = arena.NewValue(TYPE_ERROR);
+	arena.CopyValue(v, src);
+
+	CHECK(v->type == TYPE_VECTOR);
+	CHECK(v->subtype == TYPE_STRING);
+	REQUIRE(v->val.vector_val.size == 2);
+	CHECK(v->val.vector_val.vals != src.val.vector_val.vals);
+	CHECK(v->val.vector_val.vals[1]->val.string_val.data !=
+	      src.val.vector_val.vals[1]->val.string_val.data);
+	CHECK(strcmp(v->val.vector_val.vals[1]->val.string_val.data, "two") == 0);
+	}
+
+TEST_SUITE_END();
+
+	} // namespace zeek::threading
@@ -0,0 +1,149 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "zeek/threading/SerialTypes.h"
+
+namespace zeek::threading
+	{
+
+/**
+ * A bump allocator for threading::Value instances and the data they point
+ * to. Memory is carved out of large blocks and released all at once when
+ * the arena goes away, so filling in a record's values needs no per-value
+ * heap allocations, and handing a whole set of records to another thread
+ * just means handing over the arena.
+ *
+ * Values allocated here are never destructed individually. Accordingly, their
+ * strings, sets and vectors must be allocated from the same arena as well,
+ * rather than with new[].
+ *
+ * An arena is not thread-safe; it must only be used by one thread at a time.
+ *
+ */
+class ValueArena
+	{
+public:
+	/**
+	 * A position in the arena, as returned by GetMark().
+	 */
+	struct Mark
+		{
+		size_t block;
+		size_t used;
+		};
+
+	/**
+	 * Constructor.
+	 *
+	 * @param block_size The size of the blocks that memory is carved out of.
+	 * Larger allocations get a block of their own.
+	 */
+	explicit ValueArena(size_t block_size = 64 * 1024) : block_size(block_size) { }
+
+	ValueArena(const ValueArena&) = delete;
+	ValueArena& operator=(const ValueArena&) = delete;
+
+	/**
+	 * Allocates raw memory, aligned suitably for any type.
+	 *
+	 * @param size The number of bytes.
+	 */
+	void* Allocate(size_t size);
+
+	/**
+	 * Allocates and constructs a value.
+	 *
+	 * @param type The type of the value.
+	 *
+	 * @param present False if the value represents an optional record field
+	 * that is not set.
+	 */
+	Value* NewValue(TypeTag type, bool present = true)
+		{
+		return new (Allocate(sizeof(Value))) Value(type, present);
+		}
+
+	/**
+	 * Allocates and default-constructs an array of values, which callers
+	 * then fill in.
+	 *
+	 * @param n The number of values.
+	 */
+	Value* NewValues(size_t n);
+
+	/**
+	 * Allocates an uninitialized array of value pointers, such as for the
+	 * elements of a set or vector.
+	 *
+	 * @param n The number of pointers.
+	 */
+	Value** NewValueArray(size_t n)
+		{
+		return static_cast<Value**>(Allocate(n * sizeof(Value*)));
+		}
+
+	/**
+	 * Copies a string into the arena. The copy is NUL-terminated, though
+	 * the terminator isn't part of the length that Value::string_val
+	 * records.
+	 *
+	 * @param data The string's bytes.
+	 *
+	 * @param len The number of bytes.
+	 */
+	char* CopyString(const char* data, size_t len);
+
+	/**
+	 * Copies a value into the arena, including any strings, sets and
+	 * vectors it points to.
+	 *
+	 * @param dst The value to overwrite. Whatever it pointed to before is
+	 * not released.
+	 *
+	 * @param src The value to copy, which may have been allocated anywhere.
+	 */
+	void CopyValue(Value* dst, const Value& src);
+
+	/**
+	 * Returns the current allocation position, for a later Release().
+	 */
+	Mark GetMark() const { return {current, used}; }
+
+	/**
+	 * Frees everything allocated since the given mark was taken. The
+	 * memory is kept for reuse by subsequent allocations.
+	 */
+	void Release(Mark m)
+		{
+		current = m.block;
+		used = m.used;
+		}
+
+	/**
+	 * Returns the total size of the arena's blocks.
+	 */
+	size_t Capacity() const;
+
+private:
+	// Makes the next block with at least the given size the current one,
+	// reusing blocks kept by Release() where possible.
+	void NextBlock(size_t min_size);
+
+	struct Block
+		{
+		std::unique_ptr<char[]> data;
+		size_t size;
+		};
+
+	std::vector<Block> blocks;
+	size_t current = 0; // Index of the block we allocate from.
+	size_t used = 0; // Bytes allocated from the current block.
+	size_t block_size;
+	};
+
+	} // namespace zeek::threading
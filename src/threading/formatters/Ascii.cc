@@ -198,8 +198,7 @@ bool Ascii::Describe(ODesc* desc, Value* val, const string& name) const
 			}
 
 		default:
-			GetThread()->Warning(
-				GetThread()->Fmt("Ascii writer unsupported field format %d", val->type));
+			Warning(Fmt("Ascii writer unsupported field format %d", val->type));
 			return false;
 		}
 
@@ -240,8 +239,7 @@ Value* Ascii::ParseValue(const string& s, const string& name, TypeTag type, Type
 				val->val.int_val = 0;
 			else
 				{
-				GetThread()->Warning(GetThread()->Fmt("Field: %s Invalid value for boolean: %s",
-				                                      name.c_str(), start));
+				Warning(Fmt("Field: %s Invalid value for boolean: %s", name.c_str(), start));
 				goto parse_error;
 				}
 			break;
@@ -285,8 +283,8 @@ Value* Ascii::ParseValue(const string& s, const string& name, TypeTag type, Type
 				else if ( util::strtolower(proto) == "unknown" )
 					val->val.port_val.proto = TRANSPORT_UNKNOWN;
 				else
-					GetThread()->Warning(GetThread()->Fmt(
-						"Port '%s' contained unknown protocol '%s'", s.c_str(), proto.c_str()));
+					Warning(Fmt("Port '%s' contained unknown protocol '%s'", s.c_str(),
+					            proto.c_str()));
 				}
 
 			if ( pos != std::string::npos && pos > 0 )
@@ -306,7 +304,7 @@ Value* Ascii::ParseValue(const string& s, const string& name, TypeTag type, Type
 			size_t pos = unescaped.find('/');
 			if ( pos == unescaped.npos )
 				{
-				GetThread()->Warning(GetThread()->Fmt("Invalid value for subnet: %s", start));
+				Warning(Fmt("Invalid value for subnet: %s", start));
 				goto parse_error;
 				}
 
@@ -348,8 +346,7 @@ Value* Ascii::ParseValue(const string& s, const string& name, TypeTag type, Type
 					}
 				}
 
-			GetThread()->Warning(
-				GetThread()->Fmt("String '%s' contained no parseable pattern.", candidate.c_str()));
+			Warning(Fmt("String '%s' contained no parseable pattern.", candidate.c_str()));
 			goto parse_error;
 			}
 
@@ -407,10 +404,9 @@ Value* Ascii::ParseValue(const string& s, const string& name, TypeTag type, Type
 
 					if ( pos >= length )
 						{
-						GetThread()->Warning(GetThread()->Fmt(
-							"Internal error while parsing set. pos %d >= length %d."
-							" Element: %s",
-							pos, length, element.c_str()));
+						Warning(Fmt("Internal error while parsing set. pos %d >= length %d."
+						            " Element: %s",
+						            pos, length, element.c_str()));
 						error = true;
 						break;
 						}
@@ -418,7 +414,7 @@ Value* Ascii::ParseValue(const string& s, const string& name, TypeTag type, Type
 					Value* newval = ParseValue(element, name, subtype);
 					if ( newval == nullptr )
 						{
-						GetThread()->Warning("Error while reading set or vector");
+						Warning("Error while reading set or vector");
 						error = true;
 						break;
 						}
@@ -436,7 +432,7 @@ Value* Ascii::ParseValue(const string& s, const string& name, TypeTag type, Type
 					lvals[pos] = ParseValue("", name, subtype);
 					if ( lvals[pos] == nullptr )
 						{
-						GetThread()->Warning("Error while trying to add empty set element");
+						Warning("Error while trying to add empty set element");
 						goto parse_error;
 						}
 
@@ -459,8 +455,8 @@ Value* Ascii::ParseValue(const string& s, const string& name, TypeTag type, Type
 
 				if ( pos != length )
 					{
-					GetThread()->Warning(GetThread()->Fmt(
-						"Internal error while parsing set: did not find all elements: %s", start));
+					Warning(Fmt("Internal error while parsing set: did not find all elements: %s",
+					            start));
 					goto parse_error;
 					}
 
@@ -468,8 +464,7 @@ Value* Ascii::ParseValue(const string& s, const string& name, TypeTag type, Type
 				}
 
 		default:
-			GetThread()->Warning(
-				GetThread()->Fmt("unsupported field format %d for %s", type, name.c_str()));
+			Warning(Fmt("unsupported field format %d for %s", type, name.c_str()));
 			goto parse_error;
 		}
 
@@ -482,24 +477,22 @@ parse_error:
 
 bool Ascii::CheckNumberError(const char* start, const char* end, bool nonneg_only) const
 	{
-	MsgThread* thread = GetThread();
-
 	if ( end == start && *end != '\0' )
 		{
-		thread->Warning(thread->Fmt("String '%s' contained no parseable number", start));
+		Warning(Fmt("String '%s' contained no parseable number", start));
 		return true;
 		}
 
 	if ( end - start == 0 && *end == '\0' )
 		{
-		thread->Warning("Got empty string for number field");
+		Warning("Got empty string for number field");
 		return true;
 		}
 
 	if ( (*end != '\0') )
-		thread->Warning(thread->Fmt("Number '%s' contained non-numeric trailing characters. "
-		                            "Ignored trailing characters '%s'",
-		                            start, end));
+		Warning(Fmt("Number '%s' contained non-numeric trailing characters. "
+		            "Ignored trailing characters '%s'",
+		            start, end));
 
 	if ( nonneg_only )
 		{
@@ -510,20 +503,20 @@ bool Ascii::CheckNumberError(const char* start, const char* end, bool nonneg_onl
 			s++;
 		if ( *s == '-' )
 			{
-			thread->Warning(thread->Fmt("Number '%s' cannot be negative", start));
+			Warning(Fmt("Number '%s' cannot be negative", start));
 			return true;
 			}
 		}
 
 	if ( errno == EINVAL )
 		{
-		thread->Warning(thread->Fmt("String '%s' could not be converted to a number", start));
+		Warning(Fmt("String '%s' could not be converted to a number", start));
 		return true;
 		}
 
 	else if ( errno == ERANGE )
 		{
-		thread->Warning(thread->Fmt("Number '%s' out of supported range.", start));
+		Warning(Fmt("Number '%s' out of supported range.", start));
 		return true;
 		}
 
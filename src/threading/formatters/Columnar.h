@@ -0,0 +1,228 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Encoding and decoding of Zeek's columnar binary log format.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "zeek/threading/SerialTypes.h"
+
+namespace zeek::threading::formatter
+	{
+
+/**
+ * The columnar log format stores records in blocks of a few thousand rows.
+ * Within a block, each field's values are stored together, and each column
+ * uses the encoding that suits its values best: strings of low cardinality
+ * (such as services, protocols, or HTTP methods) become a dictionary plus
+ * an index per row, and timestamps and counts are stored as deltas to the
+ * previous row. Blocks are then compressed with zlib. A file starts with a
+ * header describing its fields, so it can be read without any knowledge of
+ * the script-level record type.
+ *
+ * The layout is, with integers as LEB128 varints unless noted otherwise:
+ *
+ *     file   := "ZCOL" version:u8 meta field-count field* block*
+ *     meta   := count (key:string value:string)*
+ *     field  := name:string type subtype optional:u8
+ *     block  := 'B' raw-length stored-length compression:u8 bytes
+ *
+ * A block's raw (decompressed) bytes are its row count followed by each
+ * column in field order: a presence marker (all set, none set, or a bitmap
+ * of the set rows), an encoding marker, the length of the encoded data, and
+ * the encoded values of the rows that are set.
+ */
+class ColumnarFormat
+	{
+public:
+	static constexpr const char* MAGIC = "ZCOL";
+	static constexpr uint8_t VERSION = 1;
+
+	enum Compression : uint8_t
+		{
+		COMPRESSION_NONE = 0,
+		COMPRESSION_ZLIB = 1,
+		};
+
+	enum Presence : uint8_t
+		{
+		PRESENCE_ALL = 0,
+		PRESENCE_NONE = 1,
+		PRESENCE_BITMAP = 2,
+		};
+
+	enum Encoding : uint8_t
+		{
+		ENCODING_PLAIN = 0, // Values one after another.
+		ENCODING_DELTA = 1, // Integers as zigzag deltas to the previous value.
+		ENCODING_DELTA_MICROS = 2, // Doubles as deltas of whole microseconds.
+		ENCODING_DICT = 3, // Distinct strings, then an index per value.
+		ENCODING_BITMAP = 4, // Booleans packed into bits.
+		};
+
+	/**
+	 * Returns true if the format can store fields of the given type.
+	 */
+	static bool IsSupportedType(TypeTag type, TypeTag subtype);
+	};
+
+/**
+ * Buffers log records and turns them into blocks of the columnar format.
+ * Not thread-safe, but meant to be used by a single writer thread.
+ */
+class ColumnarEncoder
+	{
+public:
+	/**
+	 * Constructor.
+	 *
+	 * @param num_fields The number of fields of each record.
+	 *
+	 * @param fields The fields. Must remain valid while the encoder exists.
+	 *
+	 * @param compression_level The zlib compression level for blocks,
+	 * between 0 (uncompressed) and 9.
+	 */
+	ColumnarEncoder(int num_fields, const Field* const* fields, int compression_level);
+
+	/**
+	 * Returns the file header.
+	 *
+	 * @param meta Key/value pairs to record in the header.
+	 */
+	std::string Header(const std::vector<std::pair<std::string, std::string>>& meta) const;
+
+	/**
+	 * Adds a record to the current block. The values are copied, so they
+	 * need not outlive the call.
+	 *
+	 * @param vals The record's values, one per field.
+	 */
+	void Add(const Value* const* vals);
+
+	/**
+	 * Adds records to the current block, given a field at a time. The
+	 * values are copied, so they need not outlive the call.
+	 *
+	 * @param columns For each field, the values of the records, one
+	 * after the other.
+	 *
+	 * @param n The number of records.
+	 */
+	void AddColumns(const Value* const* columns, size_t n);
+
+	/**
+	 * Returns the number of records in the current block.
+	 */
+	size_t NumRows() const { return num_rows; }
+
+	/**
+	 * Encodes the records added since the last call into a block, ready
+	 * to append to the file, and starts a new block. Returns an empty
+	 * string if there are no such records.
+	 */
+	std::string Flush();
+
+private:
+	struct Column
+		{
+		const Field* field;
+		std::vector<uint8_t> present; // One per row.
+		std::vector<int64_t> ints; // Bools, ints, counts and ports.
+		std::vector<double> doubles;
+		std::unordered_map<std::string, uint32_t> dict; // Strings to indices.
+		std::vector<const std::string*> dict_order; // Indices to strings.
+		std::vector<uint32_t> indices; // The dictionary index of each string.
+		std::string raw; // Addresses, subnets, sets and vectors.
+		};
+
+	void AddValue(Column* c, const Value* v);
+	void EncodeColumn(const Column& c, std::string* out) const;
+
+	std::vector<Column> columns;
+	size_t num_rows = 0;
+	int compression_level;
+	};
+
+/**
+ * Parses files of the columnar format. Not thread-safe, but meant to be
+ * used by a single reader thread.
+ */
+class ColumnarDecoder
+	{
+public:
+	/**
+	 * A field as described in the file header.
+	 */
+	struct FieldInfo
+		{
+		std::string name;
+		TypeTag type;
+		TypeTag subtype;
+		bool optional;
+		};
+
+	enum Result
+		{
+		OK, // Parsed successfully.
+		INCOMPLETE, // Needs more data.
+		FAILED, // Invalid data; see Error().
+		};
+
+	/**
+	 * Parses the file header.
+	 *
+	 * @param data The beginning of the file.
+	 *
+	 * @param len The number of bytes available.
+	 *
+	 * @param consumed Set to the header's length on success.
+	 */
+	Result ReadHeader(const char* data, size_t len, size_t* consumed);
+
+	/**
+	 * Returns the fields of the file, once ReadHeader() succeeded.
+	 */
+	const std::vector<FieldInfo>& Fields() const { return fields; }
+
+	/**
+	 * Returns the key/value pairs of the file header.
+	 */
+	const std::vector<std::pair<std::string, std::string>>& Meta() const { return meta; }
+
+	/**
+	 * Parses the next block. Each of the block's rows becomes an array of
+	 * values allocated with new, which the caller takes ownership of.
+	 *
+	 * @param data The beginning of the block.
+	 *
+	 * @param len The number of bytes available.
+	 *
+	 * @param consumed Set to the block's length on success.
+	 *
+	 * @param wanted The file's column to use for each value of a row, or
+	 * -1 to leave a nullptr for the caller to fill in.
+	 *
+	 * @param rows The rows are appended here.
+	 */
+	Result ReadBlock(const char* data, size_t len, size_t* consumed,
+	                 const std::vector<int>& wanted, std::vector<Value**>* rows);
+
+	/**
+	 * Returns a description of the last failure.
+	 */
+	const std::string& Error() const { return error; }
+
+private:
+	std::vector<FieldInfo> fields;
+	std::vector<std::pair<std::string, std::string>> meta;
+	std::string buffer; // Decompressed block.
+	std::string error;
+	};
+
+	} // namespace zeek::threading::formatter
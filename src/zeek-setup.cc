@@ -23,6 +23,7 @@
 #define DOCTEST_CONFIG_IMPLEMENT
 
 #include "zeek/3rdparty/doctest.h"
+#include "zeek/AnalyzerAccounting.h"
 #include "zeek/Anon.h"
 #include "zeek/DFA.h"
 #include "zeek/DNS_Mgr.h"
@@ -220,6 +221,7 @@ zeek::OpaqueTypePtr bloomfilter_type;
 zeek::OpaqueTypePtr x509_opaque_type;
 zeek::OpaqueTypePtr ocsp_resp_opaque_type;
 zeek::OpaqueTypePtr paraglob_type;
+zeek::OpaqueTypePtr intel_store_type;
 zeek::OpaqueTypePtr int_counter_metric_type;
 zeek::OpaqueTypePtr int_counter_metric_family_type;
 zeek::OpaqueTypePtr dbl_counter_metric_type;
@@ -753,6 +755,7 @@ SetupResult setup(int argc, char** argv, Options* zopts)
 	x509_opaque_type = make_intrusive<OpaqueType>("x509");
 	ocsp_resp_opaque_type = make_intrusive<OpaqueType>("ocsp_resp");
 	paraglob_type = make_intrusive<OpaqueType>("paraglob");
+	intel_store_type = make_intrusive<OpaqueType>("intel_store");
 	int_counter_metric_type = make_intrusive<OpaqueType>("int_counter_metric");
 	int_counter_metric_family_type = make_intrusive<OpaqueType>("int_counter_metric_family");
 	dbl_counter_metric_type = make_intrusive<OpaqueType>("dbl_counter_metric");
@@ -766,6 +769,9 @@ SetupResult setup(int argc, char** argv, Options* zopts)
 	dbl_histogram_metric_type = make_intrusive<OpaqueType>("dbl_histogram_metric");
 	dbl_histogram_metric_family_type = make_intrusive<OpaqueType>("dbl_histogram_metric_family");
 
+	const FuncInfo* init_stmts = nullptr;
+	bool scripts_analyzed = false;
+
 	// The leak-checker tends to produce some false
 	// positives (memory which had already been
 	// allocated before we start the checking is
@@ -835,6 +841,44 @@ SetupResult setup(int argc, char** argv, Options* zopts)
 		if ( reporter->Errors() > 0 )
 			exit(1);
 
+		if ( Supervisor::ThisNode() && Supervisor::ThisNode()->is_template )
+			{
+			// A node template optimizes the scripts right away, then forks
+			// its nodes, which share all of that copy-on-write.  That has to
+			// happen before Broker or anything else starts threads.
+			//
+			// Script analysis only looks at the parsed scripts, so running it
+			// ahead of the InitPostScript() calls below is fine: plugins can
+			// only hook into script execution, not into its optimization.
+			// The one thing it does rely on is the reporter, whose options we
+			// load right away so that its diagnostics follow any redefs of
+			// Reporter::*_to_stderr as they would without the early pass.
+			// Loading them again further down does no harm.  Each node sets
+			// up its own IO event queue in iosource_mgr->InitPostScript(),
+			// i.e. after the fork.
+			reporter->InitOptions();
+			init_stmts = stmts ? analyze_global_stmts(stmts) : nullptr;
+			analyze_scripts(options.no_unused_warnings);
+			scripts_analyzed = true;
+
+			set_signal_mask(false);
+			Supervisor::RunNodeTemplate(&options);
+			set_signal_mask(true);
+			}
+
+		else if ( ! options.parse_only && parallel_analysis_requested() )
+			{
+			// Compiling in parallel forks processes, which likewise needs
+			// to happen before any threads start.  See above for why this
+			// may precede the InitPostScript() calls.
+			reporter->InitOptions();
+			init_stmts = stmts ? analyze_global_stmts(stmts) : nullptr;
+			analyze_scripts(options.no_unused_warnings);
+			scripts_analyzed = true;
+			}
+
+		analysis_options.threads_started = true;
+
 		telemetry_mgr->InitPostScript();
 		iosource_mgr->InitPostScript();
 		log_mgr->InitPostScript();
@@ -882,6 +926,7 @@ SetupResult setup(int argc, char** argv, Options* zopts)
 
 		packet_mgr->InitPostScript(options.unprocessed_output_file.value_or(""));
 		analyzer_mgr->InitPostScript();
+		zeek::detail::AnalyzerAccounting::InitPostScript();
 		file_mgr->InitPostScript();
 		dns_mgr->InitPostScript();
 		trigger_mgr->InitPostScript();
@@ -967,9 +1012,11 @@ SetupResult setup(int argc, char** argv, Options* zopts)
 			exit(reporter->Errors() != 0);
 			}
 
-		auto init_stmts = stmts ? analyze_global_stmts(stmts) : nullptr;
-
-		analyze_scripts(options.no_unused_warnings);
+		if ( ! scripts_analyzed )
+			{
+			init_stmts = stmts ? analyze_global_stmts(stmts) : nullptr;
+			analyze_scripts(options.no_unused_warnings);
+			}
 
 		if ( analysis_options.report_recursive )
 			{
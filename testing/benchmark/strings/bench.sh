@@ -0,0 +1,56 @@
+#! /usr/bin/env bash
+#
+# Measures the cost of string-heavy protocol analysis by running Zeek's
+# HTTP and DNS analyzers over a trace several times, reporting the median
+# user CPU time and maximum resident set size.  Compare two builds (e.g.,
+# before and after a change to zeek::String or StringVal) by setting
+# BASELINE to the other build's zeek binary.
+#
+# Usage: bench.sh <trace> [runs]
+#
+# Set ZEEK to use a zeek binary other than the one in PATH.
+
+set -e
+
+if [ $# -lt 1 ]; then
+    echo "usage: $(basename $0) <trace> [runs]" >&2
+    exit 1
+fi
+
+trace=$1
+runs=${2:-5}
+zeek=${ZEEK:-zeek}
+
+tmp=$(mktemp -d)
+trap "rm -rf $tmp" EXIT
+
+median() {
+    sort -n | awk '{ v[NR] = $1 } END { print v[int((NR + 1) / 2)] }'
+}
+
+run() {
+    local name=$1
+    local binary=$2
+
+    for i in $(seq $runs); do
+        (cd $tmp && /usr/bin/time -f "%U %M" -o time.out $binary -b -r $trace \
+            base/protocols/http base/protocols/dns >/dev/null 2>&1)
+        cat $tmp/time.out
+    done >$tmp/results
+
+    local cpu=$(cut -d ' ' -f 1 $tmp/results | median)
+    local rss=$(cut -d ' ' -f 2 $tmp/results | median)
+
+    printf "%-12s %ss %sKB\n" $name $cpu $rss
+}
+
+case $trace in
+    /*) ;;
+    *) trace=$(pwd)/$trace ;;
+esac
+
+if [ -n "$BASELINE" ]; then
+    run baseline $BASELINE
+fi
+
+run current $zeek
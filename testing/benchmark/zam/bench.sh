@@ -0,0 +1,50 @@
+#! /usr/bin/env bash
+#
+# Compares script execution time with and without ZAM by running a policy
+# script over a trace several times each way, reporting the median user CPU
+# time of every configuration.
+#
+# Usage: bench.sh <trace> [script] [runs]
+#
+# The script defaults to "local", which loads the standard set of policy
+# scripts.  Set ZEEK to use a zeek binary other than the one in PATH.  For a
+# per-instruction breakdown, run a --enable-debug build with ZEEK_PROFILE=1
+# set; the profile then also counts how often pairs of instructions execute
+# in succession, which identifies candidates for superinstructions.
+
+set -e
+
+if [ $# -lt 1 ]; then
+    echo "usage: $(basename $0) <trace> [script] [runs]" >&2
+    exit 1
+fi
+
+trace=$1
+script=${2:-local}
+runs=${3:-5}
+zeek=${ZEEK:-zeek}
+
+tmp=$(mktemp -d)
+trap "rm -rf $tmp" EXIT
+
+median() {
+    sort -n | awk '{ v[NR] = $1 } END { print v[int((NR + 1) / 2)] }'
+}
+
+run() {
+    local name=$1
+    shift
+
+    for i in $(seq $runs); do
+        (cd $tmp && /usr/bin/time -f "%U" -o time.out $zeek "$@" -r $trace $script >/dev/null 2>&1)
+        cat $tmp/time.out
+    done | median | xargs printf "%-12s %ss\n" $name
+}
+
+case $trace in
+    /*) ;;
+    *) trace=$(pwd)/$trace ;;
+esac
+
+run interpreted
+run ZAM -O ZAM
@@ -7,6 +7,7 @@
 #include <Func.h>
 #include <RunState.h>
 #include <threading/Formatter.h>
+#include <util.h>
 
 namespace btest::plugin::Log_Hooks
 	{
@@ -67,7 +68,15 @@ bool Plugin::HookLogWrite(const std::string& writer, const std::string& filter,
 	else if ( round == 2 )
 		vals[0]->val.int_val = 0;
 	else if ( round == 3 )
+		{
 		vals[1]->present = false;
 
+		// The logging framework takes over replaced values.
+		auto s = new zeek::threading::Value(zeek::TYPE_STRING);
+		s->val.string_val.data = zeek::util::copy_string("replaced");
+		s->val.string_val.length = 8;
+		vals[10] = s;
+		}
+
 	return true;
 	}